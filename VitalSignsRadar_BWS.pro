@@ -28,15 +28,60 @@ DEFINES += QCUSTOMPLOT_USE_OPENGL
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# The AVX/AVX2 kernels (qcustomplot.cpp, biquadfilterbank.cpp) are compiled per function with
+# target attributes and selected at runtime from cpuid, so no -mavx/-mavx2 (/arch:AVX2) flags are
+# needed and the binary still runs on SSE2-only CPUs.
+
+# Uncomment to compile the debug level log records (qDebug, qCDebug) out entirely.
+#DEFINES += QT_NO_DEBUG_OUTPUT
+
 
 SOURCES += main.cpp\
+    asynclog.cpp \
+    biquadfilterbank.cpp \
     dialogsettings.cpp \
+    heartratefusion.cpp \
+    hrvanalyzer.cpp \
+    latencyoverlay.cpp \
+    logcategories.cpp \
         mainwindow.cpp \
-    qcustomplot.cpp
+    minmaxpyramid.cpp \
+    motiondetector.cpp \
+    plotfeed.cpp \
+    qcustomplot.cpp \
+    rangetimemap.cpp \
+    readoutpanel.cpp \
+    renderscheduler.cpp \
+    reportexporter.cpp \
+    snapshotrenderer.cpp \
+    stageprofiler.cpp \
+    stripchart.cpp \
+    trendplottable.cpp \
+    vitalstracker.cpp \
+    windowextrema.cpp
 
 HEADERS  += mainwindow.h \
+    asynclog.h \
+    biquadfilterbank.h \
     dialogsettings.h \
-    qcustomplot.h
+    heartratefusion.h \
+    hrvanalyzer.h \
+    latencyoverlay.h \
+    logcategories.h \
+    minmaxpyramid.h \
+    motiondetector.h \
+    plotfeed.h \
+    qcustomplot.h \
+    rangetimemap.h \
+    readoutpanel.h \
+    renderscheduler.h \
+    reportexporter.h \
+    snapshotrenderer.h \
+    stageprofiler.h \
+    stripchart.h \
+    trendplottable.h \
+    vitalstracker.h \
+    windowextrema.h
 
 FORMS    += mainwindow.ui \
     dialogsettings.ui
@@ -0,0 +1,223 @@
+#include "asynclog.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <cstdio>
+#include <cstring>
+
+QAtomicPointer<AsyncLog> AsyncLog::sInstance;
+
+AsyncLog::AsyncLog(int capacity) :
+    mEnqueuePos(0),
+    mDequeuePos(0),
+    mDropped(0),
+    mDroppedReported(0),
+    mStartMSecs(QDateTime::currentMSecsSinceEpoch()),
+    mFormat(fmText),
+    mStopping(false),
+    mPreviousHandler(0)
+{
+    // a power of two, so the free-running indices wrap onto the slots with a mask
+    int size = 1;
+    while (size < capacity)
+        size *= 2;
+    mSlots = new Slot[size];
+    mMask = quint32(size - 1);
+    for (int i = 0; i < size; i++)
+        mSlots[i].sequence.store(quint32(i));
+    mClock.start();
+}
+
+AsyncLog::~AsyncLog()
+{
+    uninstall();
+    delete[] mSlots;
+}
+
+bool AsyncLog::open(const QString &fileName, Format format)
+{
+    QMutexLocker locker(&mDrainMutex);
+    if (mFile.isOpen())
+        mFile.close();
+    bool opened;
+    if (fileName.isEmpty())
+    {
+        mFormat = fmText;
+        opened = mFile.open(stderr, QIODevice::WriteOnly);
+    } else
+    {
+        mFormat = format;
+        mFile.setFileName(fileName);
+        opened = mFile.open(QIODevice::WriteOnly | (format == fmText ? QIODevice::Append | QIODevice::Text : QIODevice::Truncate));
+    }
+    if (opened && mFormat == fmBinary)
+    {
+        QDataStream stream(&mFile);
+        stream.writeRawData("VSRLOG01", 8);
+        stream << mStartMSecs;
+    }
+    return opened;
+}
+
+void AsyncLog::install()
+{
+    if (sInstance.load() == this)
+        return;
+    if (!mFile.isOpen())
+        open(QString(), fmText);
+    mStopping = false;
+    start(QThread::LowPriority);
+    sInstance.store(this);
+    mPreviousHandler = qInstallMessageHandler(messageHandler);
+}
+
+void AsyncLog::uninstall()
+{
+    if (sInstance.testAndSetOrdered(this, 0))
+        qInstallMessageHandler(mPreviousHandler);
+    stopWriter();
+    flush();    // records pushed while the handler was being swapped
+}
+
+void AsyncLog::flush()
+{
+    // tryLock: a fatal record or a crash handler may run on the writer thread while it holds the lock
+    if (!mDrainMutex.tryLock(LOG_FLUSH_TIMEOUT_MS))
+        return;
+    drain();
+    mDrainMutex.unlock();
+}
+
+void AsyncLog::stopWriter()
+{
+    if (!isRunning())
+        return;
+    mDrainMutex.lock();
+    mStopping = true;
+    mWake.wakeOne();
+    mDrainMutex.unlock();
+    wait();
+}
+
+void AsyncLog::run()
+{
+    QMutexLocker locker(&mDrainMutex);
+    while (!mStopping)
+    {
+        mWake.wait(&mDrainMutex, LOG_DRAIN_INTERVAL_MS);
+        drain();
+    }
+}
+
+void AsyncLog::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    AsyncLog *log = sInstance.load();
+    if (!log)
+        return;
+    log->push(type, context.category, message);
+    if (type == QtFatalMsg)
+        log->flush();   // Qt aborts as soon as the handler returns
+}
+
+bool AsyncLog::push(QtMsgType type, const char *category, const QString &message)
+{
+    // bounded multi-producer queue: a slot whose sequence equals the enqueue index is free to claim
+    Slot *slot;
+    quint32 pos = mEnqueuePos.load();
+    for (;;)
+    {
+        slot = &mSlots[pos & mMask];
+        qint32 diff = qint32(slot->sequence.loadAcquire() - pos);
+        if (diff == 0)
+        {
+            if (mEnqueuePos.testAndSetRelaxed(pos, pos + 1))
+                break;
+            pos = mEnqueuePos.load();
+        } else if (diff < 0)
+        {
+            mDropped.fetchAndAddRelaxed(1);     // the writer hasn't freed this slot yet: ring full
+            return false;
+        } else
+            pos = mEnqueuePos.load();           // another producer claimed it first
+    }
+
+    slot->type = quint8(type);
+    slot->time = mClock.nsecsElapsed();
+    slot->thread = quint64(quintptr(QThread::currentThreadId()));
+    if (!category)
+        category = "default";
+    int length = 0;
+    while (length < LOG_CATEGORY_CHARS && category[length])
+    {
+        slot->category[length] = category[length];
+        length++;
+    }
+    slot->categoryLength = quint8(length);
+    length = qMin(message.size(), LOG_MESSAGE_CHARS);
+    memcpy(slot->message, message.constData(), length*sizeof(QChar));
+    slot->messageLength = quint16(length);
+    slot->sequence.storeRelease(pos + 1);
+    return true;
+}
+
+void AsyncLog::drain()
+{
+    if (!mFile.isOpen())
+        return;
+    bool wrote = false;
+    for (;;)
+    {
+        Slot &slot = mSlots[mDequeuePos & mMask];
+        if (slot.sequence.loadAcquire() != mDequeuePos + 1)
+            break;      // empty, or the producer that claimed the next slot is still copying
+        writeRecord(slot);
+        slot.sequence.storeRelease(mDequeuePos + mMask + 1);
+        mDequeuePos++;
+        wrote = true;
+    }
+
+    quint32 dropped = mDropped.load();
+    if (dropped != mDroppedReported)
+    {
+        Slot note;
+        note.type = quint8(QtWarningMsg);
+        note.time = mClock.nsecsElapsed();
+        note.thread = quint64(quintptr(QThread::currentThreadId()));
+        note.categoryLength = quint8(qstrlen("radar.log"));
+        memcpy(note.category, "radar.log", note.categoryLength);
+        QString text = QString("%1 records dropped, log ring full").arg(dropped - mDroppedReported);
+        note.messageLength = quint16(qMin(text.size(), LOG_MESSAGE_CHARS));
+        memcpy(note.message, text.constData(), note.messageLength*sizeof(QChar));
+        writeRecord(note);
+        mDroppedReported = dropped;
+        wrote = true;
+    }
+    if (wrote)
+        mFile.flush();
+}
+
+void AsyncLog::writeRecord(const Slot &slot)
+{
+    QByteArray message = QString::fromRawData(slot.message, slot.messageLength).toUtf8();
+    if (mFormat == fmBinary)
+    {
+        QDataStream stream(&mFile);
+        stream << slot.time << slot.thread << slot.type << slot.categoryLength << quint16(message.size());
+        stream.writeRawData(slot.category, slot.categoryLength);
+        stream.writeRawData(message.constData(), message.size());
+        return;
+    }
+
+    static const char levels[] = "DWCFI";   // indexed by QtMsgType
+    QDateTime time = QDateTime::fromMSecsSinceEpoch(mStartMSecs + slot.time/1000000);
+    mBuffer = time.toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1();
+    mBuffer += ' ';
+    mBuffer += slot.type < quint8(sizeof(levels) - 1) ? levels[slot.type] : '?';
+    mBuffer += ' ';
+    mBuffer.append(slot.category, slot.categoryLength);
+    mBuffer += " [";
+    mBuffer += QByteArray::number(slot.thread, 16);
+    mBuffer += "] ";
+    mBuffer += message;
+    mBuffer += '\n';
+    mFile.write(mBuffer);
+}
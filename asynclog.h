@@ -0,0 +1,96 @@
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+// Qt message handler that takes log records off the calling thread.
+//
+// install() routes every qDebug/qCDebug/qWarning... record (the categories in logcategories.h, Qt's
+// and QCustomPlot's) into a ring of fixed-size slots allocated once by the constructor. Producers
+// claim a slot with a compare-and-swap on the enqueue index and copy the timestamp, level, thread,
+// category name and the first LOG_MESSAGE_CHARS UTF-16 characters of the message; they never lock,
+// allocate or block, and a full ring drops the record (droppedCount()). The AsyncLog thread wakes
+// every LOG_DRAIN_INTERVAL_MS, drains the ring and writes the records to the log file as text lines
+//     2026-10-19 14:03:07.123 D radar.frame [7f3a2c001700] Frame Number is: 1234
+// or in binary form: the magic "VSRLOG01" and the qint64 start time (ms since epoch), then per record
+// qint64 time (ns since start), quint64 thread, quint8 QtMsgType, quint8 category length, quint16
+// message length, the Latin-1 category name and the UTF-8 message, all numbers big-endian.
+//
+// Fatal records and flush() drain the ring synchronously, so nothing logged before a qFatal or a
+// crash handler's flush is lost.
+
+#define LOG_DEFAULT_CAPACITY    (4096)  // records
+#define LOG_CATEGORY_CHARS      (24)    // longer category names are truncated
+#define LOG_MESSAGE_CHARS       (232)   // longer messages are truncated
+#define LOG_DRAIN_INTERVAL_MS   (50)
+#define LOG_FLUSH_TIMEOUT_MS    (200)   // flush() gives up if the writer is stuck holding the file
+
+class AsyncLog : public QThread
+{
+public:
+    enum Format { fmText, fmBinary };
+
+    explicit AsyncLog(int capacity = LOG_DEFAULT_CAPACITY);
+    ~AsyncLog();
+
+    bool open(const QString &fileName, Format format);  // an empty file name writes text to stderr
+    void install();     // starts the writer thread and becomes the Qt message handler
+    void uninstall();   // restores the previous handler and writes what is left in the ring
+    void flush();
+
+    static AsyncLog *instance() { return sInstance.load(); }
+
+    int capacity() const { return int(mMask + 1); }
+    quint32 droppedCount() const { return mDropped.load(); }
+
+protected:
+    void run();
+
+private:
+    Q_DISABLE_COPY(AsyncLog)
+
+    struct Slot {
+        QAtomicInteger<quint32> sequence;   // slot index when free, index + 1 once written
+        quint8 type;
+        quint8 categoryLength;
+        quint16 messageLength;
+        qint64 time;
+        quint64 thread;
+        char category[LOG_CATEGORY_CHARS];
+        QChar message[LOG_MESSAGE_CHARS];
+    };
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+    bool push(QtMsgType type, const char *category, const QString &message);
+    void drain();
+    void writeRecord(const Slot &slot);
+    void stopWriter();
+
+    Slot *mSlots;
+    quint32 mMask;
+    QAtomicInteger<quint32> mEnqueuePos;
+    quint32 mDequeuePos;                // writer side, under mDrainMutex
+    QAtomicInteger<quint32> mDropped;
+    quint32 mDroppedReported;
+
+    QElapsedTimer mClock;
+    qint64 mStartMSecs;
+    QFile mFile;
+    Format mFormat;
+    QByteArray mBuffer;
+
+    QMutex mDrainMutex;
+    QWaitCondition mWake;
+    bool mStopping;
+    QtMessageHandler mPreviousHandler;
+
+    static QAtomicPointer<AsyncLog> sInstance;
+};
+
+#endif // ASYNCLOG_H
@@ -0,0 +1,124 @@
+#include "qcustomplot.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <random>
+
+// Times QCPGraph::getOptimizedLineData with the adaptive sampling in a single pass and split into
+// parallel chunks, on the same plot and data, and checks that both produce the same points.
+//
+// For every size the data is generated twice, as evenly spaced samples and as keys with gaps and
+// bursts, and sampled on a normal and on a reversed key axis. Each path runs the given number of
+// repetitions (default 20) after one warm-up call; the median and best times are reported. Use the
+// sizes from which the parallel path wins on the target machine to choose the graph's
+// setParallelSamplingThreshold.
+
+class BenchGraph : public QCPGraph
+{
+public:
+  BenchGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPGraph(keyAxis, valueAxis) {}
+  void sample(QVector<QCPGraphData> *lineData) const
+  {
+    lineData->resize(0);
+    getOptimizedLineData(lineData, mDataContainer->constBegin(), mDataContainer->constEnd());
+  }
+};
+
+static QVector<QCPGraphData> makeData(int count, bool bursts, std::mt19937 &rng)
+{
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  QVector<QCPGraphData> data(count);
+  double key = 0, value = 0;
+  for (int i=0; i<count; ++i)
+  {
+    if (bursts)
+    {
+      double u = uniform(rng);
+      key += u < 0.001 ? 500.0*uniform(rng) : (u < 0.1 ? 1e-3 : 1.0); // occasional gaps, dense bursts
+    } else
+      key += 1.0;
+    value += noise(rng);
+    data[i] = QCPGraphData(key, value);
+  }
+  return data;
+}
+
+static bool identical(const QVector<QCPGraphData> &a, const QVector<QCPGraphData> &b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (int i=0; i<a.size(); ++i)
+  {
+    if (a.at(i).key != b.at(i).key || a.at(i).value != b.at(i).value)
+      return false;
+  }
+  return true;
+}
+
+static void timeSampling(const BenchGraph *graph, int repetitions, QVector<QCPGraphData> *lineData, double *median, double *best)
+{
+  QVector<double> times;
+  QElapsedTimer timer;
+  graph->sample(lineData); // warm-up
+  for (int i=0; i<repetitions; ++i)
+  {
+    timer.start();
+    graph->sample(lineData);
+    times << timer.nsecsElapsed()/1e6;
+  }
+  std::sort(times.begin(), times.end());
+  *median = times.at(times.size()/2);
+  *best = times.first();
+}
+
+int main(int argc, char *argv[])
+{
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication app(argc, argv);
+  int repetitions = argc > 1 ? qMax(1, QString(argv[1]).toInt()) : 20;
+  QTextStream out(stdout);
+
+  QCustomPlot plot;
+  plot.resize(1600, 400);
+  plot.setViewport(plot.rect());
+  BenchGraph *graph = new BenchGraph(plot.xAxis, plot.yAxis);
+  plot.replot(); // lays out the axis rect, so coordinates map onto 1600 px
+
+  out << "ideal thread count " << QThread::idealThreadCount() << ", pool max " << QThreadPool::globalInstance()->maxThreadCount()
+      << ", " << repetitions << " repetitions, times in ms\n";
+  out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n").arg("points", 9).arg("data", -7).arg("axis", -8)
+         .arg("serial", 9).arg("parallel", 9).arg("best s", 9).arg("best p", 9).arg("speedup", 8) << "  output\n";
+
+  std::mt19937 rng(42);
+  const int sizes[] = { 100000, 250000, 500000, 1000000, 2000000, 4000000, 8000000 };
+  bool allIdentical = true;
+  for (int size : sizes)
+  {
+    for (int bursts=0; bursts<2; ++bursts)
+    {
+      graph->data()->set(makeData(size, bursts, rng), true);
+      graph->rescaleAxes();
+      for (int reversed=0; reversed<2; ++reversed)
+      {
+        plot.xAxis->setRangeReversed(reversed);
+        QVector<QCPGraphData> serial, parallel;
+        double serialMedian, serialBest, parallelMedian, parallelBest;
+        graph->setParallelSamplingThreshold(0);
+        timeSampling(graph, repetitions, &serial, &serialMedian, &serialBest);
+        graph->setParallelSamplingThreshold(1);
+        timeSampling(graph, repetitions, &parallel, &parallelMedian, &parallelBest);
+        bool same = identical(serial, parallel);
+        allIdentical = allIdentical && same;
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8").arg(size, 9).arg(bursts ? "bursts" : "even", -7).arg(reversed ? "reversed" : "normal", -8)
+               .arg(serialMedian, 9, 'f', 2).arg(parallelMedian, 9, 'f', 2).arg(serialBest, 9, 'f', 2).arg(parallelBest, 9, 'f', 2)
+               .arg(serialMedian/parallelMedian, 8, 'f', 2)
+            << "  " << (same ? "identical" : "DIFFERENT") << "\n";
+        out.flush();
+      }
+    }
+  }
+  return allIdentical ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Parallel vs serial adaptive line sampling benchmark
+# (QCPGraph::setParallelSamplingThreshold), not part of the application build.
+#
+#   qmake && make && ./parallelsampling [repetitions]
+#
+#-------------------------------------------------
+
+QT       += core gui widgets printsupport
+
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+TARGET = parallelsampling
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../qcustomplot.cpp
+
+HEADERS += ../../qcustomplot.h
@@ -0,0 +1,42 @@
+#include "stageprofiler.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// Measures the cost of the frame path probes: a bare clock read, a Lap::record (one clock read and
+// one histogram increment) and a scoped Probe (two clock reads and one increment). Each loop runs
+// the given number of iterations (default 10,000,000) and reports the mean time per call; the
+// loop overhead is included, so the figures are upper bounds.
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    qint64 iterations = argc > 1 ? qMax(1LL, QString(argv[1]).toLongLong()) : 10000000;
+    QTextStream out(stdout);
+    StageProfiler profiler;
+    QElapsedTimer timer;
+
+    volatile quint64 sink = 0;
+    timer.start();
+    for (qint64 i = 0; i < iterations; i++)
+        sink = sink + StageProfiler::now();
+    double clockNs = double(timer.nsecsElapsed())/iterations;
+
+    StageProfiler::Lap lap(&profiler);
+    timer.start();
+    for (qint64 i = 0; i < iterations; i++)
+        lap.record(StageProfiler::stDecode);
+    double lapNs = double(timer.nsecsElapsed())/iterations;
+
+    timer.start();
+    for (qint64 i = 0; i < iterations; i++)
+        StageProfiler::Probe probe(&profiler, StageProfiler::stFusion);
+    double probeNs = double(timer.nsecsElapsed())/iterations;
+
+    out << iterations << " iterations, ns per call\n"
+        << "clock read   " << QString::number(clockNs, 'f', 1) << "\n"
+        << "Lap::record  " << QString::number(lapNs, 'f', 1) << "\n"
+        << "Probe        " << QString::number(probeNs, 'f', 1) << "\n"
+        << "recorded     " << profiler.stats(StageProfiler::stDecode).count + profiler.stats(StageProfiler::stFusion).count << "\n";
+    return 0;
+}
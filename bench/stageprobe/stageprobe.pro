@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# StageProfiler probe cost benchmark, not part of the application build.
+#
+#   qmake && make && ./stageprobe [iterations]
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+TARGET = stageprobe
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../stageprofiler.cpp
+
+HEADERS += ../../stageprofiler.h
@@ -0,0 +1,213 @@
+#include "biquadfilterbank.h"
+#include <qmath.h>
+#include <cmath>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BIQUAD_USE_SSE
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// the AVX loop is compiled for AVX on its own and only runs if cpuid reports it, so the default
+// (SSE2) build uses it where available without requiring it
+#define BIQUAD_USE_AVX
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BIQUAD_TARGET_AVX
+#else
+#define BIQUAD_TARGET_AVX __attribute__((target("avx")))
+#endif
+#elif defined(BIQUAD_USE_SSE)
+#include <xmmintrin.h>
+#endif
+
+#ifdef BIQUAD_USE_AVX
+namespace {
+
+bool detectAvx()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    // AVX, and OSXSAVE with the OS saving the YMM registers
+    return (info[2] & (1 << 28)) && (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+bool hasAvx()
+{
+    static const bool avx = detectAvx();
+    return avx;
+}
+
+// Runs the sections over channels [0, n & ~7) of one frame, 8 channels per step; returns where it stopped
+BIQUAD_TARGET_AVX int processAvx(float *x, int n, int sectionCount, const float *b0, const float *b1, const float *b2,
+                                 const float *a1, const float *a2, float *z1, float *z2)
+{
+    int c = 0;
+    for (; c + 8 <= n; c += 8)
+    {
+        __m256 v = _mm256_loadu_ps(x + c);
+        for (int s = 0; s < sectionCount; s++)
+        {
+            const int i = s*n + c;
+            __m256 y = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(b0 + i), v), _mm256_loadu_ps(z1 + i));
+            __m256 s1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(b1 + i), v), _mm256_mul_ps(_mm256_loadu_ps(a1 + i), y)), _mm256_loadu_ps(z2 + i));
+            __m256 s2 = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(b2 + i), v), _mm256_mul_ps(_mm256_loadu_ps(a2 + i), y));
+            _mm256_storeu_ps(z1 + i, s1);
+            _mm256_storeu_ps(z2 + i, s2);
+            v = y;
+        }
+        _mm256_storeu_ps(x + c, v);
+    }
+    return c;
+}
+
+}
+#endif
+
+BiquadFilterBank::Coefficients BiquadFilterBank::identity()
+{
+    Coefficients c = { 1, 0, 0, 0, 0 };
+    return c;
+}
+
+BiquadFilterBank::Coefficients BiquadFilterBank::bandPass(double lowHz, double highHz, double sampleRateHz)
+{
+    // constant 0 dB peak gain band-pass centred on the geometric mean of the band edges
+    double centerHz = std::sqrt(lowHz*highHz);
+    double q = centerHz/(highHz - lowHz);
+    double w0 = 2*M_PI*centerHz/sampleRateHz;
+    double alpha = std::sin(w0)/(2*q);
+    double a0 = 1 + alpha;
+    Coefficients c = { float(alpha/a0), 0, float(-alpha/a0), float(-2*std::cos(w0)/a0), float((1 - alpha)/a0) };
+    return c;
+}
+
+BiquadFilterBank::Coefficients BiquadFilterBank::lowPass(double cornerHz, double q, double sampleRateHz)
+{
+    double w0 = 2*M_PI*cornerHz/sampleRateHz;
+    double alpha = std::sin(w0)/(2*q);
+    double cosw0 = std::cos(w0);
+    double a0 = 1 + alpha;
+    Coefficients c = { float((1 - cosw0)/2/a0), float((1 - cosw0)/a0), float((1 - cosw0)/2/a0),
+                       float(-2*cosw0/a0), float((1 - alpha)/a0) };
+    return c;
+}
+
+BiquadFilterBank::Coefficients BiquadFilterBank::notch(double centerHz, double q, double sampleRateHz)
+{
+    double w0 = 2*M_PI*centerHz/sampleRateHz;
+    double alpha = std::sin(w0)/(2*q);
+    double cosw0 = std::cos(w0);
+    double a0 = 1 + alpha;
+    Coefficients c = { float(1/a0), float(-2*cosw0/a0), float(1/a0), float(-2*cosw0/a0), float((1 - alpha)/a0) };
+    return c;
+}
+
+BiquadFilterBank::Coefficients BiquadFilterBank::dcBlock(double cornerHz, double sampleRateHz)
+{
+    // first-order y[n] = x[n] - x[n-1] + R*y[n-1] written as a biquad
+    double r = 1 - 2*M_PI*cornerHz/sampleRateHz;
+    Coefficients c = { 1, -1, 0, float(-r), 0 };
+    return c;
+}
+
+BiquadFilterBank::BiquadFilterBank(int channelCount, int sectionCount) :
+    mChannelCount(0),
+    mSectionCount(0)
+{
+    configure(channelCount, sectionCount);
+}
+
+void BiquadFilterBank::configure(int channelCount, int sectionCount)
+{
+    mChannelCount = channelCount;
+    mSectionCount = sectionCount;
+    const int size = channelCount*sectionCount;
+    mB0.fill(1, size);
+    mB1.fill(0, size);
+    mB2.fill(0, size);
+    mA1.fill(0, size);
+    mA2.fill(0, size);
+    mZ1.fill(0, size);
+    mZ2.fill(0, size);
+}
+
+void BiquadFilterBank::setSection(int section, const Coefficients &coefficients)
+{
+    for (int channel = 0; channel < mChannelCount; channel++)
+        setSection(section, channel, coefficients);
+}
+
+void BiquadFilterBank::setSection(int section, int channel, const Coefficients &coefficients)
+{
+    const int index = section*mChannelCount + channel;
+    mB0[index] = coefficients.b0;
+    mB1[index] = coefficients.b1;
+    mB2[index] = coefficients.b2;
+    mA1[index] = coefficients.a1;
+    mA2[index] = coefficients.a2;
+}
+
+void BiquadFilterBank::reset()
+{
+    mZ1.fill(0);
+    mZ2.fill(0);
+}
+
+void BiquadFilterBank::process(float *interleaved, int frames)
+{
+    const int n = mChannelCount;
+    const float *b0 = mB0.constData();
+    const float *b1 = mB1.constData();
+    const float *b2 = mB2.constData();
+    const float *a1 = mA1.constData();
+    const float *a2 = mA2.constData();
+    float *z1 = mZ1.data();
+    float *z2 = mZ2.data();
+#ifdef BIQUAD_USE_AVX
+    const bool avx = hasAvx();
+#endif
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        float *x = interleaved + frame*n;
+        int c = 0;
+#ifdef BIQUAD_USE_AVX
+        if (avx)
+            c = processAvx(x, n, mSectionCount, b0, b1, b2, a1, a2, z1, z2);
+#endif
+#ifdef BIQUAD_USE_SSE
+        for (; c + 4 <= n; c += 4)
+        {
+            __m128 v = _mm_loadu_ps(x + c);
+            for (int s = 0; s < mSectionCount; s++)
+            {
+                const int i = s*n + c;
+                __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(b0 + i), v), _mm_loadu_ps(z1 + i));
+                __m128 s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(b1 + i), v), _mm_mul_ps(_mm_loadu_ps(a1 + i), y)), _mm_loadu_ps(z2 + i));
+                __m128 s2 = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(b2 + i), v), _mm_mul_ps(_mm_loadu_ps(a2 + i), y));
+                _mm_storeu_ps(z1 + i, s1);
+                _mm_storeu_ps(z2 + i, s2);
+                v = y;
+            }
+            _mm_storeu_ps(x + c, v);
+        }
+#endif
+        for (; c < n; c++)
+        {
+            float v = x[c];
+            for (int s = 0; s < mSectionCount; s++)
+            {
+                const int i = s*n + c;
+                float y = b0[i]*v + z1[i];
+                z1[i] = b1[i]*v - a1[i]*y + z2[i];
+                z2[i] = b2[i]*v - a2[i]*y;
+                v = y;
+            }
+            x[c] = v;
+        }
+    }
+}
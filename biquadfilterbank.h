@@ -0,0 +1,48 @@
+#ifndef BIQUADFILTERBANK_H
+#define BIQUADFILTERBANK_H
+
+#include <QVector>
+
+// Cascaded biquad sections applied to many channels at once.
+//
+// Samples are channel-interleaved (sample c of frame f is at [f*channelCount() + c]), so one
+// frame is a contiguous vector across channels and each section is evaluated for 8 (AVX, when
+// the CPU has it) or 4 (SSE) channels per instruction, with a scalar tail performing the same
+// operations in the same order (results match unless the compiler contracts the scalar code into
+// fused multiply-adds). Every channel has its own state and may have its own coefficients; all channels
+// share the number of sections. Sections are in transposed direct form II:
+//
+//   y = b0*x + z1;   z1 = b1*x - a1*y + z2;   z2 = b2*x - a2*y
+
+class BiquadFilterBank
+{
+public:
+    struct Coefficients {
+        float b0, b1, b2, a1, a2;   // a0 normalized to 1
+    };
+
+    static Coefficients identity();
+    static Coefficients bandPass(double lowHz, double highHz, double sampleRateHz);
+    static Coefficients lowPass(double cornerHz, double q, double sampleRateHz);
+    static Coefficients notch(double centerHz, double q, double sampleRateHz);
+    static Coefficients dcBlock(double cornerHz, double sampleRateHz);
+
+    explicit BiquadFilterBank(int channelCount = 0, int sectionCount = 0);
+
+    void configure(int channelCount, int sectionCount);
+    int channelCount() const { return mChannelCount; }
+    int sectionCount() const { return mSectionCount; }
+
+    void setSection(int section, const Coefficients &coefficients);                  // all channels
+    void setSection(int section, int channel, const Coefficients &coefficients);
+    void reset();
+
+    void process(float *interleaved, int frames);
+
+private:
+    int mChannelCount, mSectionCount;
+    QVector<float> mB0, mB1, mB2, mA1, mA2;     // [section*mChannelCount + channel]
+    QVector<float> mZ1, mZ2;
+};
+
+#endif // BIQUADFILTERBANK_H
@@ -0,0 +1,477 @@
+#include "heartratefusion.h"
+#include <QFile>
+#include <QRegExp>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+const char *inputNames[HeartRateFusion::inputCount] = {
+    "hr_fft", "hr_peak", "hr_xcorr", "hr_fft4hz",
+    "cm_heart", "cm_heart4hz", "cm_xcorr",
+    "br_fft", "use_xcorr", "use_fft"
+};
+
+// Symbol tables used while compiling a graph. Registers are created on first definition;
+// numeric literals get an anonymous constant register of their own.
+struct PlanBuilder
+{
+    QStringList names;
+    QVector<float> registers;
+    QStringList windowNames;
+    QString error;
+
+    int reference(const QString &token)
+    {
+        bool ok;
+        float literal = token.toFloat(&ok);
+        if (ok)
+        {
+            names.append(QString());
+            registers.append(literal);
+            return registers.size() - 1;
+        }
+        int index = names.indexOf(token);
+        if (index < 0)
+            error = QString("unknown register '%1'").arg(token);
+        return index;
+    }
+
+    int define(const QString &token)
+    {
+        bool isNumber;
+        token.toFloat(&isNumber);
+        if (isNumber || token.isEmpty())
+        {
+            error = QString("'%1' is not a valid register name").arg(token);
+            return -1;
+        }
+        int index = names.indexOf(token);
+        if (index >= 0 && index < HeartRateFusion::inputCount)
+        {
+            error = QString("input '%1' cannot be written").arg(token);
+            return -1;
+        }
+        if (index >= 0)
+            return index;
+        names.append(token);
+        registers.append(0);
+        return registers.size() - 1;
+    }
+
+    int window(const QString &token)
+    {
+        int index = windowNames.indexOf(token);
+        if (index < 0)
+            error = QString("unknown window '%1'").arg(token);
+        return index;
+    }
+};
+
+} // namespace
+
+HeartRateFusion::HeartRateFusion() :
+    mTrackerMode(VitalsTracker::tmOff),
+    mOutput(0)
+{
+    compile(defaultFrontGraph());
+}
+
+bool HeartRateFusion::test(Compare compare, float x, float threshold)
+{
+    switch (compare)
+    {
+    case cmpLess:         return x < threshold;
+    case cmpLessEqual:    return x <= threshold;
+    case cmpGreater:      return x > threshold;
+    case cmpGreaterEqual: return x >= threshold;
+    case cmpAlways:       break;
+    }
+    return true;
+}
+
+bool HeartRateFusion::compile(const QStringList &lines, QString *errorString)
+{
+    PlanBuilder builder;
+    for (int i = 0; i < inputCount; i++)
+    {
+        builder.names.append(QString(inputNames[i]));
+        builder.registers.append(0);
+    }
+
+    QVector<int> operands;
+    QVector<Op> ops;
+    QVector<MedianWindow> windows;
+    QVector<VitalsTracker> trackers;
+    int maxTrackerInputs = 0;
+    int output = -1;
+
+    for (int lineIndex = 0; lineIndex < lines.size() && builder.error.isEmpty(); lineIndex++)
+    {
+        QString line = lines.at(lineIndex).trimmed();
+        if (line.isEmpty() || line.startsWith('%') || line.startsWith('#'))
+            continue;
+
+        QStringList listArgs = line.split(QRegExp("\\s+"));
+        const QString node = listArgs.at(0).toLower();
+        const int numArgs = listArgs.size() - 1;
+
+        bool isOp = true;
+        Op op;
+        op.compare = cmpAlways;
+        op.out = -1;
+        std::fill(op.arg, op.arg + 5, -1);
+
+        // comparison tokens are shared by gate and push
+        auto parseCompare = [&](const QString &token) -> Compare {
+            const QString name = token.toLower();
+            if (name == "lt") return cmpLess;
+            if (name == "le") return cmpLessEqual;
+            if (name == "gt") return cmpGreater;
+            if (name == "ge") return cmpGreaterEqual;
+            builder.error = QString("unknown comparison '%1'").arg(token);
+            return cmpAlways;
+        };
+
+        if (node == "affine" && numArgs == 4)
+        {
+            op.code = opAffine;
+            op.arg[0] = builder.reference(listArgs.at(2));
+            op.arg[1] = builder.reference(listArgs.at(3));
+            op.arg[2] = builder.reference(listArgs.at(4));
+            op.out = builder.define(listArgs.at(1));
+        }
+        else if (node == "absdiff" && numArgs == 3)
+        {
+            op.code = opAbsDiff;
+            op.arg[0] = builder.reference(listArgs.at(2));
+            op.arg[1] = builder.reference(listArgs.at(3));
+            op.out = builder.define(listArgs.at(1));
+        }
+        else if (node == "ema" && numArgs == 3)
+        {
+            op.code = opEma;
+            op.arg[0] = builder.reference(listArgs.at(2));
+            op.arg[1] = builder.reference(listArgs.at(3));
+            op.out = builder.define(listArgs.at(1));
+        }
+        else if (node == "gate" && numArgs == 6)
+        {
+            op.code = opGate;
+            op.arg[0] = builder.reference(listArgs.at(2));
+            op.compare = parseCompare(listArgs.at(3));
+            op.arg[1] = builder.reference(listArgs.at(4));
+            op.arg[2] = builder.reference(listArgs.at(5));
+            op.arg[3] = builder.reference(listArgs.at(6));
+            op.out = builder.define(listArgs.at(1));
+        }
+        else if ((node == "blend" || node == "sum") && numArgs >= 3 && (numArgs % 2) == 1)
+        {
+            op.code = (node == "blend") ? opBlend : opSum;
+            op.arg[0] = operands.size();
+            op.arg[1] = (numArgs - 1) / 2;
+            for (int argIndex = 2; argIndex <= numArgs; argIndex++)
+                operands.append(builder.reference(listArgs.at(argIndex)));
+            op.out = builder.define(listArgs.at(1));
+        }
+        else if (node == "window" && numArgs == 2)
+        {
+            isOp = false;
+            int size = listArgs.at(2).toInt();
+            if (size <= 0 || builder.windowNames.contains(listArgs.at(1)))
+            {
+                builder.error = QString("invalid window '%1'").arg(listArgs.at(1));
+            }
+            else
+            {
+                MedianWindow window;
+                window.samples.fill(0, size);
+                window.scratch.resize(size);
+                window.next = 0;
+                window.pushed = false;
+                windows.append(window);
+                builder.windowNames.append(listArgs.at(1));
+            }
+        }
+        else if (node == "push" && (numArgs == 2 || numArgs == 5))
+        {
+            op.code = opPush;
+            op.out = builder.window(listArgs.at(1));
+            op.arg[0] = builder.reference(listArgs.at(2));
+            if (numArgs == 5)
+            {
+                op.arg[1] = builder.reference(listArgs.at(3));
+                op.compare = parseCompare(listArgs.at(4));
+                op.arg[2] = builder.reference(listArgs.at(5));
+            }
+        }
+        else if (node == "pushelse" && numArgs == 2)
+        {
+            op.code = opPushElse;
+            op.out = builder.window(listArgs.at(1));
+            op.arg[0] = builder.reference(listArgs.at(2));
+        }
+        else if (node == "median" && numArgs == 2)
+        {
+            op.code = opMedian;
+            op.arg[0] = builder.window(listArgs.at(2));
+            op.out = builder.define(listArgs.at(1));
+        }
+        else if (node == "kalman" && (numArgs == 3 || numArgs == 4))
+        {
+            op.code = opKalman;
+            op.arg[0] = builder.reference(listArgs.at(2));
+            op.arg[1] = builder.reference(listArgs.at(3));
+            op.arg[2] = builder.reference(numArgs == 4 ? listArgs.at(4) : QString("1e-6"));
+            op.arg[3] = trackers.size();
+            op.out = builder.define(listArgs.at(1));
+            VitalsTracker tracker;
+            tracker.setMode(VitalsTracker::tmScalar);
+            trackers.append(tracker);
+        }
+        else if (node == "track" && numArgs >= 3 && (numArgs % 2) == 1)
+        {
+            op.code = opTrack;
+            op.arg[0] = operands.size();
+            op.arg[1] = (numArgs - 1) / 2;
+            op.arg[2] = trackers.size();
+            for (int argIndex = 2; argIndex <= numArgs; argIndex++)
+                operands.append(builder.reference(listArgs.at(argIndex)));
+            op.out = builder.define(listArgs.at(1));
+            VitalsTracker tracker;
+            tracker.setMode(mTrackerMode);
+            trackers.append(tracker);
+            maxTrackerInputs = qMax(maxTrackerInputs, op.arg[1]);
+        }
+        else if (node == "output" && numArgs == 1)
+        {
+            isOp = false;
+            output = builder.reference(listArgs.at(1));
+        }
+        else
+        {
+            builder.error = QString("malformed node '%1'").arg(line);
+        }
+
+        if (!builder.error.isEmpty())
+            builder.error = QString("line %1: %2").arg(lineIndex + 1).arg(builder.error);
+        else if (isOp)
+            ops.append(op);
+    }
+
+    if (builder.error.isEmpty() && output < 0)
+        builder.error = "graph has no output";
+
+    if (!builder.error.isEmpty())
+    {
+        if (errorString)
+            *errorString = builder.error;
+        return false;
+    }
+
+    mInitialRegisters = builder.registers;
+    mOperands = operands;
+    mOps = ops;
+    mWindows = windows;
+    mTrackers = trackers;
+    mTrackerInput.resize(2*maxTrackerInputs);
+    mOutput = output;
+    reset();
+    return true;
+}
+
+bool HeartRateFusion::loadFile(const QString &fileName, QString *errorString)
+{
+    QFile infile(fileName);
+    if (!infile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        if (errorString)
+            *errorString = infile.errorString();
+        return false;
+    }
+
+    QStringList lines;
+    QTextStream inStream(&infile);
+    while (!inStream.atEnd())
+        lines.append(inStream.readLine());
+    return compile(lines, errorString);
+}
+
+void HeartRateFusion::reset()
+{
+    mRegisters = mInitialRegisters;
+    for (int i = 0; i < mWindows.size(); i++)
+    {
+        mWindows[i].samples.fill(0);
+        mWindows[i].next = 0;
+    }
+    for (int i = 0; i < mTrackers.size(); i++)
+        mTrackers[i].reset();
+}
+
+void HeartRateFusion::setTrackerMode(VitalsTracker::Mode mode)
+{
+    mTrackerMode = mode;
+    for (int i = 0; i < mOps.size(); i++)
+    {
+        if (mOps.at(i).code == opTrack)
+            mTrackers[mOps.at(i).arg[2]].setMode(mode);
+    }
+}
+
+float HeartRateFusion::evaluate(bool hold)
+{
+    float *r = mRegisters.data();
+    const int *operands = mOperands.constData();
+    MedianWindow *windows = mWindows.data();
+    VitalsTracker *trackers = mTrackers.data();
+    float *trackerRates = mTrackerInput.data();
+    float *trackerConfidences = trackerRates + mTrackerInput.size()/2;
+
+    for (int i = 0; i < mWindows.size(); i++)
+        windows[i].pushed = false;
+
+    const Op *op = mOps.constData();
+    const Op *opEnd = op + mOps.size();
+    for (; op != opEnd; ++op)
+    {
+        switch (op->code)
+        {
+        case opAffine:
+            r[op->out] = r[op->arg[0]]*r[op->arg[1]] + r[op->arg[2]];
+            break;
+        case opAbsDiff:
+            r[op->out] = qAbs(r[op->arg[0]] - r[op->arg[1]]);
+            break;
+        case opEma:
+            if (hold)
+                break;
+            r[op->out] = r[op->arg[1]]*r[op->arg[0]] + (1 - r[op->arg[1]])*r[op->out];
+            break;
+        case opGate:
+            r[op->out] = test(op->compare, r[op->arg[0]], r[op->arg[1]]) ? r[op->arg[2]] : r[op->arg[3]];
+            break;
+        case opBlend:
+        case opSum:
+        {
+            const int *pair = operands + op->arg[0];
+            float weightedSum = 0, weightSum = 0;
+            for (int i = 0; i < op->arg[1]; i++, pair += 2)
+            {
+                weightedSum += r[pair[0]]*r[pair[1]];
+                weightSum += r[pair[1]];
+            }
+            if (op->code == opBlend)
+                r[op->out] = (weightSum != 0) ? weightedSum/weightSum : 0;
+            else
+                r[op->out] = weightedSum;
+            break;
+        }
+        case opPush:
+        case opPushElse:
+        {
+            MedianWindow &window = windows[op->out];
+            if (hold || (op->code == opPushElse && window.pushed))
+                break;
+            if (op->compare != cmpAlways && !test(op->compare, r[op->arg[1]], r[op->arg[2]]))
+                break;
+            window.samples[window.next] = r[op->arg[0]];
+            window.next = (window.next + 1) % window.samples.size();
+            window.pushed = true;
+            break;
+        }
+        case opMedian:
+        {
+            MedianWindow &window = windows[op->arg[0]];
+            std::copy(window.samples.constBegin(), window.samples.constEnd(), window.scratch.begin());
+            float *middle = window.scratch.begin() + window.scratch.size()/2;
+            std::nth_element(window.scratch.begin(), middle, window.scratch.end());
+            r[op->out] = *middle;
+            break;
+        }
+        case opKalman:
+        {
+            if (hold)
+                break;
+            VitalsTracker &tracker = trackers[op->arg[3]];
+            tracker.setProcessNoise(r[op->arg[2]], 0);
+            r[op->out] = tracker.update(&r[op->arg[0]], &r[op->arg[1]], 1);
+            break;
+        }
+        case opTrack:
+        {
+            if (hold)
+                break;
+            const int *pair = operands + op->arg[0];
+            for (int i = 0; i < op->arg[1]; i++, pair += 2)
+            {
+                trackerRates[i] = r[pair[0]];
+                trackerConfidences[i] = r[pair[1]];
+            }
+            r[op->out] = trackers[op->arg[2]].update(trackerRates, trackerConfidences, op->arg[1]);
+            break;
+        }
+        }
+    }
+    return r[mOutput];
+}
+
+namespace {
+
+// Output stage shared by the default graphs, after the median history "med" and the smoothed heart
+// confidence "cm_avg"
+QStringList trackerStage()
+{
+    return QStringList()
+        << "% With the tracker off the median passes through. With it on, the median, weighted by the"
+        << "% smoothed confidence, and the three estimators with their own confidences are fused in one"
+        << "% update. A forced estimator (use_fft over use_xcorr) is then the only one with weight; the"
+        << "% 0.01 floor keeps it ahead of the tracker's epsilon weight of the others"
+        << "affine   cm_xc   cm_xcorr    10 0"
+        << "affine   cm_fftf cm_heart    1 0.01"
+        << "affine   cm_xcf  cm_xc       1 0.01"
+        << "gate     w_med   use_xcorr   gt 0.5  0        cm_avg"
+        << "gate     w_med   use_fft     gt 0.5  0        w_med"
+        << "gate     w_fft4  use_xcorr   gt 0.5  0        cm_heart4hz"
+        << "gate     w_fft4  use_fft     gt 0.5  0        w_fft4"
+        << "gate     w_fft   use_xcorr   gt 0.5  0        cm_heart"
+        << "gate     w_fft   use_fft     gt 0.5  cm_fftf  w_fft"
+        << "gate     w_xc    use_xcorr   gt 0.5  cm_xcf   cm_xc"
+        << "gate     w_xc    use_fft     gt 0.5  0        w_xc"
+        << "track    out     med w_med  hr_fft w_fft  hr_fft4hz w_fft4  hr_xcorr w_xc"
+        << "output   out";
+}
+
+} // namespace
+
+QStringList HeartRateFusion::defaultFrontGraph()
+{
+    return QStringList()
+        << "% Front mounting: FFT estimate unless its confidence is low and it disagrees with the peak count"
+        << "ema      cm_avg  cm_heart  0.2"
+        << "absdiff  fft_pk  hr_fft    hr_peak"
+        << "gate     est     fft_pk    lt 20    hr_fft    hr_peak"
+        << "gate     est     cm_avg    gt 0.25  hr_fft    est"
+        << "gate     est     use_xcorr gt 0.5   hr_xcorr  est"
+        << "gate     est     use_fft   gt 0.5   hr_fft    est"
+        << "window   hist    200"
+        << "push     hist    est"
+        << "median   med     hist"
+        << trackerStage();
+}
+
+QStringList HeartRateFusion::defaultBackGraph()
+{
+    return QStringList()
+        << "% Back mounting: every estimator that passes its check feeds the median history"
+        << "affine   br_x2   br_fft    2 0"
+        << "absdiff  xc_br   hr_xcorr  br_x2"
+        << "window   hist    200"
+        << "push     hist    hr_xcorr  xc_br       gt 4"
+        << "push     hist    hr_fft    cm_heart    gt 0.20"
+        << "push     hist    hr_fft4hz cm_heart4hz gt 0.15"
+        << "pushelse hist    hr_peak"
+        << "median   med     hist"
+        << "ema      cm_avg  cm_heart  0.2"
+        << trackerStage();
+}
@@ -0,0 +1,98 @@
+#ifndef HEARTRATEFUSION_H
+#define HEARTRATEFUSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "vitalstracker.h"
+
+// Heart-rate estimator fusion graph.
+//
+// The graph is described in a small text format (one node per line, '%' or '#' start a comment)
+// and compiled once into a flat list of operations over a register file. evaluate() walks that
+// list with a switch, so the per-frame path has no virtual calls and no allocations.
+//
+//   affine   <out> <in> <gain> <offset>          out = in*gain + offset
+//   absdiff  <out> <a> <b>                       out = |a - b|
+//   ema      <out> <in> <alpha>                  out = alpha*in + (1-alpha)*out
+//   gate     <out> <x> <lt|le|gt|ge> <t> <a> <b> out = (x op t) ? a : b
+//   blend    <out> <v1> <w1> [<v2> <w2> ...]     out = sum(v*w) / sum(w)
+//   sum      <out> <v1> <w1> [<v2> <w2> ...]     out = sum(v*w)
+//   window   <name> <size>                       declares a median history of <size> samples
+//   push     <window> <v> [<x> <op> <t>]         appends v (only if x op t holds)
+//   pushelse <window> <v>                        appends v if nothing was pushed this frame
+//   median   <out> <window>                      out = median of the window
+//   kalman   <out> <in> <confidence> [<q>]       scalar Kalman filter, R = 1/(confidence + 1e-4)
+//   track    <out> <v1> <c1> [<v2> <c2> ...]     VitalsTracker fed with confidence-weighted
+//                                                estimates, in the mode set by setTrackerMode()
+//   output   <reg>                               value returned by evaluate()
+//
+// Operands are register names or numeric literals. The inputs listed in Input are predefined
+// registers named hr_fft, hr_peak, hr_xcorr, hr_fft4hz, cm_heart, cm_heart4hz, cm_xcorr, br_fft,
+// use_xcorr and use_fft. Registers keep their value from one frame to the next.
+//
+// evaluate(true) holds the graph during motion artifacts: nothing is pushed into the median
+// windows and ema/kalman/track nodes keep their previous output.
+
+class HeartRateFusion
+{
+public:
+    enum Input { inHeartRateFFT
+                ,inHeartRatePeak
+                ,inHeartRateXCorr
+                ,inHeartRateFFT4Hz
+                ,inHeartRateCM
+                ,inHeartRate4HzCM
+                ,inHeartRateXCorrCM
+                ,inBreathingRateFFT
+                ,inUseXCorr
+                ,inUseFFT
+                ,inputCount
+               };
+
+    HeartRateFusion();
+
+    bool compile(const QStringList &lines, QString *errorString = 0);
+    bool loadFile(const QString &fileName, QString *errorString = 0);
+    void reset();
+    void setTrackerMode(VitalsTracker::Mode mode);
+    VitalsTracker::Mode trackerMode() const { return mTrackerMode; }
+
+    void setInput(Input input, float value) { mRegisters[input] = value; }
+    float evaluate(bool hold = false);
+    float output() const { return mRegisters.at(mOutput); }
+
+    static QStringList defaultFrontGraph();
+    static QStringList defaultBackGraph();
+
+private:
+    enum OpCode { opAffine, opAbsDiff, opEma, opGate, opBlend, opSum, opPush, opPushElse, opMedian, opKalman, opTrack };
+    enum Compare { cmpAlways, cmpLess, cmpLessEqual, cmpGreater, cmpGreaterEqual };
+
+    struct Op {
+        OpCode code;
+        Compare compare;
+        int out;        // destination register, or window index for push/pushelse
+        int arg[5];
+    };
+
+    struct MedianWindow {
+        QVector<float> samples;
+        QVector<float> scratch;
+        int next;
+        bool pushed;
+    };
+
+    static bool test(Compare compare, float x, float threshold);
+
+    QVector<float> mRegisters, mInitialRegisters;
+    QVector<int> mOperands;
+    QVector<Op> mOps;
+    QVector<MedianWindow> mWindows;
+    QVector<VitalsTracker> mTrackers;
+    QVector<float> mTrackerInput;
+    VitalsTracker::Mode mTrackerMode;
+    int mOutput;
+};
+
+#endif // HEARTRATEFUSION_H
@@ -0,0 +1,242 @@
+#include "hrvanalyzer.h"
+#include <qmath.h>
+#include <cmath>
+
+#define HRV_INTERVAL_CAPACITY     (512)     // ~5 min at 100 bpm
+#define HRV_TACHOGRAM_RATE_HZ     (4.0)
+#define HRV_MIN_INTERVAL_S        (0.33)    // 180 bpm, also the refractory period
+#define HRV_MAX_INTERVAL_S        (2.0)     // 30 bpm
+#define HRV_MAX_INTERVAL_CHANGE   (0.3)     // reject intervals deviating more than 30% from the mean
+#define HRV_LEVEL_ALPHA           (0.125f)
+#define HRV_THRESHOLD_FRACTION    (0.3f)
+
+HrvAnalyzer::HrvAnalyzer() :
+    mSampleRate(20.0f),
+    mWindowSeconds(60.0f)
+{
+    mIntervals.resize(HRV_INTERVAL_CAPACITY);
+    mIntervalTimes.resize(HRV_INTERVAL_CAPACITY);
+    mDiffSquares.resize(HRV_INTERVAL_CAPACITY);
+    reset();
+}
+
+void HrvAnalyzer::setSampleRate(float hz)
+{
+    mSampleRate = hz;
+    reset();
+}
+
+void HrvAnalyzer::setWindowSeconds(float seconds)
+{
+    mWindowSeconds = seconds;
+    reset();
+}
+
+void HrvAnalyzer::reset()
+{
+    mFrame = 0;
+    mRunLength = 0;
+    mY0 = mY1 = mY2 = 0;
+    mSignalLevel = 0;
+    mNoiseLevel = 0;
+    mLastBeatTime = 0;
+    mHaveBeat = false;
+    mContiguous = false;
+    mIntervalMean = 0;
+    mRejected = 0;
+
+    mHead = 0;
+    mCount = 0;
+    mSum = mSumSquares = mDiffSquareSum = 0;
+    mDiffCount = 0;
+    mBeatCount = 0;
+    mLastInterval = 0;
+
+    designBandPass(&mLf, 0.04, 0.15, HRV_TACHOGRAM_RATE_HZ);
+    designBandPass(&mHf, 0.15, 0.40, HRV_TACHOGRAM_RATE_HZ);
+    mDecimation = qMax(1, qRound(mSampleRate/HRV_TACHOGRAM_RATE_HZ));
+    mDecimationCounter = 0;
+    mLfPower = mHfPower = 0;
+}
+
+bool HrvAnalyzer::addSample(quint32 frame, float sample, bool artifact)
+{
+    if (mRunLength > 0 && frame < mFrame)
+        reset();
+    bool gap = mRunLength > 0 && frame != mFrame + 1;
+    if (gap)
+        mRunLength = 0;
+    mFrame = frame;
+    mRunLength++;
+    mY0 = mY1;
+    mY1 = mY2;
+    mY2 = sample;
+
+    int countBefore = mBeatCount;
+    if (artifact || gap)
+    {
+        // never form an interval across an artifact or missing frames
+        mHaveBeat = false;
+        mContiguous = false;
+    }
+    else if (mRunLength >= 3)
+    {
+        detectBeat();
+    }
+
+    if (++mDecimationCounter >= mDecimation && mCount > 0)
+    {
+        mDecimationCounter = 0;
+        double tachogram = 1e3*(mLastInterval - mSum/mCount);
+        double lf = runBandPass(&mLf, tachogram);
+        double hf = runBandPass(&mHf, tachogram);
+        double alpha = 1.0/(mWindowSeconds*HRV_TACHOGRAM_RATE_HZ);
+        mLfPower += alpha*(lf*lf - mLfPower);
+        mHfPower += alpha*(hf*hf - mHfPower);
+    }
+    return mBeatCount != countBefore;
+}
+
+void HrvAnalyzer::detectBeat()
+{
+    // local maximum at n-1
+    if (!(mY1 > mY0 && mY1 >= mY2))
+        return;
+
+    float threshold = mNoiseLevel + HRV_THRESHOLD_FRACTION*(mSignalLevel - mNoiseLevel);
+    if (mY1 <= threshold)
+    {
+        mNoiseLevel += HRV_LEVEL_ALPHA*(mY1 - mNoiseLevel);
+        return;
+    }
+
+    float curvature = mY0 - 2*mY1 + mY2;
+    float offset = (curvature != 0) ? 0.5f*(mY0 - mY2)/curvature : 0.0f;
+    double beatTime = (double(mFrame) - 1 + offset)/mSampleRate;
+
+    if (mHaveBeat && beatTime - mLastBeatTime < HRV_MIN_INTERVAL_S)
+        return;
+
+    mSignalLevel += HRV_LEVEL_ALPHA*(mY1 - mSignalLevel);
+    if (mHaveBeat)
+        acceptInterval(beatTime);
+    else
+        mContiguous = false;
+    mLastBeatTime = beatTime;
+    mHaveBeat = true;
+}
+
+void HrvAnalyzer::acceptInterval(double beatTime)
+{
+    float interval = float(beatTime - mLastBeatTime);
+    if (interval > HRV_MAX_INTERVAL_S)
+    {
+        mContiguous = false;
+        return;
+    }
+
+    if (mIntervalMean > 0 && qAbs(interval - mIntervalMean) > HRV_MAX_INTERVAL_CHANGE*mIntervalMean)
+    {
+        // missed or extra beat; after a few in a row assume the rate itself has changed
+        mContiguous = false;
+        if (++mRejected < 3)
+            return;
+    }
+    mRejected = 0;
+    mIntervalMean = (mIntervalMean > 0) ? mIntervalMean + 0.1f*(interval - mIntervalMean) : interval;
+
+    while (mCount > 0 && (mCount == HRV_INTERVAL_CAPACITY
+                          || beatTime - mIntervalTimes.at((mHead + HRV_INTERVAL_CAPACITY - mCount) % HRV_INTERVAL_CAPACITY) > mWindowSeconds))
+        evictOldest();
+
+    float diffSquare = -1;
+    if (mContiguous && mCount > 0)
+    {
+        float diff = 1e3f*(interval - mLastInterval);
+        diffSquare = diff*diff;
+        mDiffSquareSum += diffSquare;
+        mDiffCount++;
+    }
+
+    mIntervals[mHead] = interval;
+    mIntervalTimes[mHead] = beatTime;
+    mDiffSquares[mHead] = diffSquare;
+    mHead = (mHead + 1) % HRV_INTERVAL_CAPACITY;
+    mCount++;
+    mSum += interval;
+    mSumSquares += double(interval)*interval;
+
+    mLastInterval = interval;
+    mContiguous = true;
+    mBeatCount++;
+}
+
+void HrvAnalyzer::evictOldest()
+{
+    int oldest = (mHead + HRV_INTERVAL_CAPACITY - mCount) % HRV_INTERVAL_CAPACITY;
+    float interval = mIntervals.at(oldest);
+    mSum -= interval;
+    mSumSquares -= double(interval)*interval;
+    if (mDiffSquares.at(oldest) >= 0)
+    {
+        mDiffSquareSum -= mDiffSquares.at(oldest);
+        mDiffCount--;
+    }
+    mCount--;
+    if (mCount == 0)
+        mSum = mSumSquares = mDiffSquareSum = 0;
+}
+
+float HrvAnalyzer::interval(int index) const
+{
+    return mIntervals.at((mHead + HRV_INTERVAL_CAPACITY - mCount + index) % HRV_INTERVAL_CAPACITY);
+}
+
+float HrvAnalyzer::rmssd() const
+{
+    if (mDiffCount == 0)
+        return 0;
+    return float(std::sqrt(qMax(0.0, mDiffSquareSum/mDiffCount)));
+}
+
+float HrvAnalyzer::sdnn() const
+{
+    if (mCount < 2)
+        return 0;
+    double mean = mSum/mCount;
+    double variance = (mSumSquares - mCount*mean*mean)/(mCount - 1);
+    return float(1e3*std::sqrt(qMax(0.0, variance)));
+}
+
+float HrvAnalyzer::lfHfRatio() const
+{
+    return (mHfPower > 0) ? float(mLfPower/mHfPower) : 0.0f;
+}
+
+void HrvAnalyzer::designBandPass(BandPass *filter, double lowHz, double highHz, double sampleRateHz)
+{
+    double centerHz = std::sqrt(lowHz*highHz);
+    double q = centerHz/(highHz - lowHz);
+    double w0 = 2*M_PI*centerHz/sampleRateHz;
+    double alpha = std::sin(w0)/(2*q);
+    double a0 = 1 + alpha;
+    filter->b0 = alpha/a0;
+    filter->b2 = -alpha/a0;
+    filter->a1 = -2*std::cos(w0)/a0;
+    filter->a2 = (1 - alpha)/a0;
+    for (int section = 0; section < 2; section++)
+        filter->z1[section] = filter->z2[section] = 0;
+}
+
+double HrvAnalyzer::runBandPass(BandPass *filter, double x)
+{
+    // transposed direct form II
+    for (int section = 0; section < 2; section++)
+    {
+        double y = filter->b0*x + filter->z1[section];
+        filter->z1[section] = filter->z2[section] - filter->a1*y;
+        filter->z2[section] = filter->b2*x - filter->a2*y;
+        x = y;
+    }
+    return x;
+}
@@ -0,0 +1,83 @@
+#ifndef HRVANALYZER_H
+#define HRVANALYZER_H
+
+#include <QVector>
+
+// Beat-to-beat heart-rate variability from the heart waveform, one sample per frame.
+//
+// Samples are timed by their frame number, so beat times and intervals follow the sensor's frame
+// clock. A frame number that does not advance by one (dropped or skipped frames) breaks the
+// sample sequence like an artifact: no peak is detected across it and no interval spans it. A
+// frame number that goes backwards (the sensor restarted) starts the analysis over.
+//
+// Beats are local maxima that rise above an adaptive threshold placed between the running signal
+// and noise peak levels, outside a refractory period; their time is refined by parabolic
+// interpolation between samples. Plausible inter-beat intervals go into a fixed-size store, and
+// the time-domain metrics (RMSSD, SDNN) are kept as running sums over a rolling time window. The
+// LF (0.04-0.15 Hz) and HF (0.15-0.4 Hz) powers come from band-pass filters run on the
+// interval tachogram resampled at 4 Hz. Memory is bounded and every sample costs O(1).
+
+class HrvAnalyzer
+{
+public:
+    HrvAnalyzer();
+
+    void setSampleRate(float hz);
+    void setWindowSeconds(float seconds);
+    void reset();
+
+    bool addSample(quint32 frame, float sample, bool artifact = false);   // true when a new interval was accepted
+
+    int beatCount() const { return mBeatCount; }
+    float lastInterval() const { return mLastInterval; }  // seconds
+    int intervalCount() const { return mCount; }
+    float interval(int index) const;                    // seconds, 0 = oldest in the window
+
+    float rmssd() const;        // ms
+    float sdnn() const;         // ms
+    float lfPower() const { return float(mLfPower); }   // ms^2
+    float hfPower() const { return float(mHfPower); }   // ms^2
+    float lfHfRatio() const;
+
+private:
+    struct BandPass {
+        double b0, b2, a1, a2;  // b1 = 0 for the band-pass
+        double z1[2], z2[2];    // two cascaded identical sections
+    };
+
+    static void designBandPass(BandPass *filter, double lowHz, double highHz, double sampleRateHz);
+    static double runBandPass(BandPass *filter, double x);
+
+    void detectBeat();
+    void acceptInterval(double beatTime);
+    void evictOldest();
+
+    // peak detector
+    float mSampleRate;
+    float mWindowSeconds;
+    quint32 mFrame;                 // frame number of the newest sample
+    int mRunLength;                 // samples since the last gap in the frame numbers
+    float mY0, mY1, mY2;            // samples n-2, n-1, n
+    float mSignalLevel, mNoiseLevel;
+    double mLastBeatTime;
+    bool mHaveBeat, mContiguous;
+    float mIntervalMean;
+    int mRejected;
+
+    // interval store (ring) and running window sums
+    QVector<float> mIntervals;
+    QVector<double> mIntervalTimes;
+    QVector<float> mDiffSquares;    // squared difference to the previous interval, < 0 when not contiguous
+    int mHead, mCount;
+    double mSum, mSumSquares, mDiffSquareSum;
+    int mDiffCount;
+    int mBeatCount;
+    float mLastInterval;
+
+    // spectral estimate on the 4 Hz tachogram
+    BandPass mLf, mHf;
+    int mDecimation, mDecimationCounter;
+    double mLfPower, mHfPower;
+};
+
+#endif // HRVANALYZER_H
@@ -0,0 +1,40 @@
+#include "latencyoverlay.h"
+#include "stageprofiler.h"
+#include <QEvent>
+#include <QFontDatabase>
+
+#define LATENCY_OVERLAY_INTERVAL_MS  (500)
+#define LATENCY_OVERLAY_MARGIN       (8)
+
+LatencyOverlay::LatencyOverlay(const StageProfiler *profiler, QWidget *parent) :
+    QLabel(parent),
+    mProfiler(profiler)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setStyleSheet("background-color: rgba(0, 0, 0, 160); color: white; padding: 4px;");
+    parent->installEventFilter(this);
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    mTimer.start(LATENCY_OVERLAY_INTERVAL_MS);
+    refresh();
+}
+
+bool LatencyOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == parentWidget() && event->type() == QEvent::Resize)
+        place();
+    return QLabel::eventFilter(watched, event);
+}
+
+void LatencyOverlay::refresh()
+{
+    setText(mProfiler->summary());
+    adjustSize();
+    place();
+    raise();
+}
+
+void LatencyOverlay::place()
+{
+    move(parentWidget()->width() - width() - LATENCY_OVERLAY_MARGIN, LATENCY_OVERLAY_MARGIN);
+}
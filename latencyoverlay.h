@@ -0,0 +1,33 @@
+#ifndef LATENCYOVERLAY_H
+#define LATENCYOVERLAY_H
+
+#include <QLabel>
+#include <QTimer>
+
+class StageProfiler;
+
+// Stage latency table (p50/p99/max per stage) floating over the top right corner of its parent.
+//
+// It refreshes itself from the profiler a couple of times per second, follows the parent's size,
+// and lets mouse events through to the widgets underneath.
+
+class LatencyOverlay : public QLabel
+{
+    Q_OBJECT
+public:
+    LatencyOverlay(const StageProfiler *profiler, QWidget *parent);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    void place();
+
+    const StageProfiler *mProfiler;
+    QTimer mTimer;
+};
+
+#endif // LATENCYOVERLAY_H
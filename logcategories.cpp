@@ -0,0 +1,7 @@
+#include "logcategories.h"
+
+Q_LOGGING_CATEGORY(lcApp, "radar.app")
+Q_LOGGING_CATEGORY(lcSerial, "radar.serial", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFrame, "radar.frame", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcVitals, "radar.vitals", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcReadouts, "radar.readouts", QtInfoMsg)
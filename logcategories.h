@@ -0,0 +1,22 @@
+#ifndef LOGCATEGORIES_H
+#define LOGCATEGORIES_H
+
+#include <QLoggingCategory>
+
+// Logging categories, one per subsystem, for qCDebug(lcFrame) << ... and friends.
+//
+// qCDebug/qCInfo only evaluate their stream arguments when the category has that level enabled, so
+// a disabled level costs one inlined flag test. The frame-path categories (serial, frame, vitals,
+// readouts) log every frame at debug level and start with debug disabled; turn them on at runtime
+// with filter rules, from the log/rules setting or QT_LOGGING_RULES, e.g. "radar.frame.debug=true".
+// Building with DEFINES += QT_NO_DEBUG_OUTPUT (or QT_NO_INFO_OUTPUT) compiles those levels out.
+//
+// Enabled records go to the AsyncLog message handler, which writes them on its own thread.
+
+Q_DECLARE_LOGGING_CATEGORY(lcApp)         // "radar.app": start-up, configuration, sensor control
+Q_DECLARE_LOGGING_CATEGORY(lcSerial)      // "radar.serial": ports and raw reads
+Q_DECLARE_LOGGING_CATEGORY(lcFrame)       // "radar.frame": magic word sync and frame decoding
+Q_DECLARE_LOGGING_CATEGORY(lcVitals)      // "radar.vitals": thresholds, fusion, HRV, motion, alarms
+Q_DECLARE_LOGGING_CATEGORY(lcReadouts)    // "radar.readouts": raw vs displayed readout values
+
+#endif // LOGCATEGORIES_H
@@ -1,17 +1,54 @@
 #include "mainwindow.h"
+#include "asynclog.h"
+#include "logcategories.h"
 #include <QApplication>
-#include <QDebug>
+#include <QSettings>
 #include <signal.h>
+#include <stdlib.h>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
+static void writeStderr(const char *text, unsigned int length)
+{
+#ifdef Q_OS_WIN
+    _write(2, text, length);
+#else
+    if (write(2, text, length) < 0)
+        return;
+#endif
+}
+
+// Runs in the signal handler: no logging, locks or allocation, only a write of a fixed message.
+// Records still queued in AsyncLog are lost.
 void handleCrash(int sig)
 {
-    qDebug() << "Application crashed with signal:" << sig;
-    exit(sig);
+    static const char segv[] = "Application crashed with signal SIGSEGV\n";
+    static const char abrt[] = "Application crashed with signal SIGABRT\n";
+    if (sig == SIGSEGV)
+        writeStderr(segv, sizeof(segv) - 1);
+    else
+        writeStderr(abrt, sizeof(abrt) - 1);
+    _exit(sig);
 }
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // Log records are written by the AsyncLog thread, to log/file (stderr if unset) as text or binary.
+    // log/rules holds QLoggingCategory filter rules separated by ';', e.g. "radar.frame.debug=true"
+    QSettings settings("Be Wireless Solutions", "Vital Signs");
+    QString logRules = settings.value("log/rules").toString();
+    if (!logRules.isEmpty())
+        QLoggingCategory::setFilterRules(logRules.replace(';', '\n'));
+    AsyncLog log;
+    log.open(settings.value("log/file").toString(),
+             settings.value("log/format").toString() == "binary" ? AsyncLog::fmBinary : AsyncLog::fmText);
+    log.install();
+
     MainWindow w;
 
     // Install crash handler
@@ -20,6 +57,6 @@ int main(int argc, char *argv[])
 
     w.show(); // Ensure the main window is displayed
 
-    qDebug() << "Application started, showing main window";
+    qCDebug(lcApp) << "Application started, showing main window";
     return a.exec(); // Start the event loop
 }
@@ -1,12 +1,14 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <QDebug>
+#include "logcategories.h"
 #include <QtEndian>
 #include <QDialog>
 #include <QSerialPortInfo>
 #include <QFile>
-#include <QElapsedTimer>                       // This class provides a fast way to calculate elapsed times
+#include <QFileInfo>
+#include <QDockWidget>
 #include "dialogsettings.h"
+#include "reportexporter.h"
 
 #define HEART_RATE_LOW_THRESHOLD  60  // BPM
 #define HEART_RATE_HIGH_THRESHOLD 100 // BPM
@@ -71,18 +73,11 @@
 #define  INDEX_IN_DATA_RANGE_PROFILE_START          LENGTH_MAGIC_WORD_BYTES + LENGTH_OFFSET_NIBBLES + INDEX_RANGE_PROFILE_START*8
 
 #define NUM_PTS_DISTANCE_TIME_PLOT        (256)
-#define HEART_RATE_EST_MEDIAN_FLT_SIZE    (200)
+#define FRAME_PERIOD_S                    (0.05)     // 20 fps profiles
 #define HEART_RATE_EST_FINAL_OUT_SIZE     (200)
-#define THRESH_HEART_CM                   (0.25)
 #define THRESH_BREATH_CM                  (1.0)
-#define BACK_THRESH_BPM                   (4)
-#define BACK_THRESH_CM                    (0.20)
-#define BACK_THRESH_4Hz_CM                (0.15)
-#define THRESH_BACK                       (30)
-#define THRESH_DIFF_EST                   (20)
-#define ALPHA_HEARTRATE_CM                (0.2)
 #define ALPHA_RCS                         (0.2)
-#define APPLY_KALMAN_FILTER               (0.0)
+#define MOTION_NEIGHBOUR_BINS             (1)        // bins either side of the tracked one checked for motion
 
 float BREATHING_PLOT_MAX_YAXIS;
 float HEART_PLOT_MAX_YAXIS;
@@ -104,7 +99,7 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
-qDebug() << "MainWindow initialized, serial ports being configured";
+qCDebug(lcApp) << "MainWindow initialized, serial ports being configured";
 
     QPixmap bkgnd(":/new/prefix51/back2.jpg");
     bkgnd = bkgnd.scaled(this->size(), Qt::IgnoreAspectRatio);
@@ -114,10 +109,18 @@ qDebug() << "MainWindow initialized, serial ports being configured";
     this->setPalette(palette);
 
     localCount = 0;
-    currIndex  = 0;
+    heldBreathingRate = 0;
+    heldHeartRate = 0;
+    breathingAbnormal = false;
+    heartAbnormal = false;
 
-    qDebug() <<"Vital Signs monitor developped by Be Wireless Solutions";
-    qDebug() <<"QT version = " <<QT_VERSION_STR;
+    // Channel 0 is the breathing waveform, channel 1 the heart waveform, at the 20 Hz frame rate
+    conditionWaveforms = settings.value("display/conditionWaveforms", false).toBool();
+    waveformFilter.configure(2, 1);
+    waveformFilter.setSection(0, BiquadFilterBank::dcBlock(0.05, 20.0));
+
+    qCDebug(lcApp) <<"Vital Signs monitor developped by Be Wireless Solutions";
+    qCDebug(lcApp) <<"QT version = " <<QT_VERSION_STR;
 
     qint32 baudRate = 921600;
     FLAG_PAUSE = false;
@@ -129,9 +132,9 @@ qDebug() << "MainWindow initialized, serial ports being configured";
         serialPortFound_Flag = serialPortFind();
         if (serialPortFound_Flag)
         {
-            qDebug()<<"Serial Port Found";
-            qDebug()<<"Data Port Number is" << dataPortNum;
-            qDebug()<<"User Port Number is" << userPortNum;
+            qCInfo(lcSerial)<<"Serial Port Found";
+            qCInfo(lcSerial)<<"Data Port Number is" << dataPortNum;
+            qCInfo(lcSerial)<<"User Port Number is" << userPortNum;
         }
     }
 
@@ -165,10 +168,6 @@ qDebug() << "MainWindow initialized, serial ports being configured";
     statusBar()->showMessage(tr("Ready"));
     ui->checkBox_displayPlots->setChecked(true);
 
-    xDistTimePlot.resize(NUM_PTS_DISTANCE_TIME_PLOT);
-    yDistTimePlot.resize(NUM_PTS_DISTANCE_TIME_PLOT);
-    breathingWfmBuffer.resize(NUM_PTS_DISTANCE_TIME_PLOT);
-    heartWfmBuffer.resize(NUM_PTS_DISTANCE_TIME_PLOT);
 
 
     //QColor plotBackgroundColor = this->palette().color(QPalette::Window); // Use window background color
@@ -194,10 +193,10 @@ qDebug() << "MainWindow initialized, serial ports being configured";
     ui->plot_RangeProfile->plotLayout()->insertRow(0);
     ui->plot_RangeProfile->plotLayout()->addElement(0, 0, myTitle);
 
-    ui->phaseWfmPlot->addGraph(0);
+    new QCPFloatGraph(ui->phaseWfmPlot->xAxis, ui->phaseWfmPlot->yAxis);
     ui->phaseWfmPlot->setBackground(plotBackgroundColor);
     ui->phaseWfmPlot->axisRect()->setBackground(plotBackgroundColor);
-    ui->phaseWfmPlot->xAxis->setLabel("Frame (Index)");
+    ui->phaseWfmPlot->xAxis->setLabel("Time (s)");
     ui->phaseWfmPlot->xAxis->setLabelFont(font);
     ui->phaseWfmPlot->yAxis->setLabel("Displacement (a.u.)");
     ui->phaseWfmPlot->yAxis->setLabelFont(font);
@@ -210,7 +209,7 @@ qDebug() << "MainWindow initialized, serial ports being configured";
     ui->phaseWfmPlot->plotLayout()->insertRow(0);
     ui->phaseWfmPlot->plotLayout()->addElement(0, 0, myTitle_ChestDisp);
 
-    ui->BreathingWfmPlot->addGraph(0);
+    new QCPFloatGraph(ui->BreathingWfmPlot->xAxis, ui->BreathingWfmPlot->yAxis);
     ui->BreathingWfmPlot->setBackground(plotBackgroundColor);
     ui->BreathingWfmPlot->axisRect()->setBackground(plotBackgroundColor);
     ui->BreathingWfmPlot->xAxis->setLabelFont(font);
@@ -225,7 +224,7 @@ qDebug() << "MainWindow initialized, serial ports being configured";
     ui->BreathingWfmPlot->plotLayout()->insertRow(0);
     ui->BreathingWfmPlot->plotLayout()->addElement(0, 0, myTitle_BreathWfm);
 
-    ui->heartWfmPlot->addGraph(0);
+    new QCPFloatGraph(ui->heartWfmPlot->xAxis, ui->heartWfmPlot->yAxis);
     ui->heartWfmPlot->setBackground(plotBackgroundColor);
     ui->heartWfmPlot->axisRect()->setBackground(plotBackgroundColor);
     ui->heartWfmPlot->xAxis->setLabelFont(font);
@@ -266,17 +265,225 @@ qDebug() << "MainWindow initialized, serial ports being configured";
     ui->lineEdit_ProfileBack->setText("xwr1642_profile_VitalSigns_20fps_Back.cfg");
     ui->lineEdit_ProfileFront->setText("xwr1642_profile_VitalSigns_20fps_Front.cfg");
 
+    // Registered in ReadoutId order; the primary rate and alarm displays always stay LCDs
+    readouts = new ReadoutPanel(this);
+    readouts->addReadout(ui->lcdNumber_Breathingrate, tr("Breathing rate"), 0, 8, 'f', false);
+    readouts->addReadout(ui->lcdNumber_HeartRate, tr("Heart rate"), 0, 3, 'f', false);
+    readouts->addReadout(ui->lcdNumber_AbnormalBreath, tr("Abnormal breathing"), 0, 8, 'f', false);
+    readouts->addReadout(ui->lcdNumber_AbnormalHeart, tr("Abnormal heart rate"), 0, 8, 'f', false);
+    readouts->addReadout(ui->lcdNumber_FrameCount, tr("Frame"), 0, 0);
+    readouts->addReadout(ui->lcdNumber_Index, tr("Range bin"), 0);
+    readouts->addReadout(ui->lcdNumber_ReliabilityMetric, tr("Reliability"), 5, 0, 'g');
+    readouts->addReadout(ui->lcdNumber_RCS, tr("RCS"), 0);
+    readouts->addReadout(ui->lcdNumber_Display3, tr("Motion flag"), 3);
+    readouts->addReadout(ui->lcdNumber_Breath_pk, tr("Breath peak"), 0);
+    readouts->addReadout(ui->lcdNumber_Breath_FT, tr("Breath FFT"), 0);
+    readouts->addReadout(ui->lcdNumber_Breath_xCorr, tr("Breath xCorr"), 3);
+    readouts->addReadout(ui->lcdNumber_breathRate_HarmEnergy, tr("Breath harm. energy"), 3);
+    readouts->addReadout(ui->lcdNumber_BreathEnergy, tr("Breath wfm energy"), 3);
+    readouts->addReadout(ui->lcdNumber_CM_Breath, tr("Breath CM"), 3);
+    readouts->addReadout(ui->lcdNumber_CM_Breath_xCorr, tr("Breath xCorr CM"), 3);
+    readouts->addReadout(ui->lcdNumber_Heart_pk, tr("Heart peak"), 0);
+    readouts->addReadout(ui->lcdNumber_Heart_FT, tr("Heart FFT"), 0);
+    readouts->addReadout(ui->lcdNumber_Heart_FT_4Hz, tr("Heart FFT 4 Hz"), 3);
+    readouts->addReadout(ui->lcdNumber_Heart_xCorr, tr("Heart xCorr"), 0);
+    readouts->addReadout(ui->lcdNumber_HeartEnergy, tr("Heart wfm energy"), 3);
+    readouts->addReadout(ui->lcdNumber_CM_Heart, tr("Heart CM"), 3);
+    readouts->addReadout(ui->lcdNumber_Display4, tr("Heart 4 Hz CM"), 3);
+    readouts->addReadout(ui->lcdNumber_CM_Heart_xCorr, tr("Heart xCorr CM"), 3);
+    readouts->addReadout(ui->lcdNumber_CM_Breath_xCorr_3, tr("HRV RMSSD (ms)"), 1);
+    readouts->addReadout(ui->lcdNumber_CM_Breath_xCorr_4, tr("HRV SDNN (ms)"), 1);
+    if (settings.value("display/paintedReadouts", false).toBool())
+    {
+        QDockWidget *readoutDock = new QDockWidget(tr("Readouts"), this);
+        readoutDock->setWidget(readouts);
+        addDockWidget(Qt::RightDockWidgetArea, readoutDock);
+        readouts->setPainted(true);
+        ui->groupBox_8->hide();
+        ui->groupBox_9->hide();
+    }
+
+    // Waveforms scroll over a time window; the default matches the former 256-frame sweep
+    double stripWindow = settings.value("display/stripWindowSeconds", NUM_PTS_DISTANCE_TIME_PLOT*FRAME_PERIOD_S).toDouble();
+    phaseStrip.setGraph(ui->phaseWfmPlot->graph(0));
+    breathingStrip.setGraph(ui->BreathingWfmPlot->graph(0));
+    heartStrip.setGraph(ui->heartWfmPlot->graph(0));
+    phaseStrip.setWindow(stripWindow);
+    breathingStrip.setWindow(stripWindow);
+    heartStrip.setWindow(stripWindow);
+    phaseExtrema.setWindow(stripWindow);
+    breathingExtrema.setWindow(stripWindow);
+    phaseStrip.setSampleInterval(FRAME_PERIOD_S);
+    breathingStrip.setSampleInterval(FRAME_PERIOD_S);
+    heartStrip.setSampleInterval(FRAME_PERIOD_S);
+    // Optionally scroll the waveform layers by whole pixels and draw only the samples that came in
+    bool scrollBlit = settings.value("display/scrollBlit", false).toBool();
+    phaseStrip.setPixelAligned(scrollBlit);
+    breathingStrip.setPixelAligned(scrollBlit);
+    heartStrip.setPixelAligned(scrollBlit);
+    phaseStrip.updateKeyAxis();
+    breathingStrip.updateKeyAxis();
+    heartStrip.updateKeyAxis();
+
+    // Tick labels are cached across all plots; the scrolling time axes keep reusing the same texts
+    QCustomPlot::setLabelCacheSize(settings.value("display/labelCacheKiB", 4096).toInt()*1024);
+
+    // Plottables go on a buffered layer, so frames that leave the axes alone only redraw the data
+    QCPLayer *phaseLayer = RenderScheduler::createDataLayer(ui->phaseWfmPlot);
+    QCPLayer *breathingLayer = RenderScheduler::createDataLayer(ui->BreathingWfmPlot);
+    QCPLayer *heartLayer = RenderScheduler::createDataLayer(ui->heartWfmPlot);
+    if (scrollBlit)
+    {
+        phaseLayer->setScrollAxis(ui->phaseWfmPlot->graph(0)->keyAxis());
+        breathingLayer->setScrollAxis(ui->BreathingWfmPlot->graph(0)->keyAxis());
+        heartLayer->setScrollAxis(ui->heartWfmPlot->graph(0)->keyAxis());
+    }
+    rangeProfileMax = 0;
+    renderScheduler = new RenderScheduler(this);
+    renderScheduler->setRate(settings.value("display/renderRateHz", 30.0).toDouble());
+    renderScheduler->setProfiler(&profiler);
+    renderScheduler->addPlot(ui->phaseWfmPlot, [this]() {
+        drainFeed(phaseFeed, phaseStrip, &phaseExtrema);
+        double lower = ui->phaseWfmPlot->yAxis->range().lower, upper = ui->phaseWfmPlot->yAxis->range().upper;
+        phaseStrip.updateKeyAxis();
+        if (phaseExtrema.fitRange(&lower, &upper))
+            ui->phaseWfmPlot->yAxis->setRange(lower, upper);
+    }, phaseLayer);
+    renderScheduler->addPlot(ui->BreathingWfmPlot, [this]() {
+        drainFeed(breathingFeed, breathingStrip, &breathingExtrema);
+        double lower = ui->BreathingWfmPlot->yAxis->range().lower, upper = ui->BreathingWfmPlot->yAxis->range().upper;
+        breathingStrip.updateKeyAxis();
+        if (breathingExtrema.fitRange(&lower, &upper))
+            ui->BreathingWfmPlot->yAxis->setRange(qMin(lower, double(-BREATHING_PLOT_MAX_YAXIS)),
+                                                  qMax(upper, double(BREATHING_PLOT_MAX_YAXIS)));
+    }, breathingLayer);
+    renderScheduler->addPlot(ui->heartWfmPlot, [this]() {
+        drainFeed(heartFeed, heartStrip, 0);
+        heartStrip.updateKeyAxis();
+    }, heartLayer);
+    renderScheduler->addPlot(ui->plot_RangeProfile, [this]() {
+        QSharedPointer<QCPGraphDataContainer> profile = rangeProfileFeed.takeSnapshot();
+        if (profile)
+        {
+            bool found = false;
+            rangeProfileMax = profile->valueRange(found).upper;
+            ui->plot_RangeProfile->graph(0)->setData(profile);
+        }
+        ui->plot_RangeProfile->xAxis->setRange(demoParams.rangeStartMeters, demoParams.rangeEndMeters);
+        // same hysteresis as the waveforms: grow at once, shrink only once the peak is well below
+        double upper = ui->plot_RangeProfile->yAxis->range().upper;
+        double wanted = qMax(rangeProfileMax, ui->SpinBox_RCS->value());
+        if (wanted > upper || wanted < WINDOW_EXTREMA_SHRINK*upper)
+            ui->plot_RangeProfile->yAxis->setRangeUpper(wanted*(1 + WINDOW_EXTREMA_MARGIN));
+    }, RenderScheduler::createDataLayer(ui->plot_RangeProfile));
+
+    // Whole-session trends, keyed by wall-clock time so they run on across pauses and restarts
+    trendPlot = 0;
+    trendShownUpper = 0;
+    if (settings.value("display/trends", false).toBool())
+    {
+        trendPlot = new QCustomPlot(this);
+        trendPlot->setMinimumHeight(180);
+        QSharedPointer<QCPAxisTickerDateTime> timeTicker(new QCPAxisTickerDateTime);
+        timeTicker->setDateTimeFormat("hh:mm");
+        trendPlot->xAxis->setTicker(timeTicker);
+        trendPlot->yAxis->setLabel("Rate (bpm)");
+        trendPlot->yAxis->setRange(0, HEART_RATE_HIGH_THRESHOLD + 20);
+        trendPlot->yAxis2->setLabel("RCS");
+        trendPlot->yAxis2->setVisible(true);
+        heartTrend = new TrendPlottable(trendPlot->xAxis, trendPlot->yAxis);
+        heartTrend->setName(tr("Heart rate"));
+        heartTrend->setPen(QPen(Qt::red));
+        breathingTrend = new TrendPlottable(trendPlot->xAxis, trendPlot->yAxis);
+        breathingTrend->setName(tr("Breathing rate"));
+        breathingTrend->setPen(QPen(Qt::blue));
+        rcsTrend = new TrendPlottable(trendPlot->xAxis, trendPlot->yAxis2);
+        rcsTrend->setName(tr("RCS"));
+        rcsTrend->setPen(QPen(Qt::darkGray));
+        trendPlot->legend->setVisible(true);
+        trendPlot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+        trendPlot->axisRect()->setRangeDrag(Qt::Horizontal);
+        trendPlot->axisRect()->setRangeZoom(Qt::Horizontal);
+
+        QDockWidget *trendDock = new QDockWidget(tr("Trends"), this);
+        trendDock->setWidget(trendPlot);
+        addDockWidget(Qt::BottomDockWidgetArea, trendDock);
+
+        renderScheduler->addPlot(trendPlot, [this]() {
+            drainTrend(heartTrendFeed, heartTrend);
+            drainTrend(breathingTrendFeed, breathingTrend);
+            drainTrend(rcsTrendFeed, rcsTrend);
+            bool found = false;
+            QCPRange keys = rcsTrend->getKeyRange(found);
+            if (!found)
+                return;
+            // Follow the newest sample unless the view was dragged or zoomed away from it
+            QCPRange view = trendPlot->xAxis->range();
+            if (view.upper >= trendShownUpper)
+                trendPlot->xAxis->setRange(view.lower <= keys.lower ? keys.lower : keys.upper - view.size(), keys.upper);
+            trendShownUpper = keys.upper;
+            QCPRange rcs = rcsTrend->getValueRange(found, QCP::sdBoth, trendPlot->xAxis->range());
+            if (found)
+                trendPlot->yAxis2->setRange(0, qMax(rcs.upper, 1.0));
+        }, RenderScheduler::createDataLayer(trendPlot));
+    }
+
+    // Range-time map: one column per pixel, scrolling with the waveform strips
+    rangeTimePlot = 0;
+    if (settings.value("display/rangeTime", false).toBool())
+    {
+        rangeTimePlot = new QCustomPlot(this);
+        rangeTimePlot->setMinimumHeight(180);
+        rangeTimePlot->xAxis->setLabel("Time (s)");
+        rangeTimePlot->yAxis->setLabel("Range (m)");
+        QCPColorMap *colorMap = new QCPColorMap(rangeTimePlot->xAxis, rangeTimePlot->yAxis);
+        colorMap->setGradient(QCPColorGradient::gpThermal);
+        rangeTimeMap.setMap(colorMap);
+        rangeTimeMap.setFramePeriod(FRAME_PERIOD_S);
+        rangeTimeMap.setWindow(settings.value("display/rangeTimeSeconds", 600.0).toDouble());
+        rangeTimeMap.updateAxes();
+
+        QDockWidget *rangeTimeDock = new QDockWidget(tr("Range-time"), this);
+        rangeTimeDock->setWidget(rangeTimePlot);
+        addDockWidget(Qt::BottomDockWidgetArea, rangeTimeDock);
+
+        renderScheduler->addPlot(rangeTimePlot, [this]() {
+            rangeTimeMap.updateAxes();
+        }, RenderScheduler::createDataLayer(rangeTimePlot));
+    }
+    renderScheduler->start();
+
+    // Dashboard snapshots of this bed's plots, rendered offscreen and written as images
+    snapshots = 0;
+    QString snapshotDirectory = settings.value("dashboard/snapshotDirectory").toString();
+    if (!snapshotDirectory.isEmpty())
+    {
+        snapshots = new SnapshotRenderer(this);
+        snapshots->setDirectory(snapshotDirectory);
+        snapshots->setRate(settings.value("dashboard/snapshotRateHz", 2.0).toDouble());
+        snapshots->setWindow(stripWindow);
+        snapshots->addSensor(settings.value("dashboard/sensorName", "bed").toString());
+        snapshots->start();
+    }
+
+    // The stage probes always record; the table over the window is opt-in
+    latencyOverlay = 0;
+    if (settings.value("display/latencyOverlay", false).toBool())
+        latencyOverlay = new LatencyOverlay(&profiler, centralWidget());
+
     connect(this,SIGNAL(gui_statusChanged()),this,SLOT(gui_statusUpdate()));
 }
 
 void MainWindow::serialRecieved()
 {
+    StageProfiler::Lap lap(&profiler);
     QByteArray dataSerial = serialRead->readAll().toHex();
     int dataSize = dataSerial.size();
-    qDebug() << "received serial data, size: " << dataSize;
-    qDebug() << "Raw data (first 64 bytes): " << dataSerial.left(64);
+    qCDebug(lcSerial) << "received serial data, size: " << dataSize;
+    qCDebug(lcSerial) << "Raw data (first 64 bytes): " << dataSerial.left(64);
     dataBuffer.append(dataSerial);
     indexBuffer += dataSize;
+    lap.record(StageProfiler::stIngest);
     processData();
 }
 
@@ -301,6 +508,14 @@ void MainWindow::on_pushButton_start_clicked()
 
     FLAG_PAUSE = false;
     AUTO_DETECT_COM_PORTS = ui->checkBox_AutoDetectPorts->isChecked();
+    motionDetector.reset();
+    binMotion.reset();
+    heldBreathingRate = 0;
+    heldHeartRate = 0;
+    breathingAbnormal = false;
+    heartAbnormal = false;
+    hrvAnalyzer.reset();
+    waveformFilter.reset();
 
     if (AUTO_DETECT_COM_PORTS)
     {
@@ -329,11 +544,11 @@ void MainWindow::on_pushButton_start_clicked()
     {
         QString profileBack = ui->lineEdit_ProfileBack->text();
         QString profileFront = ui->lineEdit_ProfileFront->text();
-        qDebug() << "Configuration File Names - Back:" << profileBack << "Front:" << profileFront;
+        qCDebug(lcApp) << "Configuration File Names - Back:" << profileBack << "Front:" << profileFront;
 
         DialogSettings myDialogue;
         QString userComPort = myDialogue.getUserComPortNum();
-        qDebug() << "User COM Port:" << userComPort;
+        qCDebug(lcApp) << "User COM Port:" << userComPort;
 
         QDir currDir = QCoreApplication::applicationDirPath();
         currDir.cdUp();
@@ -344,7 +559,7 @@ void MainWindow::on_pushButton_start_clicked()
         {
             selectedProfile = profileBack;
             filenameText.append(profileBack);
-            qDebug() << "Using Back Measurement Profile. Path is:" << filenameText;
+            qCDebug(lcApp) << "Using Back Measurement Profile. Path is:" << filenameText;
             HEART_PLOT_MAX_YAXIS = myDialogue.getHeartWfm_yAxisMax();
             BREATHING_PLOT_MAX_YAXIS = myDialogue.getBreathWfm_yAxisMax();
             thresh_breath = 1e8; // Adjusted threshold
@@ -354,7 +569,7 @@ void MainWindow::on_pushButton_start_clicked()
         {
             selectedProfile = profileFront;
             filenameText.append(profileFront);
-            qDebug() << "Using Front Measurement Profile. Path is:" << filenameText;
+            qCDebug(lcApp) << "Using Front Measurement Profile. Path is:" << filenameText;
             thresh_breath = 1e8; // Adjusted threshold
             thresh_heart = 100;  // Adjusted threshold
             BREATHING_PLOT_MAX_YAXIS = 1.0;
@@ -363,12 +578,35 @@ void MainWindow::on_pushButton_start_clicked()
         ui->SpinBox_TH_Breath->setValue(thresh_breath);
         ui->SpinBox_TH_Heart->setValue(thresh_heart);
 
+        // Heart-rate fusion graph: "<profile>.fusion" next to a .cfg profile, else the built-in one
+        QFileInfo profileInfo(filenameText);
+        QString fusionFileName;
+        if (profileInfo.suffix().compare("cfg", Qt::CaseInsensitive) == 0)
+            fusionFileName = profileInfo.absolutePath() + "/" + profileInfo.completeBaseName() + ".fusion";
+        QStringList defaultGraph = ui->radioButton_BackMeasurements->isChecked() ? HeartRateFusion::defaultBackGraph()
+                                                                                 : HeartRateFusion::defaultFrontGraph();
+        QString fusionError;
+        if (!fusionFileName.isEmpty() && QFile::exists(fusionFileName))
+        {
+            if (heartRateFusion.loadFile(fusionFileName, &fusionError))
+                qCDebug(lcApp) << "Heart-rate fusion graph loaded from:" << fusionFileName;
+            else
+            {
+                qCWarning(lcApp) << "Failed to load fusion graph" << fusionFileName << ":" << fusionError << "- using default";
+                heartRateFusion.compile(defaultGraph);
+            }
+        }
+        else
+        {
+            heartRateFusion.compile(defaultGraph);
+        }
+
         QFile infile(filenameText);
         QStringList configLines;
 
         if (infile.open(QIODevice::ReadOnly | QIODevice::Text))
         {
-            qDebug() << "Config file opened successfully for reading:" << filenameText;
+            qCDebug(lcApp) << "Config file opened successfully for reading:" << filenameText;
             QTextStream inStream(&infile);
             while (!inStream.atEnd())
             {
@@ -376,11 +614,11 @@ void MainWindow::on_pushButton_start_clicked()
                 if (!line.isEmpty())
                 {
                     configLines.append(line);
-                    qDebug() << "Sending line:" << line;
+                    qCDebug(lcApp) << "Sending line:" << line;
                     serialWrite->write(line.toUtf8() + "\n");
                     if (!serialWrite->waitForBytesWritten(500)) // Reduced timeout to 500ms
                     {
-                        qDebug() << "Failed to write line to serial port:" << serialWrite->errorString();
+                        qCWarning(lcApp) << "Failed to write line to serial port:" << serialWrite->errorString();
                     }
                     QThread::msleep(50); // Reduced delay to 50ms
                 }
@@ -389,7 +627,7 @@ void MainWindow::on_pushButton_start_clicked()
         }
         else
         {
-            qDebug() << "Failed to open config file for reading:" << infile.errorString() << "Path:" << filenameText;
+            qCWarning(lcApp) << "Failed to open config file for reading:" << infile.errorString() << "Path:" << filenameText;
             statusBar()->showMessage(tr("Failed to open configuration file"));
             return;
         }
@@ -402,7 +640,7 @@ void MainWindow::on_pushButton_start_clicked()
                 demoParams.rangeStartMeters = listArgs.at(1).toFloat();
                 demoParams.rangeEndMeters = listArgs.at(2).toFloat();
                 demoParams.AGC_thresh = listArgs.at(5).toFloat();
-                qDebug() << "Parsed vitalSignsCfg - rangeStartMeters:" << demoParams.rangeStartMeters
+                qCDebug(lcApp) << "Parsed vitalSignsCfg - rangeStartMeters:" << demoParams.rangeStartMeters
                          << "rangeEndMeters:" << demoParams.rangeEndMeters
                          << "AGC_thresh:" << demoParams.AGC_thresh;
             }
@@ -412,7 +650,7 @@ void MainWindow::on_pushButton_start_clicked()
                 demoParams.freqSlope_MHZ_us = listArgs.at(8).toFloat();
                 demoParams.numSamplesChirp = listArgs.at(10).toFloat();
                 demoParams.samplingRateADC_ksps = listArgs.at(11).toInt();
-                qDebug() << "Parsed profileCfg - stratFreq_GHz:" << demoParams.stratFreq_GHz
+                qCDebug(lcApp) << "Parsed profileCfg - stratFreq_GHz:" << demoParams.stratFreq_GHz
                          << "freqSlope_MHZ_us:" << demoParams.freqSlope_MHZ_us
                          << "numSamplesChirp:" << demoParams.numSamplesChirp
                          << "samplingRateADC_ksps:" << demoParams.samplingRateADC_ksps;
@@ -420,38 +658,38 @@ void MainWindow::on_pushButton_start_clicked()
         }
 
         demoParams.chirpDuration_us = 1e3 * demoParams.numSamplesChirp / demoParams.samplingRateADC_ksps;
-        qDebug() << "Chirp Duration in us is:" << demoParams.chirpDuration_us;
+        qCDebug(lcApp) << "Chirp Duration in us is:" << demoParams.chirpDuration_us;
         demoParams.chirpBandwidth_kHz = demoParams.freqSlope_MHZ_us * demoParams.chirpDuration_us;
-        qDebug() << "Chirp Bandwidth in kHz is:" << demoParams.chirpBandwidth_kHz;
+        qCDebug(lcApp) << "Chirp Bandwidth in kHz is:" << demoParams.chirpBandwidth_kHz;
         float numTemp = demoParams.chirpDuration_us * demoParams.samplingRateADC_ksps * 3e8;
         float denTemp = 2 * demoParams.chirpBandwidth_kHz;
         demoParams.rangeMaximum_meters = numTemp / (denTemp * 1e9);
-        qDebug() << "Maximum Range in Meters is:" << demoParams.rangeMaximum_meters;
+        qCDebug(lcApp) << "Maximum Range in Meters is:" << demoParams.rangeMaximum_meters;
         demoParams.rangeFFTsize = nextPower2(demoParams.numSamplesChirp);
-        qDebug() << "Range-FFT size is:" << demoParams.rangeFFTsize;
+        qCDebug(lcApp) << "Range-FFT size is:" << demoParams.rangeFFTsize;
         demoParams.rangeBinSize_meters = demoParams.rangeMaximum_meters / demoParams.rangeFFTsize;
-        qDebug() << "Range-Bin size is:" << demoParams.rangeBinSize_meters;
+        qCDebug(lcApp) << "Range-Bin size is:" << demoParams.rangeBinSize_meters;
         demoParams.rangeBinStart_index = demoParams.rangeStartMeters / demoParams.rangeBinSize_meters;
         demoParams.rangeBinEnd_index = demoParams.rangeEndMeters / demoParams.rangeBinSize_meters;
-        qDebug() << "Range-Bin Start Index is:" << demoParams.rangeBinStart_index;
-        qDebug() << "Range-Bin End Index is:" << demoParams.rangeBinEnd_index;
+        qCDebug(lcApp) << "Range-Bin Start Index is:" << demoParams.rangeBinStart_index;
+        qCDebug(lcApp) << "Range-Bin End Index is:" << demoParams.rangeBinEnd_index;
         demoParams.numRangeBinProcessed = demoParams.rangeBinEnd_index - demoParams.rangeBinStart_index + 1;
 
         demoParams.totalPayloadSize_bytes = LENGTH_HEADER_BYTES;
         demoParams.totalPayloadSize_bytes += LENGTH_TLV_MESSAGE_HEADER_BYTES + (4 * demoParams.numRangeBinProcessed);
         demoParams.totalPayloadSize_bytes += LENGTH_TLV_MESSAGE_HEADER_BYTES + LENGTH_DEBUG_DATA_OUT_BYTES;
-        qDebug() << "Total Payload size from the UART is:" << demoParams.totalPayloadSize_bytes;
+        qCDebug(lcApp) << "Total Payload size from the UART is:" << demoParams.totalPayloadSize_bytes;
         if ((demoParams.totalPayloadSize_bytes % MMWDEMO_OUTPUT_MSG_SEGMENT_LEN) != 0)
         {
             int paddingFactor = ceil((float)demoParams.totalPayloadSize_bytes / (float)MMWDEMO_OUTPUT_MSG_SEGMENT_LEN);
-            qDebug() << "Padding Factor is:" << paddingFactor;
+            qCDebug(lcApp) << "Padding Factor is:" << paddingFactor;
             demoParams.totalPayloadSize_bytes = MMWDEMO_OUTPUT_MSG_SEGMENT_LEN * paddingFactor;
         }
-        qDebug() << "Total Payload size from the UART is:" << demoParams.totalPayloadSize_bytes;
+        qCDebug(lcApp) << "Total Payload size from the UART is:" << demoParams.totalPayloadSize_bytes;
         demoParams.totalPayloadSize_nibbles = 2 * demoParams.totalPayloadSize_bytes;
-        qDebug() << "numRangeBinProcessed:" << demoParams.numRangeBinProcessed;
-        qDebug() << "totalPayloadSize_bytes:" << demoParams.totalPayloadSize_bytes;
-        qDebug() << "totalPayloadSize_nibbles:" << demoParams.totalPayloadSize_nibbles;
+        qCDebug(lcApp) << "numRangeBinProcessed:" << demoParams.numRangeBinProcessed;
+        qCDebug(lcApp) << "totalPayloadSize_bytes:" << demoParams.totalPayloadSize_bytes;
+        qCDebug(lcApp) << "totalPayloadSize_nibbles:" << demoParams.totalPayloadSize_nibbles;
     }
 
     ui->heartWfmPlot->yAxis->setRange(-HEART_PLOT_MAX_YAXIS, HEART_PLOT_MAX_YAXIS);
@@ -468,6 +706,11 @@ void MainWindow::on_pushButton_Refresh_clicked()
     Sleep(2000);
 }
 
+void MainWindow::on_checkBox_Kalman_toggled(bool checked)
+{
+    heartRateFusion.setTrackerMode(checked ? VitalsTracker::tmConstantVelocity : VitalsTracker::tmOff);
+}
+
 int MainWindow::nextPower2(int num)
 {
     int power = 1;
@@ -494,11 +737,11 @@ quint32 MainWindow::parseValueUint32(QByteArray data, int valuePos, int valueSiz
     bool ok;
     QByteArray parseData = data.mid(valuePos, valueSize);
     QString strParseData = parseData;
-    qDebug() << "Parsing uint32 at pos: " << valuePos << ", data: " << parseData;
+    qCDebug(lcFrame) << "Parsing uint32 at pos: " << valuePos << ", data: " << parseData;
     quint32 tempInt32 = strParseData.toUInt(&ok, 16);
     if (!ok)
     {
-        qDebug() << "Failed to parse uint32: " << strParseData;
+        qCWarning(lcFrame) << "Failed to parse uint32: " << strParseData;
         return 0;
     }
     quint32 parseValueOut = qToBigEndian(tempInt32);
@@ -540,7 +783,7 @@ bool MainWindow::serialPortFind()
 bool MainWindow::serialPortConfig(QSerialPort *serial, qint32 baudRate, QString dataPortNum)
 {
     serial->setPortName(dataPortNum);
-    qDebug() << "Configuring port: " << dataPortNum << " at baud rate: " << baudRate;
+    qCInfo(lcSerial) << "Configuring port: " << dataPortNum << " at baud rate: " << baudRate;
     if (serial->open(QIODevice::ReadWrite))
     {
         FlagSerialPort_Connected = 1;
@@ -549,12 +792,12 @@ bool MainWindow::serialPortConfig(QSerialPort *serial, qint32 baudRate, QString
         serial->setParity(QSerialPort::NoParity);
         serial->setStopBits(QSerialPort::OneStop);
         serial->setFlowControl(QSerialPort::NoFlowControl);
-        qDebug() << "Port " << dataPortNum << " opened successfully";
+        qCInfo(lcSerial) << "Port " << dataPortNum << " opened successfully";
     }
     else
     {
         FlagSerialPort_Connected = 0;
-        qDebug() << "Failed to open port " << dataPortNum << ": " << serial->errorString();
+        qCWarning(lcSerial) << "Failed to open port " << dataPortNum << ": " << serial->errorString();
     }
     return FlagSerialPort_Connected;
 }
@@ -565,45 +808,38 @@ void MainWindow::processData()
 {
     QByteArray dataSave;
     QByteArray data;
-    static float outHeartNew_CM;
     static float maxRCS_updated;
     bool MagicOk;
 
-    static float Pk = 1;
-    static float xk = 0;
-    static int updateCounter=0;
-
     FileSavingFlag = ui->checkBox_SaveData->isChecked();
     localCount = localCount + 1;
-    updateCounter++;
 
 
-    qDebug() << "Using totalPayloadSize_nibbles:" << demoParams.totalPayloadSize_nibbles;
+    qCDebug(lcFrame) << "Using totalPayloadSize_nibbles:" << demoParams.totalPayloadSize_nibbles;
     if (demoParams.totalPayloadSize_nibbles <= 0)
     {
-        qDebug() << "Invalid totalPayloadSize_nibbles, using default: 512";
+        qCWarning(lcFrame) << "Invalid totalPayloadSize_nibbles, using default: 512";
         demoParams.totalPayloadSize_nibbles = 512;
     }
     // Limit dataBuffer size to prevent memory exhaustion
         if (dataBuffer.size() > 10 * demoParams.totalPayloadSize_nibbles)
         {
-            qDebug() << "dataBuffer too large, clearing";
+            qCWarning(lcFrame) << "dataBuffer too large, clearing";
             dataBuffer.clear();
             return;
         }
     while (dataBuffer.size() >= demoParams.totalPayloadSize_nibbles)
     {
-        QElapsedTimer timer;
-        timer.start();
+        // each stage of this frame is recorded as the time since the previous one ended
+        StageProfiler::Lap lap(&profiler);
 
         QByteArray searchStr("0201040306050807");
         int dataStartIndex = dataBuffer.indexOf(searchStr);
-        int indexTemp = localCount % NUM_PTS_DISTANCE_TIME_PLOT;
 
         if (dataStartIndex == -1)
         {
             MagicOk = 0;
-            qDebug() << "Magic Word Not Found --- localCount:" << localCount << " DataBufferSize:" << dataBuffer.size();
+            qCDebug(lcFrame) << "Magic Word Not Found --- localCount:" << localCount << " DataBufferSize:" << dataBuffer.size();
             dataBuffer.clear();
             break;
         }
@@ -613,13 +849,13 @@ void MainWindow::processData()
             if (data.size() == demoParams.totalPayloadSize_nibbles)
             {
                 dataBuffer.remove(0, dataStartIndex + demoParams.totalPayloadSize_nibbles);
-                qDebug() << "dataBuffer size after removal is:" << dataBuffer.size();
+                qCDebug(lcFrame) << "dataBuffer size after removal is:" << dataBuffer.size();
                 MagicOk = 1;
                 statusBar()->showMessage(tr("Sensor Running"));
             }
             else
             {
-                qDebug() << "Invalid frame size:" << data.size() << ", expected:" << demoParams.totalPayloadSize_nibbles;
+                qCWarning(lcFrame) << "Invalid frame size:" << data.size() << ", expected:" << demoParams.totalPayloadSize_nibbles;
                 dataBuffer.clear();
                 MagicOk = 0;
                 statusBar()->showMessage(tr("Invalid frame detected, clearing buffer"));
@@ -629,6 +865,7 @@ void MainWindow::processData()
 
         if (MagicOk == 1)
         {
+            lap.record(StageProfiler::stSync);
             if (FileSavingFlag)
             {
                 dataSave = data;
@@ -636,12 +873,12 @@ void MainWindow::processData()
             }
 
             quint32 globalCountOut = parseValueUint32(data, 40, 8);
-            qDebug() << "Frame Number is:" << globalCountOut;
+            qCDebug(lcFrame) << "Frame Number is:" << globalCountOut;
 
             static quint32 lastGlobalCount = 0;
             if (globalCountOut == lastGlobalCount)
             {
-                qDebug() << "Skipping duplicate frame:" << globalCountOut;
+                qCDebug(lcFrame) << "Skipping duplicate frame:" << globalCountOut;
                 continue;
             }
             lastGlobalCount = globalCountOut;
@@ -667,21 +904,17 @@ void MainWindow::processData()
             float BreathingRate_HarmEnergy = parseValueFloat(data, INDEX_IN_DATA_BREATHING_RATE_HARM_ENERGY, 8);
             float BreathingRate_xCorr = parseValueFloat(data, INDEX_IN_DATA_BREATHING_RATE_xCorr, 8);
 
-            qDebug() << "Parsed Values:";
-            qDebug() << "BreathingRate_FFT:" << BreathingRate_FFT;
-            qDebug() << "BreathingRatePK_Out:" << BreathingRatePK_Out;
-            qDebug() << "heartRate_FFT:" << heartRate_FFT;
-            qDebug() << "heartRate_Pk:" << heartRate_Pk;
-            qDebug() << "heartRate_xCorr:" << heartRate_xCorr;
-            qDebug() << "breathRate_CM:" << breathRate_CM;
-            qDebug() << "heartRate_CM:" << heartRate_CM;
-            qDebug() << "outSumEnergyBreathWfm:" << outSumEnergyBreathWfm;
-            qDebug() << "outSumEnergyHeartWfm:" << outSumEnergyHeartWfm;
-            qDebug() << "BreathingRate_xCorr_CM:" << BreathingRate_xCorr_CM;
+            // one record per frame rather than one per value
+            qCDebug(lcFrame) << "Parsed Values - BreathingRate_FFT:" << BreathingRate_FFT << "BreathingRatePK_Out:" << BreathingRatePK_Out
+                             << "heartRate_FFT:" << heartRate_FFT << "heartRate_Pk:" << heartRate_Pk << "heartRate_xCorr:" << heartRate_xCorr
+                             << "breathRate_CM:" << breathRate_CM << "heartRate_CM:" << heartRate_CM
+                             << "outSumEnergyBreathWfm:" << outSumEnergyBreathWfm << "outSumEnergyHeartWfm:" << outSumEnergyHeartWfm
+                             << "BreathingRate_xCorr_CM:" << BreathingRate_xCorr_CM;
 
             unsigned int numRangeBinProcessed = demoParams.rangeBinEnd_index - demoParams.rangeBinStart_index + 1;
             QVector<double> RangeProfile(2*numRangeBinProcessed);
-            QVector<double> xRangePlot(numRangeBinProcessed), yRangePlot(numRangeBinProcessed);
+            xRangePlot.resize(numRangeBinProcessed);
+            yRangePlot.resize(numRangeBinProcessed);
             unsigned int indexRange = INDEX_IN_DATA_RANGE_PROFILE_START;
 
             for (unsigned int index = 0; index < 2*numRangeBinProcessed; index++)
@@ -691,443 +924,380 @@ void MainWindow::processData()
                 indexRange = indexRange + 4;
             }
 
+            double maxRCS = 0;
             for (unsigned int indexRangeBin = 0; indexRangeBin < numRangeBinProcessed; indexRangeBin++)
             {
-                yRangePlot[indexRangeBin] = sqrt(RangeProfile[2*indexRangeBin]*RangeProfile[2*indexRangeBin] + RangeProfile[2*indexRangeBin + 1]*RangeProfile[2*indexRangeBin + 1]);
+                double binEnergy = RangeProfile[2*indexRangeBin]*RangeProfile[2*indexRangeBin] + RangeProfile[2*indexRangeBin + 1]*RangeProfile[2*indexRangeBin + 1];
+                yRangePlot[indexRangeBin] = sqrt(binEnergy);
+                maxRCS = qMax(maxRCS, yRangePlot[indexRangeBin]);
                 xRangePlot[indexRangeBin] = demoParams.rangeStartMeters + demoParams.rangeBinSize_meters*indexRangeBin;
             }
-            double maxRCS = *std::max_element(yRangePlot.constBegin(), yRangePlot.constEnd());
-            maxRCS_updated = ALPHA_RCS*(maxRCS) + (1-ALPHA_RCS)*maxRCS_updated;
+            lap.record(StageProfiler::stDecode);
+
+            // Motion artifacts are kept out of the host estimators, statistics and readouts. The tracked
+            // target's detector sees the firmware flag, its phase waveform and the energy around its range
+            // bin; the per-bin detectors add motion in those bins, so movement elsewhere in the scene is ignored
+            int targetBin = qBound(0, int(rangeBinIndexOut) - int(demoParams.rangeBinStart_index), int(numRangeBinProcessed) - 1);
+            double targetEnergy = 0;
+            for (int bin = qMax(targetBin - MOTION_NEIGHBOUR_BINS, 0); bin <= qMin(targetBin + MOTION_NEIGHBOUR_BINS, int(numRangeBinProcessed) - 1); bin++)
+                targetEnergy += yRangePlot[bin]*yRangePlot[bin];
+            binMotion.update(globalCountOut, RangeProfile);
+            bool motionArtifact = motionDetector.update(globalCountOut, outMotionDetectionFlag == 1, phaseWfm_Out, targetEnergy);
+            motionArtifact = motionArtifact || binMotion.isArtifactNear(targetBin, MOTION_NEIGHBOUR_BINS);
+            if (motionDetector.segmentClosed())
+                qCDebug(lcVitals) << "Motion artifact from frame" << motionDetector.lastSegment().startFrame
+                         << "to" << motionDetector.lastSegment().endFrame;
+            qCDebug(lcVitals) << "Range bins in motion:" << binMotion.artifactBinCount() << "of" << binMotion.binCount();
+            if (!motionArtifact)
+                maxRCS_updated = ALPHA_RCS*(maxRCS) + (1-ALPHA_RCS)*maxRCS_updated;
+
+            if (hrvAnalyzer.addSample(globalCountOut, heartWfm_Out, motionArtifact))
+                qCDebug(lcVitals) << "HRV - IBI (s):" << hrvAnalyzer.lastInterval() << "RMSSD (ms):" << hrvAnalyzer.rmssd()
+                         << "SDNN (ms):" << hrvAnalyzer.sdnn() << "LF/HF:" << hrvAnalyzer.lfHfRatio();
+
+            if (conditionWaveforms)
+            {
+                float wfm[2] = { breathWfm_Out, heartWfm_Out };
+                waveformFilter.process(wfm, 1);
+                breathWfm_Out = wfm[0];
+                heartWfm_Out = wfm[1];
+            }
 
             float BreathingRate_Out, heartRate_Out;
-            float diffEst_heartRate, heartRateEstDisplay;
 
-            float heartRate_OutMedian;
-            static QVector<float> heartRateBuffer;
-            heartRateBuffer.resize(HEART_RATE_EST_MEDIAN_FLT_SIZE);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRateFFT, heartRate_FFT);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRatePeak, heartRate_Pk);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRateXCorr, heartRate_xCorr);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRateFFT4Hz, heartRate_FFT_4Hz);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRateCM, heartRate_CM);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRate4HzCM, heartRate_4Hz_CM);
+            heartRateFusion.setInput(HeartRateFusion::inHeartRateXCorrCM, heartRate_xCorr_CM);
+            heartRateFusion.setInput(HeartRateFusion::inBreathingRateFFT, BreathingRate_FFT);
+            heartRateFusion.setInput(HeartRateFusion::inUseXCorr, ui->checkBox_xCorr->isChecked());
+            heartRateFusion.setInput(HeartRateFusion::inUseFFT, ui->checkBox_FFT->isChecked());
+            float heartRate_Fused = heartRateFusion.evaluate(motionArtifact);
 
             static QVector<float> heartRateOutBufferFinal;
             heartRateOutBufferFinal.resize(HEART_RATE_EST_FINAL_OUT_SIZE);
 
-            float outHeartPrev_CM = outHeartNew_CM;
-            outHeartNew_CM = ALPHA_HEARTRATE_CM*(heartRate_CM) + (1-ALPHA_HEARTRATE_CM)*outHeartPrev_CM;
-
-            diffEst_heartRate = abs(heartRate_FFT - heartRate_Pk);
-            if ((outHeartNew_CM > THRESH_HEART_CM) || (diffEst_heartRate < THRESH_DIFF_EST))
-            {
-                heartRateEstDisplay = heartRate_FFT;
-            }
-            else
-            {
-                heartRateEstDisplay = heartRate_Pk;
-            }
-
-            if (ui->checkBox_xCorr->isChecked())
-            {
-                heartRateEstDisplay = heartRate_xCorr;
-            }
-
-            if (ui->checkBox_FFT->isChecked())
-            {
-                heartRateEstDisplay = heartRate_FFT;
-            }
-
-            if (ui->radioButton_BackMeasurements->isChecked())
-            {
-#ifdef HEAURITICS_APPROACH1
-                if (abs(heartRate_xCorr-heartRate_FFT) < THRESH_BACK)
-                {
-                    heartRateEstDisplay = heartRate_FFT;
-                }
-                else
-                {
-                    heartRateEstDisplay = heartRate_xCorr;
-                }
-
-                heartRateBuffer.insert(2*(localCount % HEART_RATE_EST_MEDIAN_FLT_SIZE/2), heartRateEstDisplay);
-
-                if (ui->checkBox_FFT)
-                {
-                    heartRateBuffer.insert(2*(localCount % HEART_RATE_EST_MEDIAN_FLT_SIZE/2)+1, heartRateEstDisplay);
-                }
-                else
-                {
-                    heartRateBuffer.insert(2*(localCount % HEART_RATE_EST_MEDIAN_FLT_SIZE/2)+1, heartRate_FFT_4Hz);
-                }
-#endif
-
-                int IsvalueSelected = 0;
-
-                if (abs(heartRate_xCorr - 2*BreathingRate_FFT) > BACK_THRESH_BPM)
-                {
-                    heartRateBuffer.insert(currIndex % HEART_RATE_EST_MEDIAN_FLT_SIZE, heartRate_xCorr);
-                    IsvalueSelected = 1;
-                    currIndex++;
-                }
-                if (heartRate_CM > BACK_THRESH_CM)
-                {
-                    heartRateBuffer.insert(currIndex % HEART_RATE_EST_MEDIAN_FLT_SIZE, heartRate_FFT);
-                    IsvalueSelected = 1;
-                    currIndex++;
-                }
-                if (heartRate_4Hz_CM > BACK_THRESH_4Hz_CM)
-                {
-                    heartRateBuffer.insert(currIndex % HEART_RATE_EST_MEDIAN_FLT_SIZE, heartRate_FFT_4Hz);
-                    IsvalueSelected = 1;
-                    currIndex++;
-                }
-
-                if (IsvalueSelected == 0)
-                {
-                    heartRateBuffer.insert(currIndex % HEART_RATE_EST_MEDIAN_FLT_SIZE, heartRate_Pk);
-                    currIndex++;
-                }
-            }
-            else
-            {
-                heartRateBuffer.insert(localCount % HEART_RATE_EST_MEDIAN_FLT_SIZE, heartRateEstDisplay);
-            }
-
             if (gui_paused != current_gui_status)
             {
-                qDebug() << "GUI Status Check - current_gui_status:" << current_gui_status << "gui_paused:" << gui_paused;
-                QList<float> heartRateBufferSort = QList<float>::fromVector(heartRateBuffer);
-                qSort(heartRateBufferSort.begin(), heartRateBufferSort.end());
-                heartRate_OutMedian = heartRateBufferSort.at(HEART_RATE_EST_MEDIAN_FLT_SIZE/2);
+                qCDebug(lcReadouts) << "GUI Status Check - current_gui_status:" << current_gui_status << "gui_paused:" << gui_paused;
+                heartRate_Out = heartRate_Fused;
 
-                if (APPLY_KALMAN_FILTER)
+                // During an artifact the rates, alarms and reliability statistic hold their last clean values
+                if (motionArtifact)
                 {
-                    float R;
-                    float Q;
-                    float KF_Gain;
-                    float CM_combined;
-                    CM_combined = heartRate_CM + heartRate_4Hz_CM + 10*heartRate_xCorr_CM;
-                    R = 1/(CM_combined + 0.0001);
-                    Q = 1e-6;
-                    KF_Gain = Pk/(Pk + R);
-                    xk = xk + KF_Gain*(heartRate_OutMedian - xk);
-                    Pk = (1-KF_Gain)*Pk + Q;
-                    heartRate_Out = xk;
+                    BreathingRate_Out = heldBreathingRate;
+                    heartRate_Out = heldHeartRate;
                 }
                 else
                 {
-                    heartRate_Out = heartRate_OutMedian;
-                }
-
-                heartRateOutBufferFinal.insert(localCount % (HEART_RATE_EST_FINAL_OUT_SIZE), heartRate_Out);
-                const auto mean = std::accumulate(heartRateOutBufferFinal.begin(), heartRateOutBufferFinal.end(), .0) / heartRateOutBufferFinal.size();
-                double sumMAD;
-                double bufferSTD;
-                sumMAD = 0;
-                for (int indexTemp=0; indexTemp<heartRateOutBufferFinal.size(); indexTemp++)
-                {
-                    sumMAD += abs(heartRateOutBufferFinal.at(indexTemp) - mean);
-                }
-                bufferSTD = sqrt(sumMAD)/heartRateOutBufferFinal.size();
-                ui->lcdNumber_ReliabilityMetric->display(bufferSTD);
-                qDebug() << "Displayed Reliability Metric:" << bufferSTD;
-
-                float outSumEnergyBreathWfm_thresh = ui->SpinBox_TH_Breath->value();
-                float RCS_thresh = ui->SpinBox_RCS->value();
-                bool flag_Breathing;
+                    heartRateOutBufferFinal.insert(localCount % (HEART_RATE_EST_FINAL_OUT_SIZE), heartRate_Out);
+                    const auto mean = std::accumulate(heartRateOutBufferFinal.begin(), heartRateOutBufferFinal.end(), .0) / heartRateOutBufferFinal.size();
+                    double sumMAD;
+                    double bufferSTD;
+                    sumMAD = 0;
+                    for (int indexTemp=0; indexTemp<heartRateOutBufferFinal.size(); indexTemp++)
+                    {
+                        sumMAD += abs(heartRateOutBufferFinal.at(indexTemp) - mean);
+                    }
+                    bufferSTD = sqrt(sumMAD)/heartRateOutBufferFinal.size();
+                    readouts->setValue(roReliability, bufferSTD);
+                    qCDebug(lcReadouts) << "Displayed Reliability Metric:" << bufferSTD;
 
-                qDebug() << "Thresholds - outSumEnergyBreathWfm:" << outSumEnergyBreathWfm << "vs thresh:" << outSumEnergyBreathWfm_thresh;
-                qDebug() << "Thresholds - maxRCS_updated:" << maxRCS_updated << "vs RCS_thresh:" << RCS_thresh;
-                qDebug() << "Thresholds - BreathingRate_xCorr_CM:" << BreathingRate_xCorr_CM << "vs 0.002";
+                    float outSumEnergyBreathWfm_thresh = ui->SpinBox_TH_Breath->value();
+                    float RCS_thresh = ui->SpinBox_RCS->value();
+                    bool flag_Breathing;
 
-                if ((outSumEnergyBreathWfm < outSumEnergyBreathWfm_thresh) || (maxRCS_updated < RCS_thresh) || (BreathingRate_xCorr_CM <= 0.002))
-                {
-                    flag_Breathing = 0;
-                    BreathingRate_Out = 0;
-                    QPalette lcdpaletteNotBreathing = ui->lcdNumber_Breathingrate->palette();
-                    lcdpaletteNotBreathing.setColor(QPalette::Normal, QPalette::Window, Qt::red);
-                    ui->lcdNumber_Breathingrate->setPalette(lcdpaletteNotBreathing);
-                }
-                else
-                {
-                    flag_Breathing = 1;
-                    QPalette lcdpaletteBreathing = ui->lcdNumber_Breathingrate->palette();
-                    lcdpaletteBreathing.setColor(QPalette::Normal, QPalette::Window, Qt::white);
-                    ui->lcdNumber_Breathingrate->setPalette(lcdpaletteBreathing);
+                    qCDebug(lcVitals) << "Thresholds - outSumEnergyBreathWfm:" << outSumEnergyBreathWfm << "vs thresh:" << outSumEnergyBreathWfm_thresh;
+                    qCDebug(lcVitals) << "Thresholds - maxRCS_updated:" << maxRCS_updated << "vs RCS_thresh:" << RCS_thresh;
+                    qCDebug(lcVitals) << "Thresholds - BreathingRate_xCorr_CM:" << BreathingRate_xCorr_CM << "vs 0.002";
 
-                    if (breathRate_CM > THRESH_BREATH_CM)
+                    if ((outSumEnergyBreathWfm < outSumEnergyBreathWfm_thresh) || (maxRCS_updated < RCS_thresh) || (BreathingRate_xCorr_CM <= 0.002))
                     {
-                        BreathingRate_Out = BreathingRate_FFT;
+                        flag_Breathing = 0;
+                        BreathingRate_Out = 0;
+                        readouts->setAlarm(roBreathingRate, true);
                     }
                     else
                     {
-                        BreathingRate_Out = BreathingRatePK_Out;
+                        flag_Breathing = 1;
+                        readouts->setAlarm(roBreathingRate, false);
+
+                        if (breathRate_CM > THRESH_BREATH_CM)
+                        {
+                            BreathingRate_Out = BreathingRate_FFT;
+                        }
+                        else
+                        {
+                            BreathingRate_Out = BreathingRatePK_Out;
+                        }
                     }
-                }
 
-                float outSumEnergyHeartWfm_thresh = ui->SpinBox_TH_Heart->value();
+                    float outSumEnergyHeartWfm_thresh = ui->SpinBox_TH_Heart->value();
 
-                qDebug() << "Thresholds - outSumEnergyHeartWfm:" << outSumEnergyHeartWfm << "vs thresh:" << outSumEnergyHeartWfm_thresh;
+                    qCDebug(lcVitals) << "Thresholds - outSumEnergyHeartWfm:" << outSumEnergyHeartWfm << "vs thresh:" << outSumEnergyHeartWfm_thresh;
 
-                if (outSumEnergyHeartWfm < outSumEnergyHeartWfm_thresh || maxRCS_updated < RCS_thresh)
-                {
-                    heartRate_Out = 0;
-                    QPalette lcdpaletteNoHeartRate = ui->lcdNumber_HeartRate->palette();
-                    lcdpaletteNoHeartRate.setColor(QPalette::Normal, QPalette::Window, Qt::red);
-                    heartWfm_Out = 0;
-                    ui->lcdNumber_HeartRate->setPalette(lcdpaletteNoHeartRate);
-                }
-                else
-                {
-                    QPalette lcdpaletteHeartRate = ui->lcdNumber_HeartRate->palette();
-                    lcdpaletteHeartRate.setColor(QPalette::Normal, QPalette::Window, Qt::white);
-                    ui->lcdNumber_HeartRate->setPalette(lcdpaletteHeartRate);
+                    if (outSumEnergyHeartWfm < outSumEnergyHeartWfm_thresh || maxRCS_updated < RCS_thresh)
+                    {
+                        heartRate_Out = 0;
+                        heartWfm_Out = 0;
+                        readouts->setAlarm(roHeartRate, true);
+                    }
+                    else
+                    {
+                        readouts->setAlarm(roHeartRate, false);
+                    }
+                    heldBreathingRate = BreathingRate_Out;
+                    heldHeartRate = heartRate_Out;
                 }
 
-                qDebug() << "Final Rates - BreathingRate_Out:" << BreathingRate_Out;
-                qDebug() << "Final Rates - heartRate_Out:" << heartRate_Out;
+                qCDebug(lcVitals) << "Final Rates - BreathingRate_Out:" << BreathingRate_Out;
+                qCDebug(lcVitals) << "Final Rates - heartRate_Out:" << heartRate_Out;
 
-                if (BreathingRate_Out != 0) // Only check if breathing rate is non-zero (valid)
+                // Abnormal rates are logged once when they start, not on every frame they last
+                if (BreathingRate_Out != 0 && !motionArtifact) // Only check if breathing rate is non-zero (valid)
                         {
-                            if (BreathingRate_Out < BREATHING_RATE_LOW_THRESHOLD || BreathingRate_Out > BREATHING_RATE_HIGH_THRESHOLD)
+                            bool abnormal = BreathingRate_Out < BREATHING_RATE_LOW_THRESHOLD || BreathingRate_Out > BREATHING_RATE_HIGH_THRESHOLD;
+                            if (abnormal)
                             {
                                 // Abnormal breathing rate detected
-                                QString myString_AbnormalBreath = QString::number(BreathingRate_Out, 'f', 0);
-                                ui->lcdNumber_AbnormalBreath->setDigitCount(8);
-                                ui->lcdNumber_AbnormalBreath->display(myString_AbnormalBreath);
-                                qDebug() << "Abnormal Breathing Rate Detected:" << BreathingRate_Out;
+                                readouts->setValue(roAbnormalBreath, BreathingRate_Out);
+                                if (!breathingAbnormal)
+                                    qCInfo(lcVitals) << "Abnormal Breathing Rate Detected:" << BreathingRate_Out;
 
                                 // Highlight the abnormal breathing rate in red
-                                QPalette lcdPaletteAbnormal = ui->lcdNumber_AbnormalBreath->palette();
-                                lcdPaletteAbnormal.setColor(QPalette::Normal, QPalette::Window, Qt::red);
-                                ui->lcdNumber_AbnormalBreath->setPalette(lcdPaletteAbnormal);
+                                readouts->setAlarm(roAbnormalBreath, true);
                             }
+                            breathingAbnormal = abnormal;
                         }
 
 
-                 if (heartRate_Out !=0)
+                 if (heartRate_Out !=0 && !motionArtifact)
                  {
-                     if (heartRate_Out< HEART_RATE_LOW_THRESHOLD || heartRate_Out > HEART_RATE_HIGH_THRESHOLD)
+                     bool abnormal = heartRate_Out< HEART_RATE_LOW_THRESHOLD || heartRate_Out > HEART_RATE_HIGH_THRESHOLD;
+                     if (abnormal)
                      {
-                         QString myString_AbnormalHeart = QString::number(heartRate_Out,'f',0);
-                         ui->lcdNumber_AbnormalHeart->setDigitCount(8);
-                         ui->lcdNumber_AbnormalHeart->display(myString_AbnormalHeart);
-                         qDebug() << "Abnormal heart rate Detected:" << heartRate_Out;
-
-                         QPalette lcdPaletteAbnormal = ui->lcdNumber_AbnormalHeart->palette();
-                         lcdPaletteAbnormal.setColor(QPalette::Normal , QPalette::Window, Qt::red);
-                         ui->lcdNumber_AbnormalHeart->setPalette(lcdPaletteAbnormal);
+                         readouts->setValue(roAbnormalHeart, heartRate_Out);
+                         if (!heartAbnormal)
+                             qCInfo(lcVitals) << "Abnormal heart rate Detected:" << heartRate_Out;
+
+                         readouts->setAlarm(roAbnormalHeart, true);
                      }
+                     heartAbnormal = abnormal;
                  }
 
-                if (ui->checkBox_displayPlots->isChecked()&& updateCounter % 2 == 0)
+                lap.record(StageProfiler::stFusion);
 
+                // Hand the plot data over; the render scheduler takes it into the plots on its next tick
+                if (trendPlot)
                 {
-                    if (indexTemp == 0)
-                    {
-                        for (unsigned int i = 0; i < NUM_PTS_DISTANCE_TIME_PLOT; i++)
-                        {
-                            xDistTimePlot[i] = indexTemp;
-                            yDistTimePlot[i] = phaseWfm_Out;
-                            heartWfmBuffer[i] = heartWfm_Out;
-                            breathingWfmBuffer[indexTemp] = breathWfm_Out;
-                        }
-                    }
+                    double now = QDateTime::currentMSecsSinceEpoch()/1000.0;
+                    if (heartRate_Out != 0 && !motionArtifact)
+                        heartTrendFeed.append(now, heartRate_Out);
+                    if (BreathingRate_Out != 0 && !motionArtifact)
+                        breathingTrendFeed.append(now, BreathingRate_Out);
+                    if (!motionArtifact)
+                        rcsTrendFeed.append(now, maxRCS_updated);
+                }
+                double frameTime = globalCountOut*FRAME_PERIOD_S;
+                phaseFeed.append(frameTime, phaseWfm_Out);
+                breathingFeed.append(frameTime, breathWfm_Out);
+                heartFeed.append(frameTime, heartWfm_Out);
+                rangeProfileFeed.publish(xRangePlot, yRangePlot);
+                if (snapshots)
+                {
+                    snapshots->feed(0, SnapshotRenderer::chPhase)->append(frameTime, phaseWfm_Out);
+                    snapshots->feed(0, SnapshotRenderer::chBreathing)->append(frameTime, breathWfm_Out);
+                    snapshots->feed(0, SnapshotRenderer::chHeart)->append(frameTime, heartWfm_Out);
+                    snapshots->feed(0, SnapshotRenderer::chRangeProfile)->publish(xRangePlot, yRangePlot);
+                }
+                if (rangeTimePlot && yRangePlot.size() > 1)
+                    rangeTimeMap.append(frameTime, yRangePlot, xRangePlot.first(), xRangePlot.last());
 
-                    double max = *std::max_element(breathingWfmBuffer.constBegin(), breathingWfmBuffer.constEnd());
-                    double min = *std::min_element(breathingWfmBuffer.constBegin(), breathingWfmBuffer.constEnd());
+                // Feeds are consumed even while plotting is off, so they never back up
+                renderScheduler->setRedrawEnabled(ui->checkBox_displayPlots->isChecked());
+                renderScheduler->markAllDirty();
+                lap.record(StageProfiler::stHandover);
 
-                    double breathingWfm_display_max, breathingWfm_display_min;
+                // Update the readouts; only those whose shown value or alarm changed touch a widget
+                readouts->setValue(roFrameCount, (int)globalCountOut);
+                qCDebug(lcReadouts) << "Raw Frame Count:" << (int)globalCountOut << "Displayed Frame Count:" << readouts->text(roFrameCount);
 
-                    if (max < BREATHING_PLOT_MAX_YAXIS)
-                        breathingWfm_display_max = BREATHING_PLOT_MAX_YAXIS;
-                    else
-                        breathingWfm_display_max = max;
+                readouts->setValue(roBreathingRate, BreathingRate_Out);
+                qCDebug(lcReadouts) << "Raw Breathing Rate:" << BreathingRate_Out << "Displayed Breathing Rate:" << readouts->text(roBreathingRate);
 
-                    if (min > -BREATHING_PLOT_MAX_YAXIS)
-                        breathingWfm_display_min = -BREATHING_PLOT_MAX_YAXIS;
-                    else
-                        breathingWfm_display_min = min;
+                readouts->setValue(roHeartRate, heartRate_Out);
+                qCDebug(lcReadouts) << "Raw Heart Rate:" << heartRate_Out << "Displayed Heart Rate:" << readouts->text(roHeartRate);
 
-                    xDistTimePlot[indexTemp] = indexTemp;
-                    yDistTimePlot[indexTemp] = phaseWfm_Out;
-                    breathingWfmBuffer[indexTemp] = breathWfm_Out;
-                    heartWfmBuffer[indexTemp] = heartWfm_Out;
+                readouts->setValue(roRangeBinIndex, rangeBinIndexOut);
+                qCDebug(lcReadouts) << "Raw Range Bin Index:" << rangeBinIndexOut << "Displayed Range Bin Index:" << readouts->text(roRangeBinIndex);
 
-                    ui->phaseWfmPlot->yAxis->setRange(-10, 10);
-                    ui->phaseWfmPlot->graph(0)->setData(xDistTimePlot, yDistTimePlot);
-                    ui->phaseWfmPlot->yAxis->rescale();
-                    ui->phaseWfmPlot->replot();
+                readouts->setValue(roMotion, outMotionDetectionFlag);
+                qCDebug(lcReadouts) << "Raw Motion Detection Flag:" << outMotionDetectionFlag << "Displayed Motion Detection Flag:" << readouts->text(roMotion);
+                readouts->setAlarm(roMotion, motionArtifact);
 
-                    ui->BreathingWfmPlot->graph(0)->setData(xDistTimePlot, breathingWfmBuffer);
-                    ui->BreathingWfmPlot->yAxis->setRangeLower(breathingWfm_display_min);
-                    ui->BreathingWfmPlot->yAxis->setRangeUpper(breathingWfm_display_max);
-                    ui->BreathingWfmPlot->replot();
+                // The estimator readouts freeze with the rates during an artifact
+                if (!motionArtifact)
+                {
+                    readouts->setValue(roBreathPeak, BreathingRatePK_Out);
+                    qCDebug(lcReadouts) << "Raw Breathing Rate Peak:" << BreathingRatePK_Out << "Displayed Breathing Rate Peak:" << readouts->text(roBreathPeak);
 
-                    ui->heartWfmPlot->graph(0)->setData(xDistTimePlot, heartWfmBuffer);
-                    ui->heartWfmPlot->replot();
+                    readouts->setValue(roHeartPeak, heartRate_Pk);
+                    qCDebug(lcReadouts) << "Raw Heart Rate Peak:" << heartRate_Pk << "Displayed Heart Rate Peak:" << readouts->text(roHeartPeak);
 
-                    ui->plot_RangeProfile->graph(0)->setData(xRangePlot, yRangePlot);
-                    ui->plot_RangeProfile->xAxis->setRange(demoParams.rangeStartMeters, demoParams.rangeEndMeters);
+                    readouts->setValue(roBreathFFT, BreathingRate_FFT);
+                    qCDebug(lcReadouts) << "Raw Breathing Rate FFT:" << BreathingRate_FFT << "Displayed Breathing Rate FFT:" << readouts->text(roBreathFFT);
 
-                    if (maxRCS < (ui->SpinBox_RCS->value()))
-                    {
-                        ui->plot_RangeProfile->yAxis->setRangeUpper(ui->SpinBox_RCS->value());
-                    }
-                    else
-                    {
-                        ui->plot_RangeProfile->yAxis->setRangeUpper(maxRCS);
-                    }
+                    readouts->setValue(roHeartFFT, heartRate_FFT);
+                    qCDebug(lcReadouts) << "Raw Heart Rate FFT:" << heartRate_FFT << "Displayed Heart Rate FFT:" << readouts->text(roHeartFFT);
 
-                    ui->plot_RangeProfile->replot();
-                }
+                    readouts->setValue(roBreathCM, breathRate_CM);
+                    qCDebug(lcReadouts) << "Raw Breath Rate CM:" << breathRate_CM << "Displayed Breath Rate CM:" << readouts->text(roBreathCM);
 
-                // Update all LCD displays with debug output
-                ui->lcdNumber_FrameCount->display((int)globalCountOut);
-                qDebug() << "Raw Frame Count:" << globalCountOut << "Displayed Frame Count:" << QString::number((int)globalCountOut);
-
-                QString myString_BreathRate;
-                ui->lcdNumber_Breathingrate->setDigitCount(8);
-                myString_BreathRate = QString::number(BreathingRate_Out, 'f', 0); // Alternative formatting
-                ui->lcdNumber_Breathingrate->display(myString_BreathRate);
-                qDebug() << "Raw Breathing Rate:" << BreathingRate_Out << "Displayed Breathing Rate:" << myString_BreathRate;
-
-                QString myString_HeartRate;
-                ui->lcdNumber_HeartRate->setDigitCount(3);
-                myString_HeartRate = QString::number(heartRate_Out, 'f', 0); // Alternative formatting
-                ui->lcdNumber_HeartRate->display(myString_HeartRate);
-                qDebug() << "Raw Heart Rate:" << heartRate_Out << "Displayed Heart Rate:" << myString_HeartRate;
-
-                QString myString_RangeBinIndex;
-                ui->lcdNumber_Index->setDigitCount(8);
-                myString_RangeBinIndex = QString::number(rangeBinIndexOut);
-                ui->lcdNumber_Index->display(myString_RangeBinIndex);
-                qDebug() << "Raw Range Bin Index:" << rangeBinIndexOut << "Displayed Range Bin Index:" << myString_RangeBinIndex;
-
-                QString myString_BreathingRatePK_Out;
-                ui->lcdNumber_Breath_pk->setDigitCount(8);
-                myString_BreathingRatePK_Out = QString::number(BreathingRatePK_Out, 'f', 0);
-                ui->lcdNumber_Breath_pk->display(myString_BreathingRatePK_Out);
-                qDebug() << "Raw Breathing Rate Peak:" << BreathingRatePK_Out << "Displayed Breathing Rate Peak:" << myString_BreathingRatePK_Out;
-
-                QString myString_heartRate_Pk;
-                ui->lcdNumber_Heart_pk->setDigitCount(8);
-                myString_heartRate_Pk = QString::number(heartRate_Pk, 'f', 0);
-                ui->lcdNumber_Heart_pk->display(myString_heartRate_Pk);
-                qDebug() << "Raw Heart Rate Peak:" << heartRate_Pk << "Displayed Heart Rate Peak:" << myString_heartRate_Pk;
-
-                QString myString_BreathingRate_FFT;
-                ui->lcdNumber_Breath_FT->setDigitCount(8);
-                myString_BreathingRate_FFT = QString::number(BreathingRate_FFT, 'f', 0);
-                ui->lcdNumber_Breath_FT->display(myString_BreathingRate_FFT);
-                qDebug() << "Raw Breathing Rate FFT:" << BreathingRate_FFT << "Displayed Breathing Rate FFT:" << myString_BreathingRate_FFT;
-
-                QString myString_HeartRate_FFT;
-                ui->lcdNumber_Heart_FT->setDigitCount(8);
-                myString_HeartRate_FFT = QString::number(heartRate_FFT, 'f', 0);
-                ui->lcdNumber_Heart_FT->display(myString_HeartRate_FFT);
-                qDebug() << "Raw Heart Rate FFT:" << heartRate_FFT << "Displayed Heart Rate FFT:" << myString_HeartRate_FFT;
-
-                QString myString_breathRate_CM;
-                ui->lcdNumber_CM_Breath->setDigitCount(8);
-                myString_breathRate_CM = QString::number(breathRate_CM, 'f', 3);
-                ui->lcdNumber_CM_Breath->display(myString_breathRate_CM);
-                qDebug() << "Raw Breath Rate CM:" << breathRate_CM << "Displayed Breath Rate CM:" << myString_breathRate_CM;
-
-                QString myString_heartRate_CM;
-                ui->lcdNumber_CM_Heart->setDigitCount(8);
-                myString_heartRate_CM = QString::number(heartRate_CM, 'f', 3);
-                ui->lcdNumber_CM_Heart->display(myString_heartRate_CM);
-                qDebug() << "Raw Heart Rate CM:" << heartRate_CM << "Displayed Heart Rate CM:" << myString_heartRate_CM;
-
-                QString myString_heartRate_4Hz_CM;
-                ui->lcdNumber_Display4->setDigitCount(8);
-                myString_heartRate_4Hz_CM = QString::number(heartRate_4Hz_CM, 'f', 3);
-                ui->lcdNumber_Display4->display(myString_heartRate_4Hz_CM);
-                qDebug() << "Raw Heart Rate 4Hz CM:" << heartRate_4Hz_CM << "Displayed Heart Rate 4Hz CM:" << myString_heartRate_4Hz_CM;
-
-                QString myString_Breathing_WfmEnergy;
-                ui->lcdNumber_BreathEnergy->setDigitCount(8);
-                myString_Breathing_WfmEnergy = QString::number(outSumEnergyBreathWfm, 'f', 3);
-                ui->lcdNumber_BreathEnergy->display(myString_Breathing_WfmEnergy);
-                qDebug() << "Raw Breathing Waveform Energy:" << outSumEnergyBreathWfm << "Displayed Breathing Waveform Energy:" << myString_Breathing_WfmEnergy;
-
-                QString myString_Heart_WfmEnergy;
-                ui->lcdNumber_HeartEnergy->setDigitCount(8);
-                myString_Heart_WfmEnergy = QString::number(outSumEnergyHeartWfm, 'f', 3);
-                ui->lcdNumber_HeartEnergy->display(myString_Heart_WfmEnergy);
-                qDebug() << "Raw Heart Waveform Energy:" << outSumEnergyHeartWfm << "Displayed Heart Waveform Energy:" << myString_Heart_WfmEnergy;
-
-                QString myString_RCS;
-                ui->lcdNumber_RCS->setDigitCount(8);
-                myString_RCS = QString::number(maxRCS_updated, 'f', 0);
-                ui->lcdNumber_RCS->display(myString_RCS);
-                qDebug() << "Raw RCS:" << maxRCS_updated << "Displayed RCS:" << myString_RCS;
-
-                QString myString_xCorr;
-                ui->lcdNumber_Heart_xCorr->setDigitCount(8);
-                myString_xCorr = QString::number(heartRate_xCorr, 'f', 0);
-                ui->lcdNumber_Heart_xCorr->display(myString_xCorr);
-                qDebug() << "Raw Heart Rate xCorr:" << heartRate_xCorr << "Displayed Heart Rate xCorr:" << myString_xCorr;
-
-                QString myString_FFT_4Hz;
-                ui->lcdNumber_Heart_FT_4Hz->setDigitCount(8);
-                myString_FFT_4Hz = QString::number(heartRate_FFT_4Hz, 'f', 0);
-                ui->lcdNumber_Heart_FT_4Hz->display(myString_FFT_4Hz);
-                qDebug() << "Raw Heart Rate FFT 4Hz:" << heartRate_FFT_4Hz << "Displayed Heart Rate FFT 4Hz:" << myString_FFT_4Hz;
-
-                QString myString_Reserved_1;
-                ui->lcdNumber_Display3->setDigitCount(8);
-                myString_Reserved_1 = QString::number(outMotionDetectionFlag, 'f', 3);
-                ui->lcdNumber_Display3->display(myString_Reserved_1);
-                qDebug() << "Raw Motion Detection Flag:" << outMotionDetectionFlag << "Displayed Motion Detection Flag:" << myString_Reserved_1;
-                if (outMotionDetectionFlag == 1)
-                {
-                    ui->lcdNumber_Display3->setAutoFillBackground(true);
-                    ui->lcdNumber_Display3->setPalette(Qt::red);
-                }
-                else
-                {
-                    ui->lcdNumber_Display3->setPalette(Qt::white);
+                    readouts->setValue(roHeartCM, heartRate_CM);
+                    qCDebug(lcReadouts) << "Raw Heart Rate CM:" << heartRate_CM << "Displayed Heart Rate CM:" << readouts->text(roHeartCM);
+
+                    readouts->setValue(roHeart4HzCM, heartRate_4Hz_CM);
+                    qCDebug(lcReadouts) << "Raw Heart Rate 4Hz CM:" << heartRate_4Hz_CM << "Displayed Heart Rate 4Hz CM:" << readouts->text(roHeart4HzCM);
+
+                    readouts->setValue(roBreathEnergy, outSumEnergyBreathWfm);
+                    qCDebug(lcReadouts) << "Raw Breathing Waveform Energy:" << outSumEnergyBreathWfm << "Displayed Breathing Waveform Energy:" << readouts->text(roBreathEnergy);
+
+                    readouts->setValue(roHeartEnergy, outSumEnergyHeartWfm);
+                    qCDebug(lcReadouts) << "Raw Heart Waveform Energy:" << outSumEnergyHeartWfm << "Displayed Heart Waveform Energy:" << readouts->text(roHeartEnergy);
+
+                    readouts->setValue(roRCS, maxRCS_updated);
+                    qCDebug(lcReadouts) << "Raw RCS:" << maxRCS_updated << "Displayed RCS:" << readouts->text(roRCS);
+
+                    readouts->setValue(roHeartXCorr, heartRate_xCorr);
+                    qCDebug(lcReadouts) << "Raw Heart Rate xCorr:" << heartRate_xCorr << "Displayed Heart Rate xCorr:" << readouts->text(roHeartXCorr);
+
+                    readouts->setValue(roHeartFFT4Hz, heartRate_FFT_4Hz);
+                    qCDebug(lcReadouts) << "Raw Heart Rate FFT 4Hz:" << heartRate_FFT_4Hz << "Displayed Heart Rate FFT 4Hz:" << readouts->text(roHeartFFT4Hz);
+
+                    readouts->setValue(roHeartXCorrCM, heartRate_xCorr_CM);
+                    qCDebug(lcReadouts) << "Raw Heart Rate xCorr CM:" << heartRate_xCorr_CM << "Displayed Heart Rate xCorr CM:" << readouts->text(roHeartXCorrCM);
+
+                    readouts->setValue(roBreathXCorrCM, BreathingRate_xCorr_CM);
+                    qCDebug(lcReadouts) << "Raw Breathing Rate xCorr CM:" << BreathingRate_xCorr_CM << "Displayed Breathing Rate xCorr CM:" << readouts->text(roBreathXCorrCM);
+
+                    readouts->setValue(roRmssd, hrvAnalyzer.rmssd());
+
+                    readouts->setValue(roSdnn, hrvAnalyzer.sdnn());
+
+                    readouts->setValue(roBreathHarmEnergy, BreathingRate_HarmEnergy);
+                    qCDebug(lcReadouts) << "Raw Breathing Rate Harm Energy:" << BreathingRate_HarmEnergy << "Displayed Breathing Rate Harm Energy:" << readouts->text(roBreathHarmEnergy);
+
+                    readouts->setValue(roBreathXCorr, BreathingRate_xCorr);
+                    qCDebug(lcReadouts) << "Raw Breathing Rate xCorr:" << BreathingRate_xCorr << "Displayed Breathing Rate xCorr:" << readouts->text(roBreathXCorr);
                 }
+                lap.record(StageProfiler::stReadouts);
 
-                QString myString_heartRate_FFT_4Hz;
-                ui->lcdNumber_Heart_FT_4Hz->setDigitCount(8);
-                myString_heartRate_FFT_4Hz = QString::number(heartRate_FFT_4Hz, 'f', 3);
-                ui->lcdNumber_Heart_FT_4Hz->display(myString_heartRate_FFT_4Hz);
-                qDebug() << "Raw Heart Rate FFT 4Hz (second update):" << heartRate_FFT_4Hz << "Displayed Heart Rate FFT 4Hz (second update):" << myString_heartRate_FFT_4Hz;
-
-                QString myString_CM_heart_xCorr;
-                ui->lcdNumber_CM_Heart_xCorr->setDigitCount(8);
-                myString_CM_heart_xCorr = QString::number(heartRate_xCorr_CM, 'f', 3);
-                ui->lcdNumber_CM_Heart_xCorr->display(myString_CM_heart_xCorr);
-                qDebug() << "Raw Heart Rate xCorr CM:" << heartRate_xCorr_CM << "Displayed Heart Rate xCorr CM:" << myString_CM_heart_xCorr;
-
-                QString myString_CM_breath_xCorr;
-                ui->lcdNumber_CM_Breath_xCorr->setDigitCount(8);
-                myString_CM_breath_xCorr = QString::number(BreathingRate_xCorr_CM, 'f', 3);
-                ui->lcdNumber_CM_Breath_xCorr->display(myString_CM_breath_xCorr);
-                qDebug() << "Raw Breathing Rate xCorr CM:" << BreathingRate_xCorr_CM << "Displayed Breathing Rate xCorr CM:" << myString_CM_breath_xCorr;
-
-                QString myString_breathRate_harmEnergy;
-                ui->lcdNumber_breathRate_HarmEnergy->setDigitCount(8);
-                myString_breathRate_harmEnergy = QString::number(BreathingRate_HarmEnergy, 'f', 3);
-                ui->lcdNumber_breathRate_HarmEnergy->display(myString_breathRate_harmEnergy);
-                qDebug() << "Raw Breathing Rate Harm Energy:" << BreathingRate_HarmEnergy << "Displayed Breathing Rate Harm Energy:" << myString_breathRate_harmEnergy;
-
-                QString myString_breathRate_xCorr;
-                ui->lcdNumber_Breath_xCorr->setDigitCount(8);
-                myString_breathRate_xCorr = QString::number(BreathingRate_xCorr, 'f', 3);
-                ui->lcdNumber_Breath_xCorr->display(myString_breathRate_xCorr);
-                qDebug() << "Raw Breathing Rate xCorr:" << BreathingRate_xCorr << "Displayed Breathing Rate xCorr:" << myString_breathRate_xCorr;
-
-                // Force GUI update after all LCD updates
-                qApp->processEvents();
             }
         }
     }
 }
+void MainWindow::drainFeed(PlotFeed &feed, StripChart &strip, WindowExtrema *extrema)
+{
+    feedSamples.resize(0);
+    feed.take(&feedSamples);
+    for (int i = 0; i < feedSamples.size(); i++)
+    {
+        strip.append(feedSamples.at(i).key, feedSamples.at(i).value);
+        if (extrema)
+            extrema->append(feedSamples.at(i).key, feedSamples.at(i).value);
+    }
+}
+
+void MainWindow::drainTrend(PlotFeed &feed, TrendPlottable *trend)
+{
+    feedSamples.resize(0);
+    feed.take(&feedSamples);
+    for (int i = 0; i < feedSamples.size(); i++)
+        trend->addData(feedSamples.at(i).key, feedSamples.at(i).value);
+}
+
+// Copies a waveform plot's graph, axis ranges and labels onto a report page
+static void copyWaveformPage(QCustomPlot *source, const QString &title, QCustomPlot *page)
+{
+    QCPFloatGraph *graph = new QCPFloatGraph(page->xAxis, page->yAxis);
+    QCPFloatGraph *strip = qobject_cast<QCPFloatGraph*>(source->graph(0));
+    graph->floatData()->set(*strip->floatData());
+    graph->setKeyOrigin(strip->keyOrigin());
+    graph->setPen(source->graph(0)->pen());
+    page->xAxis->setRange(source->xAxis->range());
+    page->xAxis->setLabel(source->xAxis->label());
+    page->yAxis->setRange(source->yAxis->range());
+    page->yAxis->setLabel(source->yAxis->label());
+    page->plotLayout()->insertRow(0);
+    page->plotLayout()->addElement(0, 0, new QCPTextElement(page, title));
+}
+
+static void copyTrend(TrendPlottable *source, TrendPlottable *trend)
+{
+    const MinMaxPyramid &samples = source->pyramid();
+    for (int i = 0; i < samples.size(); i++)
+        trend->addData(samples.key(i), samples.value(i));
+    trend->setName(source->name());
+    trend->setPen(source->pen());
+}
+
+void MainWindow::exportSessionReport()
+{
+    // One page per waveform, plus the session trends when they are shown, written to report/directory
+    // as report/format (pdf, png, jpg...) files named after the stop time
+    QString directory = settings.value("report/directory").toString();
+    if (directory.isEmpty())
+        return;
+    QString suffix = "." + settings.value("report/format", "pdf").toString();
+    QString stem = QDir(directory).filePath(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + "_");
+
+    // take what is still in the feeds into the plots first
+    renderScheduler->markAllDirty();
+    renderScheduler->tick();
+
+    ReportExporter exporter;
+    exporter.setPageSize(QSize(1000, 400));
+    exporter.addPage(stem + "displacement" + suffix, [this](QCustomPlot *page) {
+        copyWaveformPage(ui->phaseWfmPlot, "Chest Displacement", page);
+    });
+    exporter.addPage(stem + "breathing" + suffix, [this](QCustomPlot *page) {
+        copyWaveformPage(ui->BreathingWfmPlot, "Breathing Waveform", page);
+    });
+    exporter.addPage(stem + "heart" + suffix, [this](QCustomPlot *page) {
+        copyWaveformPage(ui->heartWfmPlot, "Heart Waveform", page);
+    });
+    if (trendPlot)
+    {
+        exporter.addPage(stem + "trends" + suffix, [this](QCustomPlot *page) {
+            copyTrend(heartTrend, new TrendPlottable(page->xAxis, page->yAxis));
+            copyTrend(breathingTrend, new TrendPlottable(page->xAxis, page->yAxis));
+            copyTrend(rcsTrend, new TrendPlottable(page->xAxis, page->yAxis2));
+            QSharedPointer<QCPAxisTickerDateTime> timeTicker(new QCPAxisTickerDateTime);    // pages share nothing
+            timeTicker->setDateTimeFormat("hh:mm");
+            page->xAxis->setTicker(timeTicker);
+            page->xAxis->setRange(trendPlot->xAxis->range());
+            page->yAxis->setRange(trendPlot->yAxis->range());
+            page->yAxis->setLabel(trendPlot->yAxis->label());
+            page->yAxis2->setRange(trendPlot->yAxis2->range());
+            page->yAxis2->setLabel(trendPlot->yAxis2->label());
+            page->yAxis2->setVisible(true);
+            page->legend->setVisible(true);
+        });
+    }
+    int written = exporter.exportAll();
+    qCInfo(lcApp) << "Session report:" << written << "of" << exporter.pageCount() << "pages written to" << directory;
+}
+
 void MainWindow::on_pushButton_stop_clicked()
 {
     serialWrite->write("sensorStop\n");
     ui->checkBox_LoadConfig->setChecked(true);
     current_gui_status = gui_stopped;
     emit gui_statusChanged();
+    exportSessionReport();
 }
 void MainWindow::gui_statusUpdate()
 {
@@ -1145,7 +1315,7 @@ void MainWindow::gui_statusUpdate()
         ui->pushButton_start->setStyleSheet("background-color: none");
         ui->pushButton_pause->setStyleSheet("background-color: none");
         statusBar()->showMessage(tr("Sensor Stopped"));
-        qDebug()<<"Sensor is Stopped";
+        qCInfo(lcApp)<<"Sensor is Stopped";
         statusBar()->showMessage(tr("Sensor Stopped"));
     }
     if (current_gui_status == gui_paused)
@@ -1160,13 +1330,16 @@ void MainWindow::gui_statusUpdate()
 void MainWindow::on_pushButton_pause_clicked()
 {
     localCount = 0;
-    for (unsigned int i=0; i<NUM_PTS_DISTANCE_TIME_PLOT; i++)
-    {
-        xDistTimePlot[i]=0;
-        yDistTimePlot[i]=0;
-        heartWfmBuffer[i] = 0;
-        breathingWfmBuffer[i] = 0;
-    }
+    // drop what the feeds still hold along with the strips
+    drainFeed(phaseFeed, phaseStrip, 0);
+    drainFeed(breathingFeed, breathingStrip, 0);
+    drainFeed(heartFeed, heartStrip, 0);
+    phaseStrip.clear();
+    breathingStrip.clear();
+    heartStrip.clear();
+    phaseExtrema.clear();
+    breathingExtrema.clear();
+    rangeTimeMap.clear();
     current_gui_status = gui_paused;
     emit gui_statusChanged();
 }
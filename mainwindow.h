@@ -4,6 +4,20 @@
 #include <QMainWindow>
 #include <QFile>
 #include <QSerialPort>
+#include "biquadfilterbank.h"
+#include "heartratefusion.h"
+#include "hrvanalyzer.h"
+#include "latencyoverlay.h"
+#include "motiondetector.h"
+#include "plotfeed.h"
+#include "rangetimemap.h"
+#include "readoutpanel.h"
+#include "renderscheduler.h"
+#include "snapshotrenderer.h"
+#include "stageprofiler.h"
+#include "stripchart.h"
+#include "trendplottable.h"
+#include "windowextrema.h"
 
 
 namespace Ui {
@@ -20,17 +34,48 @@ public:
 
 private:
     Ui::MainWindow *ui;
-    QVector<double> xDistTimePlot, yDistTimePlot;
-    QVector<double> breathingWfmBuffer, heartWfmBuffer;
+    StripChart phaseStrip, breathingStrip, heartStrip;
+    WindowExtrema phaseExtrema, breathingExtrema;   // y autoscaling over the strip window
+    PlotFeed phaseFeed, breathingFeed, heartFeed;   // frame path -> render tick; the plots only see what comes through these
+    PlotFeed rangeProfileFeed;
+    PlotFeed heartTrendFeed, breathingTrendFeed, rcsTrendFeed;
+    QVector<QCPGraphData> feedSamples;
+    QVector<double> xRangePlot, yRangePlot;
+    double rangeProfileMax;
     QPalette lcdpaletteBreathing, lcdpaletteNotBreathing;
     uint32_t localCount;
-    uint32_t currIndex;
     bool FLAG_PAUSE;
     bool AUTO_DETECT_COM_PORTS;
     QByteArray dataBuffer;              // DataBuffer for storing the Serial Data
     int indexBuffer = 0;
     QString dataPortNum, userPortNum;   // Serial Port configuration
     QString platform_EVM;               // Radar Device
+    HeartRateFusion heartRateFusion;    // Heart-rate estimator selection, loaded with the profile
+    MotionDetector motionDetector;      // Host-side motion-artifact segmentation of the tracked target
+    MotionDetectorBank binMotion;       // The same, per processed range bin
+    float heldBreathingRate, heldHeartRate;     // last clean rates, shown during an artifact
+    bool breathingAbnormal, heartAbnormal;      // abnormal rate already logged
+    HrvAnalyzer hrvAnalyzer;            // Beat-to-beat intervals from the heart waveform
+    BiquadFilterBank waveformFilter;    // Optional DC removal on the breathing/heart waveforms
+    bool conditionWaveforms;
+    RenderScheduler *renderScheduler;   // Fixed-rate plot redraws, decoupled from frame arrival
+    ReadoutPanel *readouts;             // Change-driven LCD updates, optionally painted in one widget
+    QCustomPlot *trendPlot;             // Whole-session rate/RCS trends, when enabled
+    TrendPlottable *heartTrend, *breathingTrend, *rcsTrend;
+    double trendShownUpper;
+    QCustomPlot *rangeTimePlot;         // Range profiles over time, when enabled
+    RangeTimeMap rangeTimeMap;
+    SnapshotRenderer *snapshots;        // Plot images for a remote dashboard, when configured
+    StageProfiler profiler;             // Latency histograms of the frame path, from serial read to paint
+    LatencyOverlay *latencyOverlay;     // On-screen p50/p99/max per stage, when enabled
+
+    enum ReadoutId {
+        roBreathingRate, roHeartRate, roAbnormalBreath, roAbnormalHeart,
+        roFrameCount, roRangeBinIndex, roReliability, roRCS, roMotion,
+        roBreathPeak, roBreathFFT, roBreathXCorr, roBreathHarmEnergy, roBreathEnergy, roBreathCM, roBreathXCorrCM,
+        roHeartPeak, roHeartFFT, roHeartFFT4Hz, roHeartXCorr, roHeartEnergy, roHeartCM, roHeart4HzCM, roHeartXCorrCM,
+        roRmssd, roSdnn
+    };
 
     struct CfgParams {
     float rangeStartMeters;
@@ -52,6 +97,9 @@ private:
     float AGC_thresh;
     } demoParams;
 
+    void drainFeed(PlotFeed &feed, StripChart &strip, WindowExtrema *extrema);
+    void drainTrend(PlotFeed &feed, TrendPlottable *trend);
+    void exportSessionReport();
 
 private slots:
     void    serialRecieved();
@@ -68,6 +116,7 @@ private slots:
     void on_pushButton_stop_clicked();
     void on_pushButton_pause_clicked();
     void on_pushButton_Refresh_clicked();
+    void on_checkBox_Kalman_toggled(bool checked);
     //void on_pushButton_settings_clicked();
     void gui_statusUpdate();
     void resizeEvent(QResizeEvent *event);
@@ -0,0 +1,137 @@
+#include "minmaxpyramid.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+MinMaxPyramid::MinMaxPyramid() :
+    mKeyOrigin(0)
+{
+}
+
+void MinMaxPyramid::clear()
+{
+    mKeys.clear();
+    mValues.clear();
+    mMins.clear();
+    mMaxs.clear();
+}
+
+void MinMaxPyramid::reserve(int size)
+{
+    mKeys.reserve(size);
+    mValues.reserve(size);
+}
+
+bool MinMaxPyramid::append(double key, float value)
+{
+    if (std::isnan(value))
+        return false;
+    if (mKeys.isEmpty())
+        mKeyOrigin = key;
+    const float relativeKey = float(key - mKeyOrigin);
+    if (!mKeys.isEmpty() && relativeKey < mKeys.last())
+        return false;
+
+    mKeys.append(relativeKey);
+    mValues.append(value);
+
+    // fold the new sample into the last block of every level
+    int index = mValues.size() - 1;
+    for (int level = 0; ; level++)
+    {
+        const QVector<float> &belowMins = (level == 0) ? mValues : mMins.at(level - 1);
+        const QVector<float> &belowMaxs = (level == 0) ? mValues : mMaxs.at(level - 1);
+        if (belowMins.size() < 2)
+            break;
+        if (level == mMins.size())
+        {
+            // the level below just got its second entry; start this one from its first
+            mMins.append(QVector<float>(1, belowMins.first()));
+            mMaxs.append(QVector<float>(1, belowMaxs.first()));
+        }
+
+        index /= MINMAX_PYRAMID_FANOUT;
+        QVector<float> &mins = mMins[level];
+        QVector<float> &maxs = mMaxs[level];
+        if (index == mins.size())
+        {
+            mins.append(value);
+            maxs.append(value);
+        }
+        else
+        {
+            mins[index] = std::min(mins.at(index), value);
+            maxs[index] = std::max(maxs.at(index), value);
+        }
+    }
+    return true;
+}
+
+int MinMaxPyramid::lowerBound(double key, int from) const
+{
+    // round like append does, so the key of a sample finds that sample
+    const float *keys = mKeys.constData();
+    return int(std::lower_bound(keys + from, keys + mKeys.size(), float(key - mKeyOrigin)) - keys);
+}
+
+bool MinMaxPyramid::envelope(int begin, int end, float *min, float *max) const
+{
+    begin = std::max(begin, 0);
+    end = std::min(end, size());
+    if (begin >= end)
+        return false;
+
+    float lo = std::numeric_limits<float>::infinity();
+    float hi = -std::numeric_limits<float>::infinity();
+    const float *mins = mValues.constData();
+    const float *maxs = mValues.constData();
+    for (int level = 0; ; level++)
+    {
+        // partial blocks at both ends on this level, whole blocks one level up
+        while (begin < end && begin % MINMAX_PYRAMID_FANOUT)
+        {
+            lo = std::min(lo, mins[begin]);
+            hi = std::max(hi, maxs[begin]);
+            begin++;
+        }
+        while (end > begin && end % MINMAX_PYRAMID_FANOUT)
+        {
+            end--;
+            lo = std::min(lo, mins[end]);
+            hi = std::max(hi, maxs[end]);
+        }
+        if (begin >= end)
+            break;
+        begin /= MINMAX_PYRAMID_FANOUT;
+        end /= MINMAX_PYRAMID_FANOUT;
+        mins = mMins.at(level).constData();
+        maxs = mMaxs.at(level).constData();
+    }
+    *min = lo;
+    *max = hi;
+    return true;
+}
+
+int MinMaxPyramid::columnEnvelopes(double keyLower, double keyUpper, int columns, float *mins, float *maxs) const
+{
+    if (columns <= 0)
+        return 0;
+    const double width = (keyUpper - keyLower)/columns;
+    int found = 0;
+    int begin = lowerBound(keyLower);
+    for (int column = 0; column < columns; column++)
+    {
+        int end = (column == columns - 1) ? lowerBound(keyUpper, begin) : lowerBound(keyLower + (column + 1)*width, begin);
+        if (envelope(begin, end, mins + column, maxs + column))
+        {
+            found++;
+        }
+        else
+        {
+            mins[column] = 1;
+            maxs[column] = 0;
+        }
+        begin = end;
+    }
+    return found;
+}
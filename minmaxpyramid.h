@@ -0,0 +1,49 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QVector>
+
+// Min/max decimation pyramid over an append-only series with non-decreasing keys.
+//
+// Level 0 holds the samples; each level above holds the minimum and maximum of blocks of
+// MINMAX_PYRAMID_FANOUT entries of the level below, the last block of every level being updated as
+// samples are appended (O(log n) per sample, about n/3 extra entries). The envelope of any index
+// range is assembled from at most 2*(FANOUT-1) entries per level, so it costs O(log n), and the
+// envelopes of all pixel columns of a plot cost O(columns*log n) independently of the zoom.
+//
+// Keys are stored as floats relative to the first key appended (the session start for trends), so a
+// sample costs 8 bytes instead of 12; eight hours of seconds past the origin still resolve ~2 ms.
+
+#define MINMAX_PYRAMID_FANOUT   (4)
+
+class MinMaxPyramid
+{
+public:
+    MinMaxPyramid();
+
+    void clear();
+    void reserve(int size);
+    bool append(double key, float value);   // false (and ignored) if key decreases or value is NaN
+
+    int size() const { return mValues.size(); }
+    bool isEmpty() const { return mValues.isEmpty(); }
+    double key(int index) const { return mKeyOrigin + mKeys.at(index); }
+    float value(int index) const { return mValues.at(index); }
+    double firstKey() const { return mKeyOrigin + mKeys.first(); }
+    double lastKey() const { return mKeyOrigin + mKeys.last(); }
+
+    int lowerBound(double key, int from = 0) const;     // first index with a key >= key
+    bool envelope(int begin, int end, float *min, float *max) const;
+
+    // Envelope of each of columns equal key intervals splitting [keyLower, keyUpper); empty columns
+    // are reported with min > max. Returns the number of non-empty columns.
+    int columnEnvelopes(double keyLower, double keyUpper, int columns, float *mins, float *maxs) const;
+
+private:
+    double mKeyOrigin;
+    QVector<float> mKeys;   // relative to mKeyOrigin
+    QVector<float> mValues;
+    QVector<QVector<float> > mMins, mMaxs;  // [level-1][block]
+};
+
+#endif // MINMAXPYRAMID_H
@@ -0,0 +1,165 @@
+#include "motiondetector.h"
+#include <qmath.h>
+#include <cmath>
+
+#define MOTION_STATS_ALPHA      (0.02f)  // ~50 frame memory for the clean-frame statistics
+#define MOTION_RECOVERY_ALPHA   (0.2f)   // energy level follows quickly during motion to settle on the new pose
+#define MOTION_WARMUP_FRAMES    (20)
+#define MOTION_EPSILON          (1e-6f)
+#define MOTION_BIN_ENERGY_SCORE (6.0f)   // sigmas of a range bin's power; noise-only bins exceed it on ~0.1 % of frames
+
+MotionDetector::MotionDetector() :
+    mPhaseThreshold(6.0f),
+    mEnergyThreshold(0.5f),
+    mEnergyScoreThreshold(0),
+    mHoldFrames(20),
+    mWrapPhase(false)
+{
+    reset();
+}
+
+void MotionDetector::reset()
+{
+    mWarmupFrames = MOTION_WARMUP_FRAMES;
+    mPrevPhase = 0;
+    mPhaseDiffMean = 0;
+    mPhaseDiffVar = 0;
+    mEnergyMean = 0;
+    mEnergyVar = 0;
+    mQuietFrames = 0;
+    mInArtifact = false;
+    mSegmentClosed = false;
+    mSegment.startFrame = 0;
+    mSegment.endFrame = 0;
+    mArtifactFrames = 0;
+    mSegmentCount = 0;
+}
+
+bool MotionDetector::update(quint32 frame, bool firmwareFlag, float phase, float energy)
+{
+    float phaseDiff = phase - mPrevPhase;
+    if (mWrapPhase)
+        phaseDiff = std::remainder(phaseDiff, 2.0f*float(M_PI));
+    phaseDiff = std::fabs(phaseDiff);
+    mPrevPhase = phase;
+
+    bool trigger = firmwareFlag;
+    if (mWarmupFrames > 0)
+    {
+        // learn the statistics before trusting them; the first frame has no phase difference
+        int k = MOTION_WARMUP_FRAMES - mWarmupFrames;
+        if (k > 0)
+        {
+            float delta = phaseDiff - mPhaseDiffMean;
+            mPhaseDiffMean += delta/k;
+            mPhaseDiffVar += (delta*(phaseDiff - mPhaseDiffMean) - mPhaseDiffVar)/k;
+            float energyDelta = energy - mEnergyMean;
+            mEnergyMean += energyDelta/(k + 1);
+            mEnergyVar += (energyDelta*(energy - mEnergyMean) - mEnergyVar)/(k + 1);
+        }
+        else
+        {
+            mEnergyMean = energy;
+            mEnergyVar = 0;
+        }
+        mWarmupFrames--;
+    }
+    else
+    {
+        float deviation = phaseDiff - mPhaseDiffMean;
+        float phaseScore = deviation/(std::sqrt(mPhaseDiffVar) + MOTION_EPSILON);
+        float energyDeviation = energy - mEnergyMean;
+        bool energyTrigger;
+        if (mEnergyScoreThreshold > 0)
+            energyTrigger = std::fabs(energyDeviation)/(std::sqrt(mEnergyVar) + MOTION_EPSILON) > mEnergyScoreThreshold;
+        else
+            energyTrigger = std::fabs(energyDeviation)/(mEnergyMean + MOTION_EPSILON) > mEnergyThreshold;
+        trigger = trigger || (phaseScore > mPhaseThreshold) || energyTrigger;
+
+        if (!trigger && !mInArtifact)
+        {
+            mPhaseDiffMean += MOTION_STATS_ALPHA*deviation;
+            mPhaseDiffVar = (1 - MOTION_STATS_ALPHA)*(mPhaseDiffVar + MOTION_STATS_ALPHA*deviation*deviation);
+            mEnergyMean += MOTION_STATS_ALPHA*energyDeviation;
+            mEnergyVar = (1 - MOTION_STATS_ALPHA)*(mEnergyVar + MOTION_STATS_ALPHA*energyDeviation*energyDeviation);
+        }
+        else
+        {
+            mEnergyMean += MOTION_RECOVERY_ALPHA*(energy - mEnergyMean);
+        }
+    }
+
+    mSegmentClosed = false;
+    if (trigger)
+    {
+        if (!mInArtifact)
+        {
+            mInArtifact = true;
+            mSegment.startFrame = frame;
+            mSegmentCount++;
+        }
+        mQuietFrames = 0;
+    }
+    else if (mInArtifact && ++mQuietFrames >= mHoldFrames)
+    {
+        mInArtifact = false;
+        mSegmentClosed = true;
+    }
+
+    if (mInArtifact)
+    {
+        mArtifactFrames++;
+        mSegment.endFrame = frame;
+    }
+    return mInArtifact;
+}
+
+void MotionDetectorBank::reset()
+{
+    for (int bin = 0; bin < mDetectors.size(); bin++)
+        mDetectors[bin].reset();
+}
+
+void MotionDetectorBank::update(quint32 frame, const QVector<double> &rangeProfile)
+{
+    int bins = rangeProfile.size()/2;
+    if (bins != mDetectors.size())
+    {
+        mDetectors.fill(MotionDetector(), bins);
+        for (int bin = 0; bin < bins; bin++)
+        {
+            mDetectors[bin].setWrapPhase(true);
+            mDetectors[bin].setEnergyScoreThreshold(MOTION_BIN_ENERGY_SCORE);
+        }
+    }
+    for (int bin = 0; bin < bins; bin++)
+    {
+        double im = rangeProfile.at(2*bin), re = rangeProfile.at(2*bin + 1);
+        mDetectors[bin].update(frame, false, float(std::atan2(im, re)), float(im*im + re*re));
+    }
+}
+
+bool MotionDetectorBank::isArtifactNear(int bin, int radius) const
+{
+    if (bin < 0 || bin >= mDetectors.size())
+        return false;
+    if (mDetectors.at(bin).isArtifact())
+        return true;
+    // neighbours weaker than the target bin are mostly noise, not the subject spreading over them
+    float targetPower = mDetectors.at(bin).energyMean();
+    int first = qMax(bin - radius, 0), last = qMin(bin + radius, mDetectors.size() - 1);
+    for (int i = first; i <= last; i++)
+    {
+        if (i != bin && mDetectors.at(i).isArtifact() && mDetectors.at(i).energyMean() >= targetPower)
+            return true;
+    }
+    return false;
+}
+
+int MotionDetectorBank::artifactBinCount() const
+{
+    int count = 0;
+    for (int bin = 0; bin < mDetectors.size(); bin++)
+        count += mDetectors.at(bin).isArtifact();
+    return count;
+}
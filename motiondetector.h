@@ -0,0 +1,82 @@
+#ifndef MOTIONDETECTOR_H
+#define MOTIONDETECTOR_H
+
+#include <QVector>
+
+// Streaming motion-artifact detector.
+//
+// A frame triggers when the firmware raises its motion flag, when the frame-to-frame phase change
+// is far outside its running distribution, or when the range-profile energy jumps away from its
+// running mean (or, with setEnergyScoreThreshold, from its running variance). A triggered frame opens an artifact segment, which stays open until no trigger
+// has been seen for holdFrames frames. The running statistics are exponentially weighted and are
+// only learned from clean frames, so every update is O(1) with a few floats of state.
+
+class MotionDetector
+{
+public:
+    struct Segment {
+        quint32 startFrame;
+        quint32 endFrame;       // last artifact frame, valid once the segment is closed
+    };
+
+    MotionDetector();
+
+    void setPhaseThreshold(float sigmas) { mPhaseThreshold = sigmas; }
+    void setEnergyThreshold(float relativeChange) { mEnergyThreshold = relativeChange; }
+    void setEnergyScoreThreshold(float sigmas) { mEnergyScoreThreshold = sigmas; }   // 0 tests the relative change
+    void setHoldFrames(int frames) { mHoldFrames = frames; }
+    void setWrapPhase(bool wrap) { mWrapPhase = wrap; }
+    void reset();
+
+    bool update(quint32 frame, bool firmwareFlag, float phase, float energy);
+
+    bool isArtifact() const { return mInArtifact; }
+    bool segmentClosed() const { return mSegmentClosed; }
+    const Segment &lastSegment() const { return mSegment; }
+    quint32 artifactFrameCount() const { return mArtifactFrames; }
+    quint32 segmentCount() const { return mSegmentCount; }
+    float energyMean() const { return mEnergyMean; }
+
+private:
+    float mPhaseThreshold, mEnergyThreshold, mEnergyScoreThreshold;
+    int mHoldFrames;
+    bool mWrapPhase;
+
+    int mWarmupFrames;
+    float mPrevPhase;
+    float mPhaseDiffMean, mPhaseDiffVar;
+    float mEnergyMean, mEnergyVar;
+    int mQuietFrames;
+    bool mInArtifact, mSegmentClosed;
+    Segment mSegment;
+    quint32 mArtifactFrames, mSegmentCount;
+};
+
+// One MotionDetector per processed range bin.
+//
+// update() takes the frame's complex range profile and feeds every bin's detector with that bin's
+// phase (wrapped) and energy; the firmware flag is not per bin and is left to the caller. The raw
+// power of a bin that only holds noise is exponentially distributed, so the bins test it as a
+// z-score against their running variance rather than as a change relative to the mean, which such
+// a bin would exceed on most frames. A person moving in one bin then no longer looks like motion of
+// a still subject in another, and isArtifactNear() asks whether the tracked bin, or a neighbour at
+// least as strong as it where the subject's own movement spreads, is inside an artifact segment.
+// Weaker neighbours are mostly noise and are ignored. A change in the number of bins restarts every
+// detector's warm-up.
+
+class MotionDetectorBank
+{
+public:
+    void reset();
+    void update(quint32 frame, const QVector<double> &rangeProfile);    // imaginary, real per bin
+
+    int binCount() const { return mDetectors.size(); }
+    bool isArtifact(int bin) const { return mDetectors.at(bin).isArtifact(); }
+    bool isArtifactNear(int bin, int radius) const;
+    int artifactBinCount() const;
+
+private:
+    QVector<MotionDetector> mDetectors;
+};
+
+#endif // MOTIONDETECTOR_H
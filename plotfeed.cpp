@@ -0,0 +1,85 @@
+#include "plotfeed.h"
+
+// The feed owns the snapshot containers; the shared pointers handed to the plots don't
+static void keepContainer(QCPGraphDataContainer *)
+{
+}
+
+PlotFeed::PlotFeed(int capacity) :
+    mHead(0),
+    mTail(0),
+    mDropped(0),
+    mSnapshot(0),
+    mRecycled(0),
+    mSpare(0),
+    mShown(0),
+    mReplaced(0)
+{
+    // a power of two, so the free-running indices wrap onto the slots with a mask
+    int size = 1;
+    while (size < capacity)
+        size *= 2;
+    mRing.resize(size);
+    mSlots = mRing.data();
+    mMask = quint32(size - 1);
+}
+
+PlotFeed::~PlotFeed()
+{
+    delete mSnapshot.fetchAndStoreAcquire(0);
+    delete mRecycled.fetchAndStoreAcquire(0);
+    delete mSpare;
+    delete mShown;
+    delete mReplaced;
+}
+
+bool PlotFeed::append(double key, double value)
+{
+    const quint32 head = mHead.load();
+    if (head - mTail.loadAcquire() > mMask)
+    {
+        mDropped.fetchAndAddRelaxed(1);
+        return false;
+    }
+    mSlots[head & mMask] = QCPGraphData(key, value);
+    mHead.storeRelease(head + 1);
+    return true;
+}
+
+void PlotFeed::publish(const QVector<double> &keys, const QVector<double> &values)
+{
+    const int count = qMin(keys.size(), values.size());
+    QCPGraphDataContainer *snapshot = mSpare ? mSpare : mRecycled.fetchAndStoreAcquire(0);
+    if (!snapshot)
+        snapshot = new QCPGraphDataContainer;
+    if (snapshot->ringCapacity() != count)
+        snapshot->setRingCapacity(count);
+    snapshot->clear();
+    for (int i = 0; i < count; i++)
+        snapshot->add(QCPGraphData(keys.at(i), values.at(i)));
+    // a snapshot the GUI hasn't taken comes back as the next spare
+    mSpare = mSnapshot.fetchAndStoreOrdered(snapshot);
+}
+
+int PlotFeed::take(QVector<QCPGraphData> *samples)
+{
+    const quint32 tail = mTail.load();
+    const quint32 head = mHead.loadAcquire();
+    for (quint32 i = tail; i != head; i++)
+        samples->append(mSlots[i & mMask]);
+    mTail.storeRelease(head);
+    return int(head - tail);
+}
+
+QSharedPointer<QCPGraphDataContainer> PlotFeed::takeSnapshot()
+{
+    QCPGraphDataContainer *snapshot = mSnapshot.fetchAndStoreAcquire(0);
+    if (!snapshot)
+        return QSharedPointer<QCPGraphDataContainer>();
+    // mShown has replaced mReplaced in the plot since the last call, so the producer may refill it.
+    // Should the producer not have picked up the previous one yet, that one goes.
+    delete mRecycled.fetchAndStoreOrdered(mReplaced);
+    mReplaced = mShown;
+    mShown = snapshot;
+    return QSharedPointer<QCPGraphDataContainer>(snapshot, keepContainer);
+}
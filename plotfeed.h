@@ -0,0 +1,62 @@
+#ifndef PLOTFEED_H
+#define PLOTFEED_H
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QSharedPointer>
+#include <QVector>
+#include "qcustomplot.h"
+
+// Hand-over of plot data from a producer thread to the GUI thread, which alone may touch the plots.
+//
+// Streamed series: the producer append()s samples into a single-producer/single-consumer ring;
+// it never blocks or allocates, and a full ring drops the new sample (droppedCount()). At render
+// time the GUI take()s everything appended since the last call.
+//
+// Whole-series snapshots (a range profile per frame): the producer publish()es by filling a spare
+// data container and exchanging it with an atomic pointer. takeSnapshot() exchanges it out again
+// and hands it over as the shared pointer QCPGraph::setData(QSharedPointer<QCPGraphDataContainer>)
+// installs without copying. The feed keeps owning the containers and cycles them: a snapshot the
+// GUI hasn't taken yet becomes the producer's next spare, and a container the plot has replaced
+// is handed back through a second atomic pointer. The containers are rings sized to the series,
+// so once a few have gone round, publishing refills them in place and allocates nothing.
+// Install each snapshot before taking the next one: the one installed before it is recycled then.
+//
+// One producer thread and one consumer thread per feed.
+
+#define PLOT_FEED_DEFAULT_CAPACITY   (1024)
+
+class PlotFeed
+{
+public:
+    explicit PlotFeed(int capacity = PLOT_FEED_DEFAULT_CAPACITY);
+    ~PlotFeed();
+
+    // producer side
+    bool append(double key, double value);
+    void publish(const QVector<double> &keys, const QVector<double> &values);
+
+    // consumer side
+    int take(QVector<QCPGraphData> *samples);
+    QSharedPointer<QCPGraphDataContainer> takeSnapshot();
+
+    int capacity() const { return mRing.size(); }
+    quint32 droppedCount() const { return mDropped.load(); }
+
+private:
+    Q_DISABLE_COPY(PlotFeed)
+
+    QVector<QCPGraphData> mRing;
+    QCPGraphData *mSlots;
+    quint32 mMask;
+    QAtomicInteger<quint32> mHead;      // next slot the producer writes
+    QAtomicInteger<quint32> mTail;      // next slot the consumer reads
+    QAtomicInteger<quint32> mDropped;
+    QAtomicPointer<QCPGraphDataContainer> mSnapshot;
+    QAtomicPointer<QCPGraphDataContainer> mRecycled;   // replaced in the plot, for the producer
+    QCPGraphDataContainer *mSpare;      // producer's next container
+    QCPGraphDataContainer *mShown;      // consumer's last snapshot, installed in the plot
+    QCPGraphDataContainer *mReplaced;   // the snapshot mShown replaced in the plot
+};
+
+#endif // PLOTFEED_H
@@ -25,6 +25,29 @@
 
 #include "qcustomplot.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QCP_USE_SSE2
+#endif
+#ifdef QCP_USE_SSE2
+// AVX/AVX2 kernels are compiled for their instruction set function by function and picked at
+// runtime (see qcpSimdLevel), so an SSE2 baseline build uses them on CPUs that have them
+#define QCP_USE_AVX
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define QCP_TARGET_AVX
+#define QCP_TARGET_AVX2
+#else
+#define QCP_TARGET_AVX __attribute__((target("avx")))
+#define QCP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#define QCP_PARALLEL_SAMPLING_MIN_CHUNK (100000) // data points per chunk, so a chunk outweighs its task overhead (see bench/parallelsampling)
+#define QCP_COLORIZE_BLOCK (256) // values converted per block by QCPColorGradient::colorize
+#define QCP_SCROLL_REDRAW_MARGIN (3) // pixels redrawn across the seam of a scrolled layer, for line caps and antialiasing
+#define QCP_SCROLL_PIXEL_TOLERANCE (0.01) // deviation from a whole pixel up to which a layer shift is scrolled instead of redrawn
+
 
 /* including file 'src/vector2d.cpp', size 7340                              */
 /* commit 633339dadc92cb10c58ef3556b55570685fafb99 2016-09-13 23:54:56 +0200 */
@@ -638,6 +661,28 @@ void QCPAbstractPaintBuffer::setDevicePixelRatio(double ratio)
   }
 }
 
+/*!
+  Moves the contents of \a rect (in logical pixels) by \a dx horizontally and \a dy vertically.
+  Contents shifted outside \a rect are discarded, and the strip of \a rect that was uncovered keeps
+  its previous, now stale, contents. The caller is expected to clear and redraw that strip.
+
+  This is used by layers that scroll their paint buffer instead of redrawing it entirely (see \ref
+  QCPLayer::setScrollAxis).
+
+  Returns whether the buffer was scrolled. The default implementation doesn't support scrolling
+  and returns false, in which case the caller must redraw the whole buffer.
+
+  This method must not be called if there is currently a painter (acquired with \ref startPainting)
+  active.
+*/
+bool QCPAbstractPaintBuffer::scroll(int dx, int dy, const QRect &rect)
+{
+  Q_UNUSED(dx)
+  Q_UNUSED(dy)
+  Q_UNUSED(rect)
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPPaintBufferPixmap
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -686,6 +731,15 @@ void QCPPaintBufferPixmap::clear(const QColor &color)
   mBuffer.fill(color);
 }
 
+/* inherits documentation from base class */
+bool QCPPaintBufferPixmap::scroll(int dx, int dy, const QRect &rect)
+{
+  // QPixmap::scroll works in device pixels:
+  const double ratio = mDevicePixelRatio;
+  mBuffer.scroll(qRound(dx*ratio), qRound(dy*ratio), QRect(qRound(rect.x()*ratio), qRound(rect.y()*ratio), qRound(rect.width()*ratio), qRound(rect.height()*ratio)));
+  return true;
+}
+
 /* inherits documentation from base class */
 void QCPPaintBufferPixmap::reallocateBuffer()
 {
@@ -831,7 +885,8 @@ QCPPaintBufferGlFbo::QCPPaintBufferGlFbo(const QSize &size, double devicePixelRa
   QCPAbstractPaintBuffer(size, devicePixelRatio),
   mGlContext(glContext),
   mGlPaintDevice(glPaintDevice),
-  mGlFrameBuffer(0)
+  mGlFrameBuffer(0),
+  mGlScrollFrameBuffer(0)
 {
   QCPPaintBufferGlFbo::reallocateBuffer();
 }
@@ -840,6 +895,8 @@ QCPPaintBufferGlFbo::~QCPPaintBufferGlFbo()
 {
   if (mGlFrameBuffer)
     delete mGlFrameBuffer;
+  if (mGlScrollFrameBuffer)
+    delete mGlScrollFrameBuffer;
 }
 
 /* inherits documentation from base class */
@@ -911,6 +968,40 @@ void QCPPaintBufferGlFbo::clear(const QColor &color)
   mGlFrameBuffer->release();
 }
 
+/*!
+  Scrolls the frame buffer object with two framebuffer blits, because a blit between overlapping
+  regions of the same frame buffer object is undefined: first the part of \a rect that remains
+  visible is copied to its new position in a scratch frame buffer object of the same format, which
+  is allocated on the first scroll, then back into the same position of the paint buffer.
+
+  Returns false if the OpenGL implementation doesn't support framebuffer blits.
+*/
+bool QCPPaintBufferGlFbo::scroll(int dx, int dy, const QRect &rect)
+{
+  if (mGlContext.isNull() || !mGlFrameBuffer || !QOpenGLFramebufferObject::hasOpenGLFramebufferBlit())
+    return false;
+  
+  if (QOpenGLContext::currentContext() != mGlContext.data())
+    mGlContext.data()->makeCurrent(mGlContext.data()->surface());
+  if (!mGlScrollFrameBuffer || mGlScrollFrameBuffer->size() != mGlFrameBuffer->size())
+  {
+    delete mGlScrollFrameBuffer;
+    mGlScrollFrameBuffer = new QOpenGLFramebufferObject(mGlFrameBuffer->size(), mGlFrameBuffer->format());
+  }
+  
+  // convert to device pixels with the origin at the bottom left, as used by the blit:
+  const double ratio = mDevicePixelRatio;
+  const QRect deviceRect(qRound(rect.x()*ratio), qRound(rect.y()*ratio), qRound(rect.width()*ratio), qRound(rect.height()*ratio));
+  const QRect glRect(deviceRect.x(), mGlFrameBuffer->height()-deviceRect.y()-deviceRect.height(), deviceRect.width(), deviceRect.height());
+  const QPoint glShift(qRound(dx*ratio), -qRound(dy*ratio));
+  const QRect target = glRect.translated(glShift).intersected(glRect);
+  if (target.isEmpty())
+    return true; // everything was shifted out of rect
+  QOpenGLFramebufferObject::blitFramebuffer(mGlScrollFrameBuffer, target, mGlFrameBuffer, target.translated(-glShift));
+  QOpenGLFramebufferObject::blitFramebuffer(mGlFrameBuffer, target, mGlScrollFrameBuffer, target);
+  return true;
+}
+
 /* inherits documentation from base class */
 void QCPPaintBufferGlFbo::reallocateBuffer()
 {
@@ -922,6 +1013,12 @@ void QCPPaintBufferGlFbo::reallocateBuffer()
     delete mGlFrameBuffer;
     mGlFrameBuffer = 0;
   }
+  // the scratch buffer for scrolling is allocated again with the new size when needed:
+  if (mGlScrollFrameBuffer)
+  {
+    delete mGlScrollFrameBuffer;
+    mGlScrollFrameBuffer = 0;
+  }
   
   if (mGlContext.isNull())
   {
@@ -1011,6 +1108,14 @@ void QCPPaintBufferGlFbo::reallocateBuffer()
   compared with a full replot of all layers. Upon creation of a new layer, the layer mode is
   initialized to \ref lmLogical. The only layer that is set to \ref lmBuffered in a new \ref
   QCustomPlot instance is the "overlay" layer, containing the selection rect.
+
+  \section qcplayer-scrolling Scrolling strip charts
+
+  A buffered layer which holds the plottables of a strip chart, i.e. whose key axis range moves
+  along with the newest data, can be given that axis with \ref setScrollAxis. When a replot finds
+  that only that axis range moved by whole pixels since the layer was last drawn, the paint buffer
+  is scrolled and only the uncovered strip is redrawn, so the drawing cost is proportional to the
+  new data instead of the window length. The other layers (axes, grid, labels) are drawn as usual.
 */
 
 /* start documentation of inline functions */
@@ -1029,6 +1134,15 @@ void QCPPaintBufferGlFbo::reallocateBuffer()
   Layers with higher indices will be drawn above layers with lower indices.
 */
 
+/*! \fn QRect QCPLayer::scrollExposedRect() const
+
+  While this layer redraws only the strip uncovered by scrolling its paint buffer, returns that
+  strip in pixel coordinates. Otherwise returns a null rect. Layerables may use it to skip the parts
+  of their data that lie outside the strip.
+
+  \see setScrollAxis
+*/
+
 /* end documentation of inline functions */
 
 /*!
@@ -1045,7 +1159,8 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
   mVisible(true),
-  mMode(lmLogical)
+  mMode(lmLogical),
+  mScrollAxis(0)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -1109,6 +1224,44 @@ void QCPLayer::setMode(QCPLayer::LayerMode mode)
   }
 }
 
+/*!
+  Returns the axis along which this layer scrolls its paint buffer, or 0 if scrolling is disabled.
+
+  \see setScrollAxis
+*/
+QCPAxis *QCPLayer::scrollAxis() const
+{
+  return mScrollAxis.data();
+}
+
+/*!
+  Makes this layer scroll its paint buffer along \a axis on replots, instead of redrawing its
+  layerables entirely. Pass 0 to disable scrolling (the default).
+
+  This only takes effect in the \ref lmBuffered layer mode. On a \ref QCustomPlot::replot, the
+  layer compares the ranges of all axes of the axis rect of \a axis with the ones it was last drawn
+  with. If only the range of \a axis moved, \a axis has a linear scale, the range size is unchanged
+  and the shift amounts to a whole number of (device) pixels, the buffer contents inside the axis
+  rect are moved by that shift. Then only the strip that was uncovered is cleared and redrawn, plus
+  a few pixels across the seam. In every other case, e.g. when an axis was rescaled or the plot
+  resized, the layer is redrawn entirely. A replot of only this layer (\ref replot) always redraws
+  the whole layer.
+
+  While a strip is redrawn, \ref scrollExposedRect returns it, layerables are clipped to it, and
+  \ref QCPGraph only samples the data in its key range. The layer should only contain layerables
+  that are clipped to the axis rect of \a axis. Content outside of the exposed strip is assumed
+  unchanged, so new data must only appear at the uncovered end of the axis, as in a strip chart
+  whose upper range bound follows the newest key. Pens wider than the redraw margin or large
+  scatter symbols may leave seams.
+
+  \see scrollExposedRect
+*/
+void QCPLayer::setScrollAxis(QCPAxis *axis)
+{
+  mScrollAxis = axis;
+  mScrollBounds.clear(); // the next replot draws the whole layer
+}
+
 /*! \internal
 
   Draws the contents of this layer with the provided \a painter.
@@ -1123,6 +1276,8 @@ void QCPLayer::draw(QCPPainter *painter)
     {
       painter->save();
       painter->setClipRect(child->clipRect().translated(0, -1));
+      if (!mScrollExposedRect.isNull())
+        painter->setClipRect(mScrollExposedRect, Qt::IntersectClip);
       child->applyDefaultAntialiasingHint(painter);
       child->draw(painter);
       painter->restore();
@@ -1145,8 +1300,16 @@ void QCPLayer::drawToPaintBuffer()
     if (QCPPainter *painter = mPaintBuffer.data()->startPainting())
     {
       if (painter->isActive())
+      {
+        if (!mScrollExposedRect.isNull()) // the rest of the buffer was scrolled, only clear the uncovered strip
+        {
+          painter->save();
+          painter->setCompositionMode(QPainter::CompositionMode_Source);
+          painter->fillRect(mScrollExposedRect, Qt::transparent);
+          painter->restore();
+        }
         draw(painter);
-      else
+      } else
         qDebug() << Q_FUNC_INFO << "paint buffer returned inactive painter";
       delete painter;
       mPaintBuffer.data()->donePainting();
@@ -1177,14 +1340,92 @@ void QCPLayer::replot()
     {
       mPaintBuffer.data()->clear(Qt::transparent);
       drawToPaintBuffer();
+      updateScrollState();
       mPaintBuffer.data()->setInvalidated(false);
       mParentPlot->update();
     } else
       qDebug() << Q_FUNC_INFO << "no valid paint buffer associated with this layer";
-  } else if (mMode == lmLogical)
+  } else
     mParentPlot->replot();
 }
 
+/*! \internal
+
+  Called by \ref QCustomPlot::setupPaintBuffers before the layers are drawn. If this layer has a
+  scroll axis (\ref setScrollAxis) and only its range moved by whole pixels since the last draw,
+  scrolls the paint buffer accordingly and sets \ref scrollExposedRect to the strip that needs
+  redrawing.
+
+  Returns true if the buffer was scrolled, so its contents must not be cleared.
+*/
+bool QCPLayer::scrollPaintBuffer()
+{
+  mScrollExposedRect = QRect();
+  QCPAxis *axis = mScrollAxis.data();
+  QCPAbstractPaintBuffer *buffer = mPaintBuffer.data();
+  if (mMode != lmBuffered || !axis || !buffer || buffer->invalidated() || axis->scaleType() != QCPAxis::stLinear)
+    return false;
+  QCPAxisRect *axisRect = axis->axisRect();
+  const QList<QCPAxis*> axes = axisRect->axes();
+  if (axisRect->rect() != mScrollRect || mScrollBounds.size() != 2*axes.size())
+    return false;
+  
+  // only the scroll axis may have moved, and both of its bounds by the same pixel distance:
+  double lowerShift = 0, upperShift = 0;
+  for (int i=0; i<axes.size(); ++i)
+  {
+    const QCPRange range = axes.at(i)->range();
+    const double oldLower = mScrollBounds.at(2*i);
+    const double oldUpper = mScrollBounds.at(2*i+1);
+    if (axes.at(i) == axis)
+    {
+      lowerShift = axis->coordToPixel(oldLower)-axis->coordToPixel(range.lower);
+      upperShift = axis->coordToPixel(oldUpper)-axis->coordToPixel(range.upper);
+    } else if (range.lower != oldLower || range.upper != oldUpper)
+      return false;
+  }
+  const int shift = qRound(lowerShift);
+  const double deviceShift = shift*buffer->devicePixelRatio();
+  if (shift == 0 || qAbs(lowerShift-shift) > QCP_SCROLL_PIXEL_TOLERANCE || qAbs(upperShift-shift) > QCP_SCROLL_PIXEL_TOLERANCE ||
+      qAbs(deviceShift-qRound(deviceShift)) > QCP_SCROLL_PIXEL_TOLERANCE)
+    return false;
+  
+  // scroll the axis rect as the layerables were clipped to it in draw, and uncover the opposite end:
+  const QRect scrollRect = mScrollRect.translated(0, -1);
+  const bool horizontal = axis->orientation() == Qt::Horizontal;
+  const int exposed = qAbs(shift)+QCP_SCROLL_REDRAW_MARGIN;
+  if (exposed >= (horizontal ? scrollRect.width() : scrollRect.height()))
+    return false;
+  if (!buffer->scroll(horizontal ? shift : 0, horizontal ? 0 : shift, scrollRect))
+    return false;
+  if (horizontal)
+    mScrollExposedRect = shift > 0 ? QRect(scrollRect.left(), scrollRect.top(), exposed, scrollRect.height())
+                                   : QRect(scrollRect.right()+1-exposed, scrollRect.top(), exposed, scrollRect.height());
+  else
+    mScrollExposedRect = shift > 0 ? QRect(scrollRect.left(), scrollRect.top(), scrollRect.width(), exposed)
+                                   : QRect(scrollRect.left(), scrollRect.bottom()+1-exposed, scrollRect.width(), exposed);
+  return true;
+}
+
+/*! \internal
+
+  Records the axis ranges and axis rect geometry this layer was just drawn with, so the next replot
+  can tell whether the paint buffer may be scrolled (see \ref setScrollAxis). Also ends a strip
+  redraw started by \ref scrollPaintBuffer.
+*/
+void QCPLayer::updateScrollState()
+{
+  mScrollExposedRect = QRect();
+  mScrollBounds.clear();
+  if (QCPAxis *axis = mScrollAxis.data())
+  {
+    QCPAxisRect *axisRect = axis->axisRect();
+    mScrollRect = axisRect->rect();
+    foreach (QCPAxis *rangeAxis, axisRect->axes())
+      mScrollBounds << rangeAxis->range().lower << rangeAxis->range().upper;
+  }
+}
+
 /*! \internal
   
   Adds the \a layerable to the list of this layer. If \a prepend is set to true, the layerable will
@@ -3703,6 +3944,8 @@ void QCPLayout::clear()
 */
 void QCPLayout::sizeConstraintsChanged() const
 {
+  if (mParentPlot)
+    mParentPlot->invalidateLayout();
   if (QWidget *w = qobject_cast<QWidget*>(parent()))
     w->updateGeometry();
   else if (QCPLayout *l = qobject_cast<QCPLayout*>(parent()))
@@ -3748,6 +3991,8 @@ void QCPLayout::adoptElement(QCPLayoutElement *el)
     if (!el->parentPlot())
       el->initializeParentPlot(mParentPlot);
     el->layoutChanged();
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   } else
     qDebug() << Q_FUNC_INFO << "Null element passed";
 }
@@ -3770,6 +4015,8 @@ void QCPLayout::releaseElement(QCPLayoutElement *el)
     el->setParentLayerable(0);
     el->setParent(mParentPlot);
     // Note: Don't initializeParentPlot(0) here, because layout element will stay in same parent plot
+    if (mParentPlot)
+      mParentPlot->invalidateLayout();
   } else
     qDebug() << Q_FUNC_INFO << "Null element passed";
 }
@@ -5372,7 +5619,8 @@ void QCPLineEnding::draw(QCPPainter *painter, const QCPVector2D &pos, double ang
 QCPAxisTicker::QCPAxisTicker() :
   mTickStepStrategy(tssReadability),
   mTickCount(5),
-  mTickOrigin(0)
+  mTickOrigin(0),
+  mRevision(0)
 {
 }
 
@@ -5387,6 +5635,7 @@ QCPAxisTicker::~QCPAxisTicker()
 */
 void QCPAxisTicker::setTickStepStrategy(QCPAxisTicker::TickStepStrategy strategy)
 {
+  ++mRevision;
   mTickStepStrategy = strategy;
 }
 
@@ -5400,6 +5649,7 @@ void QCPAxisTicker::setTickStepStrategy(QCPAxisTicker::TickStepStrategy strategy
 */
 void QCPAxisTicker::setTickCount(int count)
 {
+  ++mRevision;
   if (count > 0)
     mTickCount = count;
   else
@@ -5416,6 +5666,7 @@ void QCPAxisTicker::setTickCount(int count)
 */
 void QCPAxisTicker::setTickOrigin(double origin)
 {
+  ++mRevision;
   mTickOrigin = origin;
 }
 
@@ -5790,6 +6041,7 @@ QCPAxisTickerDateTime::QCPAxisTickerDateTime() :
 */
 void QCPAxisTickerDateTime::setDateTimeFormat(const QString &format)
 {
+  ++mRevision;
   mDateTimeFormat = format;
 }
 
@@ -5805,6 +6057,7 @@ void QCPAxisTickerDateTime::setDateTimeFormat(const QString &format)
 */
 void QCPAxisTickerDateTime::setDateTimeSpec(Qt::TimeSpec spec)
 {
+  ++mRevision;
   mDateTimeSpec = spec;
 }
 
@@ -5819,6 +6072,7 @@ void QCPAxisTickerDateTime::setDateTimeSpec(Qt::TimeSpec spec)
 */
 void QCPAxisTickerDateTime::setTickOrigin(double origin)
 {
+  ++mRevision;
   QCPAxisTicker::setTickOrigin(origin);
 }
 
@@ -5831,6 +6085,7 @@ void QCPAxisTickerDateTime::setTickOrigin(double origin)
 */
 void QCPAxisTickerDateTime::setTickOrigin(const QDateTime &origin)
 {
+  ++mRevision;
   setTickOrigin(dateTimeToKey(origin));
 }
 
@@ -6108,6 +6363,7 @@ QCPAxisTickerTime::QCPAxisTickerTime() :
 */
 void QCPAxisTickerTime::setTimeFormat(const QString &format)
 {
+  ++mRevision;
   mTimeFormat = format;
   
   // determine smallest and biggest unit in format, to optimize unit replacement and allow biggest
@@ -6139,6 +6395,7 @@ void QCPAxisTickerTime::setTimeFormat(const QString &format)
 */
 void QCPAxisTickerTime::setFieldWidth(QCPAxisTickerTime::TimeUnit unit, int width)
 {
+  ++mRevision;
   mFieldWidth[unit] = qMax(width, 1);
 }
 
@@ -6319,6 +6576,7 @@ QCPAxisTickerFixed::QCPAxisTickerFixed() :
 */
 void QCPAxisTickerFixed::setTickStep(double step)
 {
+  ++mRevision;
   if (step > 0)
     mTickStep = step;
   else
@@ -6334,6 +6592,7 @@ void QCPAxisTickerFixed::setTickStep(double step)
 */
 void QCPAxisTickerFixed::setScaleStrategy(QCPAxisTickerFixed::ScaleStrategy strategy)
 {
+  ++mRevision;
   mScaleStrategy = strategy;
 }
 
@@ -6434,6 +6693,7 @@ QCPAxisTickerText::QCPAxisTickerText() :
 */
 void QCPAxisTickerText::setTicks(const QMap<double, QString> &ticks)
 {
+  ++mRevision;
   mTicks = ticks;
 }
 
@@ -6447,6 +6707,7 @@ void QCPAxisTickerText::setTicks(const QMap<double, QString> &ticks)
 */
 void QCPAxisTickerText::setTicks(const QVector<double> &positions, const QVector<QString> labels)
 {
+  ++mRevision;
   clear();
   addTicks(positions, labels);
 }
@@ -6458,6 +6719,7 @@ void QCPAxisTickerText::setTicks(const QVector<double> &positions, const QVector
 */
 void QCPAxisTickerText::setSubTickCount(int subTicks)
 {
+  ++mRevision;
   if (subTicks >= 0)
     mSubTickCount = subTicks;
   else
@@ -6474,6 +6736,7 @@ void QCPAxisTickerText::setSubTickCount(int subTicks)
 */
 void QCPAxisTickerText::clear()
 {
+  ++mRevision;
   mTicks.clear();
 }
 
@@ -6485,6 +6748,7 @@ void QCPAxisTickerText::clear()
 */
 void QCPAxisTickerText::addTick(double position, QString label)
 {
+  ++mRevision;
   mTicks.insert(position, label);
 }
 
@@ -6500,6 +6764,7 @@ void QCPAxisTickerText::addTick(double position, QString label)
 */
 void QCPAxisTickerText::addTicks(const QMap<double, QString> &ticks)
 {
+  ++mRevision;
   mTicks.unite(ticks);
 }
 
@@ -6516,6 +6781,7 @@ void QCPAxisTickerText::addTicks(const QMap<double, QString> &ticks)
 */
 void QCPAxisTickerText::addTicks(const QVector<double> &positions, const QVector<QString> &labels)
 {
+  ++mRevision;
   if (positions.size() != labels.size())
     qDebug() << Q_FUNC_INFO << "passed unequal length vectors for positions and labels:" << positions.size() << labels.size();
   int n = qMin(positions.size(), labels.size());
@@ -6632,6 +6898,7 @@ QCPAxisTickerPi::QCPAxisTickerPi() :
 */
 void QCPAxisTickerPi::setPiSymbol(QString symbol)
 {
+  ++mRevision;
   mPiSymbol = symbol;
 }
 
@@ -6643,6 +6910,7 @@ void QCPAxisTickerPi::setPiSymbol(QString symbol)
 */
 void QCPAxisTickerPi::setPiValue(double pi)
 {
+  ++mRevision;
   mPiValue = pi;
 }
 
@@ -6656,6 +6924,7 @@ void QCPAxisTickerPi::setPiValue(double pi)
 */
 void QCPAxisTickerPi::setPeriodicity(int multiplesOfPi)
 {
+  ++mRevision;
   mPeriodicity = qAbs(multiplesOfPi);
 }
 
@@ -6665,6 +6934,7 @@ void QCPAxisTickerPi::setPeriodicity(int multiplesOfPi)
 */
 void QCPAxisTickerPi::setFractionStyle(QCPAxisTickerPi::FractionStyle style)
 {
+  ++mRevision;
   mFractionStyle = style;
 }
 
@@ -6917,6 +7187,7 @@ QCPAxisTickerLog::QCPAxisTickerLog() :
 */
 void QCPAxisTickerLog::setLogBase(double base)
 {
+  ++mRevision;
   if (base > 0)
   {
     mLogBase = base;
@@ -6937,6 +7208,7 @@ void QCPAxisTickerLog::setLogBase(double base)
 */
 void QCPAxisTickerLog::setSubTickCount(int subTicks)
 {
+  ++mRevision;
   if (subTicks >= 0)
     mSubTickCount = subTicks;
   else
@@ -7748,8 +8020,10 @@ void QCPAxis::setRangeReversed(bool reversed)
 void QCPAxis::setTicker(QSharedPointer<QCPAxisTicker> ticker)
 {
   if (ticker)
+  {
     mTicker = ticker;
-  else
+    mTickVectorHash.clear(); // the new ticker may reuse the address of a previous one, so don't compare it in setupTickVectors
+  } else
     qDebug() << Q_FUNC_INFO << "can not set 0 as axis ticker";
   // no need to invalidate margin cache here because produced tick labels are checked for changes in setupTickVector
 }
@@ -8522,6 +8796,209 @@ double QCPAxis::coordToPixel(double value) const
   }
 }
 
+#ifdef QCP_USE_AVX
+/*! \internal
+  
+  Returns the SIMD extensions beyond SSE2 that both the CPU and the operating system support: 0
+  for none, 1 for AVX, 2 for AVX and AVX2. Detected once, on first use.
+*/
+static int qcpDetectSimdLevel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  const bool osXSave = info[2] & (1<<27);
+  const bool avx = info[2] & (1<<28);
+  if (!osXSave || !avx || (_xgetbv(0) & 6) != 6) // the OS must save the YMM registers
+    return 0;
+  if (maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    if (info[1] & (1<<5))
+      return 2;
+  }
+  return 1;
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return 2;
+  return __builtin_cpu_supports("avx") ? 1 : 0;
+#endif
+}
+
+static int qcpSimdLevel()
+{
+  static const int level = qcpDetectSimdLevel();
+  return level;
+}
+
+/*! \internal
+  
+  AVX part of \ref qcpAffineTransform for contiguous arrays. Returns the number of elements
+  transformed, a multiple of 4.
+*/
+QCP_TARGET_AVX static int qcpAffineTransformAvx(const double *in, double *out, int count, double scale, double offset)
+{
+  const __m256d scale4 = _mm256_set1_pd(scale);
+  const __m256d offset4 = _mm256_set1_pd(offset);
+  int i = 0;
+  for (; i+4<=count; i+=4)
+    _mm256_storeu_pd(out+i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in+i), scale4), offset4));
+  return i;
+}
+
+/*! \internal
+  
+  AVX part of \ref qcpAffineTransformPairs, two pairs per step. Returns the number of pairs
+  transformed, a multiple of 2.
+*/
+QCP_TARGET_AVX static int qcpAffineTransformPairsAvx(const double *in, double *out, int count, double firstScale, double firstOffset, double secondScale, double secondOffset, bool swap)
+{
+  const __m256d scale4 = _mm256_set_pd(secondScale, firstScale, secondScale, firstScale);
+  const __m256d offset4 = _mm256_set_pd(secondOffset, firstOffset, secondOffset, firstOffset);
+  int i = 0;
+  for (; i+2<=count; i+=2)
+  {
+    __m256d pairs = _mm256_loadu_pd(in+2*i);
+    if (swap)
+      pairs = _mm256_permute_pd(pairs, 0x5);
+    _mm256_storeu_pd(out+2*i, _mm256_add_pd(_mm256_mul_pd(pairs, scale4), offset4));
+  }
+  return i;
+}
+#endif
+
+/*! \internal
+  
+  Computes <tt>out[i*stride] = in[i*stride]*scale+offset</tt> for \a count elements. Contiguous
+  arrays are processed with AVX (if the CPU has it) or SSE2; the vector paths multiply and then
+  add like the scalar one, which gives the same results unless the compiler contracts the scalar
+  code into fused multiply-adds.
+*/
+static void qcpAffineTransform(const double *in, double *out, int count, int stride, double scale, double offset)
+{
+  int i = 0;
+  if (stride == 1)
+  {
+#ifdef QCP_USE_AVX
+    if (qcpSimdLevel() >= 1)
+      i = qcpAffineTransformAvx(in, out, count, scale, offset);
+#endif
+#ifdef QCP_USE_SSE2
+    const __m128d scale2 = _mm_set1_pd(scale);
+    const __m128d offset2 = _mm_set1_pd(offset);
+    for (; i+2<=count; i+=2)
+      _mm_storeu_pd(out+i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in+i), scale2), offset2));
+#endif
+  }
+  for (; i<count; ++i)
+    out[i*stride] = in[i*stride]*scale+offset;
+}
+
+/*! \internal
+  
+  Transforms \a count interleaved pairs <tt>(a, b)</tt> from \a in to <tt>(a*scale0+offset0,
+  b*scale1+offset1)</tt> in \a out, or to the swapped pair <tt>(b*scale1+offset1,
+  a*scale0+offset0)</tt> if \a swap is true. This maps key/value data to x/y pixels for
+  horizontal (no swap) and vertical (swap) key axes in a single pass.
+*/
+static void qcpAffineTransformPairs(const double *in, double *out, int count, double scale0, double offset0, double scale1, double offset1, bool swap)
+{
+  int i = 0;
+  const double firstScale = swap ? scale1 : scale0;
+  const double firstOffset = swap ? offset1 : offset0;
+  const double secondScale = swap ? scale0 : scale1;
+  const double secondOffset = swap ? offset0 : offset1;
+#ifdef QCP_USE_AVX
+  if (qcpSimdLevel() >= 1)
+    i = qcpAffineTransformPairsAvx(in, out, count, firstScale, firstOffset, secondScale, secondOffset, swap);
+#endif
+#ifdef QCP_USE_SSE2
+  const __m128d scale2 = _mm_set_pd(secondScale, firstScale);
+  const __m128d offset2 = _mm_set_pd(secondOffset, firstOffset);
+  for (; i<count; ++i)
+  {
+    __m128d pair = _mm_loadu_pd(in+2*i);
+    if (swap)
+      pair = _mm_shuffle_pd(pair, pair, 1);
+    _mm_storeu_pd(out+2*i, _mm_add_pd(_mm_mul_pd(pair, scale2), offset2));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    const double a = in[2*i+(swap ? 1 : 0)];
+    const double b = in[2*i+(swap ? 0 : 1)];
+    out[2*i+0] = a*firstScale+firstOffset;
+    out[2*i+1] = b*secondScale+secondOffset;
+  }
+}
+
+/*!
+  Transforms \a count values from \a coords, in coordinates of the axis, to pixel coordinates of
+  the QCustomPlot widget in \a pixels. Consecutive values are \a stride doubles apart in both
+  arrays, so e.g. the keys of interleaved key/value data can be transformed in place of the x
+  coordinates of a QPointF array. \a coords and \a pixels may be the same array.
+  
+  This gives the same result as calling \ref coordToPixel for every value (up to rounding), but
+  the scale type and orientation are resolved once per call, and contiguous data on linear axes is
+  transformed with SIMD instructions where available.
+  
+  \see pixelTransform
+*/
+void QCPAxis::coordsToPixels(const double *coords, double *pixels, int count, int stride) const
+{
+  double scale, offset;
+  pixelTransform(&scale, &offset);
+  if (mScaleType == stLinear)
+  {
+    qcpAffineTransform(coords, pixels, count, stride, scale, offset);
+    return;
+  }
+  
+  // logarithmic: values on the wrong side of zero are placed outside the visible range, as in coordToPixel
+  const bool horizontal = orientation() == Qt::Horizontal;
+  const double beyondUpper = horizontal ? (!mRangeReversed ? mAxisRect->right()+200 : mAxisRect->left()-200) : (!mRangeReversed ? mAxisRect->top()-200 : mAxisRect->bottom()+200);
+  const double beyondLower = horizontal ? (!mRangeReversed ? mAxisRect->left()-200 : mAxisRect->right()+200) : (!mRangeReversed ? mAxisRect->bottom()+200 : mAxisRect->top()-200);
+  for (int i=0; i<count; ++i)
+  {
+    const double value = coords[i*stride];
+    if (value >= 0 && mRange.upper < 0)
+      pixels[i*stride] = beyondUpper;
+    else if (value <= 0 && mRange.upper > 0)
+      pixels[i*stride] = beyondLower;
+    else
+      pixels[i*stride] = qLn(qAbs(value))*scale+offset;
+  }
+}
+
+/*!
+  Returns the affine map from axis coordinates to pixels as \a scale and \a offset: A coordinate
+  \e c is at pixel <tt>c*scale+offset</tt> on a linear axis, and at <tt>ln(|c|)*scale+offset</tt>
+  on a logarithmic one. The result depends on the axis range, orientation, range reversal and the
+  axis rect geometry, and is valid until one of them changes.
+  
+  \see coordsToPixels, coordToPixel
+*/
+void QCPAxis::pixelTransform(double *scale, double *offset) const
+{
+  const bool horizontal = orientation() == Qt::Horizontal;
+  const double extent = horizontal ? mAxisRect->width() : -mAxisRect->height();
+  const double origin = horizontal ? mAxisRect->left() : mAxisRect->bottom();
+  const double lower = mScaleType == stLinear ? mRange.lower : qLn(qAbs(mRange.lower));
+  const double upper = mScaleType == stLinear ? mRange.upper : qLn(qAbs(mRange.upper));
+  if (!mRangeReversed)
+  {
+    *scale = extent/(upper-lower);
+    *offset = origin-lower*(*scale);
+  } else
+  {
+    *scale = -extent/(upper-lower);
+    *offset = origin+upper*extent/(upper-lower);
+  }
+}
+
 /*!
   Returns the part of the axis that is hit by \a pos (in pixels). The return value of this function
   is independent of the user-selectable parts defined with \ref setSelectableParts. Further, this
@@ -8766,11 +9243,35 @@ void QCPAxis::setupTickVectors()
   if (!mParentPlot) return;
   if ((!mTicks && !mTickLabels && !mGrid->visible()) || mRange.size() <= 0) return;
   
+  QByteArray newHash = generateTickVectorHash();
+  if (newHash == mTickVectorHash) // ticks and labels were generated with the same parameters already
+    return;
+  mTickVectorHash = newHash;
+  
   QVector<QString> oldLabels = mTickVectorLabels;
   mTicker->generate(mRange, mParentPlot->locale(), mNumberFormatChar, mNumberPrecision, mTickVector, mSubTicks ? &mSubTickVector : 0, mTickLabels ? &mTickVectorLabels : 0);
   mCachedMarginValid &= mTickVectorLabels == oldLabels; // if labels have changed, margin might have changed, too
 }
 
+/*! \internal
+  
+  Returns a hash of all parameters the tick vectors depend on: the range, the ticker and its \ref
+  QCPAxisTicker::revision, the locale and number format, and whether sub ticks and tick labels are
+  generated. It is used in \ref setupTickVectors. If the return value hasn't changed since the
+  last call, the ticker would produce the same ticks and labels again, so generating them is
+  skipped.
+*/
+QByteArray QCPAxis::generateTickVectorHash() const
+{
+  QByteArray result;
+  result.append(QByteArray::number(mRange.lower, 'g', 17)+' '+QByteArray::number(mRange.upper, 'g', 17)+' ');
+  result.append(QByteArray::number((quintptr)mTicker.data(), 16)+' '+QByteArray::number(mTicker->revision())+' ');
+  result.append(mParentPlot->locale().name().toLatin1()+QByteArray::number((int)mParentPlot->locale().numberOptions())+' ');
+  result.append(QString(mNumberFormatChar).toLatin1()+QByteArray::number(mNumberPrecision));
+  result.append(QByteArray::number((int)mSubTicks)+QByteArray::number((int)mTickLabels));
+  return result;
+}
+
 /*! \internal
   
   Returns the pen that is used to draw the axis base line. Depending on the selection state, this
@@ -8945,8 +9446,7 @@ QCPAxisPainterPrivate::QCPAxisPainterPrivate(QCustomPlot *parentPlot) :
   offset(0),
   abbreviateDecimalPowers(false),
   reversedEndings(false),
-  mParentPlot(parentPlot),
-  mLabelCache(16) // cache at most 16 (tick) labels
+  mParentPlot(parentPlot)
 {
 }
 
@@ -8963,12 +9463,7 @@ QCPAxisPainterPrivate::~QCPAxisPainterPrivate()
 */
 void QCPAxisPainterPrivate::draw(QCPPainter *painter)
 {
-  QByteArray newHash = generateLabelParameterHash();
-  if (newHash != mLabelParameterHash)
-  {
-    mLabelCache.clear();
-    mLabelParameterHash = newHash;
-  }
+  mLabelParameterHash = generateLabelParameterHash(); // labels cached with other parameters are no longer looked up and age out of the shared cache
   
   QPoint origin;
   switch (type)
@@ -9189,13 +9684,65 @@ int QCPAxisPainterPrivate::size() const
 
 /*! \internal
   
-  Clears the internal label cache. Upon the next \ref draw, all labels will be created new. This
-  method is called automatically in \ref draw, if any parameters have changed that invalidate the
-  cached labels, such as font, color, etc.
+  Removes the labels cached with this axis' current label parameters from the shared label cache.
+  Upon the next \ref draw, they will be created new. Labels don't need to be cleared when
+  parameters like font, color, etc. change, because the parameters are part of the cache key (see
+  \ref generateLabelParameterHash).
 */
 void QCPAxisPainterPrivate::clearCache()
 {
-  mLabelCache.clear();
+  const QString prefix = labelCacheKey(QString());
+  foreach (const QString &key, labelCache().keys())
+  {
+    if (key.startsWith(prefix))
+      labelCache().remove(key);
+  }
+}
+
+/*! \internal
+  
+  Returns the byte budget of the label cache shared by all axes of all QCustomPlot instances.
+  
+  \see setLabelCacheSize
+*/
+int QCPAxisPainterPrivate::labelCacheSize()
+{
+  return labelCache().maxCost();
+}
+
+/*! \internal
+  
+  Sets the byte budget of the label cache shared by all axes of all QCustomPlot instances. When
+  the rendered tick label pixmaps exceed \a bytes, the least recently used ones are discarded.
+  
+  \see QCustomPlot::setLabelCacheSize
+*/
+void QCPAxisPainterPrivate::setLabelCacheSize(int bytes)
+{
+  labelCache().setMaxCost(qMax(0, bytes));
+}
+
+/*! \internal
+  
+  Returns the process-wide tick label cache. Labels are shared between all axes and plots whose
+  axis type, label parameters (\ref generateLabelParameterHash) and text are equal, and their cost is the
+  pixmap size in bytes, so the cache is bounded by memory rather than by label count. Since the
+  labels are QPixmaps, the cache must only be used from the GUI thread.
+*/
+QCache<QString, QCPAxisPainterPrivate::CachedLabel> &QCPAxisPainterPrivate::labelCache()
+{
+  static QCache<QString, CachedLabel> cache(4*1024*1024);
+  return cache;
+}
+
+/*! \internal
+  
+  Returns the key of the label with \a text in the shared label cache, made up of the current
+  label parameters of this axis and \a text.
+*/
+QString QCPAxisPainterPrivate::labelCacheKey(const QString &text) const
+{
+  return QString::fromLatin1(mLabelParameterHash)+QLatin1Char('\n')+text;
 }
 
 /*! \internal
@@ -9208,6 +9755,7 @@ void QCPAxisPainterPrivate::clearCache()
 QByteArray QCPAxisPainterPrivate::generateLabelParameterHash() const
 {
   QByteArray result;
+  result.append(QByteArray::number((int)type)); // the cached draw offset depends on the axis side
   result.append(QByteArray::number(mParentPlot->bufferDevicePixelRatio()));
   result.append(QByteArray::number(tickLabelRotation));
   result.append(QByteArray::number((int)tickLabelSide));
@@ -9252,7 +9800,8 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
   }
   if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
   {
-    CachedLabel *cachedLabel = mLabelCache.take(text); // attempt to get label from cache
+    const QString cacheKey = labelCacheKey(text);
+    CachedLabel *cachedLabel = labelCache().take(cacheKey); // attempt to get label from cache
     if (!cachedLabel)  // no cached label existed, create it
     {
       cachedLabel = new CachedLabel;
@@ -9286,7 +9835,8 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
       painter->drawPixmap(labelAnchor+cachedLabel->offset, cachedLabel->pixmap);
       finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio();
     }
-    mLabelCache.insert(text, cachedLabel); // return label to cache or insert for the first time if newly created
+    const int cost = cachedLabel->pixmap.width()*cachedLabel->pixmap.height()*qMax(1, cachedLabel->pixmap.depth()/8);
+    labelCache().insert(cacheKey, cachedLabel, cost); // return label to cache or insert for the first time if newly created (deletes it if over budget)
   } else // label caching disabled, draw text directly on surface:
   {
     TickLabelData labelData = getTickLabelData(painter->font(), text);
@@ -9548,9 +10098,9 @@ void QCPAxisPainterPrivate::getMaxTickLabelSize(const QFont &font, const QString
 {
   // note: this function must return the same tick label sizes as the placeTickLabel function.
   QSize finalSize;
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && mLabelCache.contains(text)) // label caching enabled and have cached label
+  const CachedLabel *cachedLabel = mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) ? labelCache().object(labelCacheKey(text)) : 0;
+  if (cachedLabel) // label caching enabled and have cached label
   {
-    const CachedLabel *cachedLabel = mLabelCache.object(text);
     finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio();
   } else // label caching disabled or no label with this text cached:
   {
@@ -12485,6 +13035,23 @@ QCP::Interaction QCPAbstractItem::selectionCategory() const
   \see replot, beforeReplot
 */
 
+/*! \fn void QCustomPlot::beforePaint()
+  
+  This signal is emitted at the start of the widget's paint event, before the paint buffers are
+  drawn onto the widget. A \ref replot only renders into the paint buffers; the paint that puts
+  them on screen follows from the event loop (or immediately, with \ref rpImmediateRefresh).
+  
+  \see afterPaint
+*/
+
+/*! \fn void QCustomPlot::afterPaint()
+  
+  This signal is emitted at the end of the widget's paint event, after the paint buffers were
+  drawn onto the widget.
+  
+  \see beforePaint
+*/
+
 /* end of documentation of signals */
 /* start of documentation of public members */
 
@@ -12617,6 +13184,7 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mMouseEventLayerable(0),
   mReplotting(false),
   mReplotQueued(false),
+  mLayoutValid(false),
   mOpenGlMultisamples(16),
   mOpenGlAntialiasedElementsBackup(QCP::aeNone),
   mOpenGlCacheLabelsBackup(true)
@@ -12913,6 +13481,7 @@ void QCustomPlot::setNoAntialiasingOnDrag(bool enabled)
 void QCustomPlot::setPlottingHints(const QCP::PlottingHints &hints)
 {
   mPlottingHints = hints;
+  mLayoutValid = false;
 }
 
 /*!
@@ -13087,6 +13656,19 @@ void QCustomPlot::setOpenGl(bool enabled, int multisampling)
 #endif
 }
 
+/*!
+  Sets the memory budget in \a bytes of the tick label cache (see \ref QCP::phCacheLabels). The
+  cache is shared by all axes of all QCustomPlot instances in the process, so plots with equal
+  tick label fonts and colors reuse each other's rendered labels. When the budget is exceeded, the
+  least recently used labels are discarded. The default is 4 MiB.
+  
+  \see labelCacheSize
+*/
+void QCustomPlot::setLabelCacheSize(int bytes)
+{
+  QCPAxisPainterPrivate::setLabelCacheSize(bytes);
+}
+
 /*!
   Sets the viewport of this QCustomPlot. Usually users of QCustomPlot don't need to change the
   viewport manually.
@@ -13108,6 +13690,7 @@ void QCustomPlot::setViewport(const QRect &rect)
   mViewport = rect;
   if (mPlotLayout)
     mPlotLayout->setOuterRect(mViewport);
+  mLayoutValid = false;
 }
 
 /*!
@@ -14150,7 +14733,10 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   // draw all layered objects (grid, axes, plottables, items, legend,...) into their buffers:
   setupPaintBuffers();
   foreach (QCPLayer *layer, mLayers)
+  {
     layer->drawToPaintBuffer();
+    layer->updateScrollState();
+  }
   for (int i=0; i<mPaintBuffers.size(); ++i)
     mPaintBuffers.at(i)->setInvalidated(false);
   
@@ -14163,6 +14749,21 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   mReplotting = false;
 }
 
+/*!
+  Marks the layout of this QCustomPlot as changed, so the next \ref replot recalculates margins and
+  element geometry even if the \ref QCP::phCacheLayout plotting hint is set.
+  
+  With that hint, the layout is redone automatically when the viewport size changes, when an axis
+  margin may have changed (e.g. because tick labels or axis properties changed), when elements are
+  added to or removed from a layout, and when size constraints change. Call this method after other
+  changes that affect the layout, like setting margins, stretch factors or spacings, changing the
+  text of a QCPTextElement or the items of a legend.
+*/
+void QCustomPlot::invalidateLayout()
+{
+  mLayoutValid = false;
+}
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
   
@@ -14453,16 +15054,20 @@ QSize QCustomPlot::sizeHint() const
 void QCustomPlot::paintEvent(QPaintEvent *event)
 {
   Q_UNUSED(event);
-  QCPPainter painter(this);
-  if (painter.isActive())
+  emit beforePaint();
   {
-    painter.setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
-    if (mBackgroundBrush.style() != Qt::NoBrush)
-      painter.fillRect(mViewport, mBackgroundBrush);
-    drawBackground(&painter);
-    for (int bufferIndex = 0; bufferIndex < mPaintBuffers.size(); ++bufferIndex)
-      mPaintBuffers.at(bufferIndex)->draw(&painter);
-  }
+    QCPPainter painter(this);
+    if (painter.isActive())
+    {
+      painter.setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
+      if (mBackgroundBrush.style() != Qt::NoBrush)
+        painter.fillRect(mViewport, mBackgroundBrush);
+      drawBackground(&painter);
+      for (int bufferIndex = 0; bufferIndex < mPaintBuffers.size(); ++bufferIndex)
+        mPaintBuffers.at(bufferIndex)->draw(&painter);
+    }
+  } // the painter ends here, so its flush to the backing store is part of the paint
+  emit afterPaint();
 }
 
 /*! \internal
@@ -14725,8 +15330,29 @@ void QCustomPlot::updateLayout()
 {
   // run through layout phases:
   mPlotLayout->update(QCPLayoutElement::upPreparation);
+  if (mLayoutValid && mPlottingHints.testFlag(QCP::phCacheLayout))
+  {
+    // the preparation phase has set up the tick vectors, skip the other phases if no axis margin can have changed:
+    bool marginsValid = true;
+    foreach (QCPAxisRect *rect, axisRects())
+    {
+      foreach (QCPAxis *axis, rect->axes())
+      {
+        if (axis->visible())
+          marginsValid &= axis->mCachedMarginValid;
+        else if (axis->mCachedMarginValid) // margins are only cached for visible axes, so this one was hidden since the last layout
+        {
+          axis->mCachedMarginValid = false;
+          marginsValid = false;
+        }
+      }
+    }
+    if (marginsValid)
+      return;
+  }
   mPlotLayout->update(QCPLayoutElement::upMargins);
   mPlotLayout->update(QCPLayoutElement::upLayout);
+  mLayoutValid = true;
 }
 
 /*! \internal
@@ -14781,7 +15407,9 @@ void QCustomPlot::drawBackground(QCPPainter *painter)
   This method uses \ref createPaintBuffer to create new paint buffers.
 
   After this method, the paint buffers are empty (filled with \c Qt::transparent) and invalidated
-  (so an attempt to replot only a single buffered layer causes a full replot).
+  (so an attempt to replot only a single buffered layer causes a full replot). The exception are
+  the buffers of layers with a scroll axis (\ref QCPLayer::setScrollAxis) that could scroll their
+  previous contents: they keep them, and the layer only redraws the strip that was uncovered.
 
   This method is called in every \ref replot call, prior to actually drawing the layers (into their
   associated paint buffer). If the paint buffers don't need changing/reallocating, this method
@@ -14816,11 +15444,21 @@ void QCustomPlot::setupPaintBuffers()
   // remove unneeded buffers:
   while (mPaintBuffers.size()-1 > bufferIndex)
     mPaintBuffers.removeLast();
-  // resize buffers to viewport size and clear contents:
+  // resize buffers to viewport size:
   for (int i=0; i<mPaintBuffers.size(); ++i)
-  {
     mPaintBuffers.at(i)->setSize(viewport().size()); // won't do anything if already correct size
-    mPaintBuffers.at(i)->clear(Qt::transparent);
+  // layers with a scroll axis move their previous contents and only redraw the uncovered strip:
+  QList<QCPAbstractPaintBuffer*> scrolledBuffers;
+  foreach (QCPLayer *layer, mLayers)
+  {
+    if (layer->scrollPaintBuffer())
+      scrolledBuffers.append(layer->mPaintBuffer.data());
+  }
+  // clear contents of all other buffers:
+  for (int i=0; i<mPaintBuffers.size(); ++i)
+  {
+    if (!scrolledBuffers.contains(mPaintBuffers.at(i).data()))
+      mPaintBuffers.at(i)->clear(Qt::transparent);
     mPaintBuffers.at(i)->setInvalidated();
   }
 }
@@ -15607,6 +16245,168 @@ void QCPColorGradient::setPeriodic(bool enabled)
   mPeriodic = enabled;
 }
 
+#ifdef QCP_USE_AVX
+/*! \internal
+  
+  AVX part of the linear index conversion in \ref qcpColorIndices for contiguous data. Returns the
+  number of values converted, a multiple of 4.
+*/
+QCP_TARGET_AVX static int qcpColorIndicesAvx(const double *data, int *indices, int n, double lower, double posToIndexFactor)
+{
+  const __m256d lower4 = _mm256_set1_pd(lower);
+  const __m256d factor4 = _mm256_set1_pd(posToIndexFactor);
+  int i = 0;
+  for (; i+4<=n; i+=4)
+    _mm_storeu_si128((__m128i*)(indices+i), _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(data+i), lower4), factor4)));
+  return i;
+}
+
+/*! \internal
+  
+  Clamps \a indices to <tt>[0, levelCount-1]</tt> with the SSE4.1 min/max that every AVX CPU has.
+  Returns the number of indices clamped, a multiple of 4.
+*/
+QCP_TARGET_AVX static int qcpClampIndicesAvx(int *indices, int n, int levelCount)
+{
+  const __m128i minIndex4 = _mm_setzero_si128();
+  const __m128i maxIndex4 = _mm_set1_epi32(levelCount-1);
+  int i = 0;
+  for (; i+4<=n; i+=4)
+  {
+    __m128i index4 = _mm_loadu_si128((const __m128i*)(indices+i));
+    _mm_storeu_si128((__m128i*)(indices+i), _mm_min_epi32(_mm_max_epi32(index4, minIndex4), maxIndex4));
+  }
+  return i;
+}
+
+/*! \internal
+  
+  AVX2 gather part of \ref qcpLookupColors. Returns the number of pixels looked up, a multiple of 8.
+*/
+QCP_TARGET_AVX2 static int qcpLookupColorsAvx2(const QRgb *colors, const int *indices, QRgb *scanLine, int n)
+{
+  int i = 0;
+  for (; i+8<=n; i+=8)
+    _mm256_storeu_si256((__m256i*)(scanLine+i), _mm256_i32gather_epi32((const int*)colors, _mm256_loadu_si256((const __m256i*)(indices+i)), 4));
+  return i;
+}
+#endif
+
+/*! \internal
+  
+  Computes the color buffer indices of the \a n values <tt>data[i*stride]</tt> for a gradient with
+  \a levelCount levels over \a range, exactly like \ref QCPColorGradient::color does for a single
+  value: the position is truncated to an integer and then wrapped (\a periodic) or clamped to the
+  gradient.
+  
+  On linear ranges, contiguous data is converted with AVX (if the CPU has it, see \ref
+  qcpSimdLevel) or SSE2. The conversion truncates like the scalar cast, including the out-of-range
+  and NaN values that the x86 cast maps to INT_MIN (and thus to the first level), so all paths give
+  the same indices as long as the scalar subtract and multiply aren't contracted into a fused
+  multiply-add. Logarithmic ranges evaluate qLn per value and only share the wrapping and clamping.
+*/
+static void qcpColorIndices(const double *data, int stride, int *indices, int n, const QCPRange &range, int levelCount, bool periodic, bool logarithmic)
+{
+  int i = 0;
+#ifdef QCP_USE_AVX
+  const bool avx = qcpSimdLevel() >= 1;
+#endif
+  if (!logarithmic)
+  {
+    const double lower = range.lower;
+    const double posToIndexFactor = (levelCount-1)/range.size();
+    if (stride == 1)
+    {
+#ifdef QCP_USE_AVX
+      if (avx)
+        i = qcpColorIndicesAvx(data, indices, n, lower, posToIndexFactor);
+#endif
+#ifdef QCP_USE_SSE2
+      const __m128d lower2 = _mm_set1_pd(lower);
+      const __m128d factor2 = _mm_set1_pd(posToIndexFactor);
+      for (; i+2<=n; i+=2)
+        _mm_storel_epi64((__m128i*)(indices+i), _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(data+i), lower2), factor2)));
+#endif
+    }
+    for (; i<n; ++i)
+      indices[i] = (data[i*stride]-lower)*posToIndexFactor;
+  } else
+  {
+    const double logRange = qLn(range.upper/range.lower);
+    for (; i<n; ++i)
+      indices[i] = qLn(data[i*stride]/range.lower)/logRange*(levelCount-1);
+  }
+  
+  i = 0;
+  if (periodic)
+  {
+    for (; i<n; ++i)
+    {
+      indices[i] %= levelCount;
+      if (indices[i] < 0)
+        indices[i] += levelCount;
+    }
+    return;
+  }
+#ifdef QCP_USE_AVX
+  if (avx)
+    i = qcpClampIndicesAvx(indices, n, levelCount);
+#endif
+#ifdef QCP_USE_SSE2
+  const __m128i maxIndex4 = _mm_set1_epi32(levelCount-1);
+  for (; i+4<=n; i+=4)
+  {
+    __m128i index4 = _mm_loadu_si128((const __m128i*)(indices+i));
+    index4 = _mm_andnot_si128(_mm_srai_epi32(index4, 31), index4); // negative indices to 0
+    const __m128i tooLarge = _mm_cmpgt_epi32(index4, maxIndex4);
+    _mm_storeu_si128((__m128i*)(indices+i), _mm_or_si128(_mm_and_si128(tooLarge, maxIndex4), _mm_andnot_si128(tooLarge, index4)));
+  }
+#endif
+  for (; i<n; ++i)
+  {
+    if (indices[i] < 0)
+      indices[i] = 0;
+    else if (indices[i] >= levelCount)
+      indices[i] = levelCount-1;
+  }
+}
+
+/*! \internal
+  
+  Sets <tt>scanLine[i] = colors[indices[i]]</tt> for \a n pixels, with AVX2 gathers if the CPU
+  has them.
+*/
+static void qcpLookupColors(const QRgb *colors, const int *indices, QRgb *scanLine, int n)
+{
+  int i = 0;
+#ifdef QCP_USE_AVX
+  if (qcpSimdLevel() >= 2)
+    i = qcpLookupColorsAvx2(colors, indices, scanLine, n);
+#endif
+  for (; i<n; ++i)
+    scanLine[i] = colors[indices[i]];
+}
+
+/*! \internal
+  
+  Returns the premultiplied color \a rgb scaled by \a alpha, i.e. every channel multiplied by
+  <tt>alpha/255.0f</tt> and truncated. With SSE2, the four channels are scaled in one float vector,
+  with the same single precision products as the scalar path.
+*/
+static inline QRgb qcpScaleRgba(QRgb rgb, unsigned char alpha)
+{
+  const float alphaF = alpha/255.0f;
+#ifdef QCP_USE_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(int(rgb)), zero), zero);
+  channels = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(alphaF)));
+  channels = _mm_packs_epi32(channels, channels);
+  return QRgb(_mm_cvtsi128_si32(_mm_packus_epi16(channels, channels)));
+#else
+  return qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
+#endif
+}
+
 /*! \overload
   
   This method is used to quickly convert a \a data array to colors. The colors will be output in
@@ -15641,53 +16441,13 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
   if (mColorBufferInvalidated)
     updateColorBuffer();
   
-  if (!logarithmic)
-  {
-    const double posToIndexFactor = (mLevelCount-1)/range.size();
-    if (mPeriodic)
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (int)((data[dataIndexFactor*i]-range.lower)*posToIndexFactor) % mLevelCount;
-        if (index < 0)
-          index += mLevelCount;
-        scanLine[i] = mColorBuffer.at(index);
-      }
-    } else
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (data[dataIndexFactor*i]-range.lower)*posToIndexFactor;
-        if (index < 0)
-          index = 0;
-        else if (index >= mLevelCount)
-          index = mLevelCount-1;
-        scanLine[i] = mColorBuffer.at(index);
-      }
-    }
-  } else // logarithmic == true
+  // convert blocks of data to color buffer indices, then look the colors up:
+  int indices[QCP_COLORIZE_BLOCK];
+  for (int blockBegin=0; blockBegin<n; blockBegin+=QCP_COLORIZE_BLOCK)
   {
-    if (mPeriodic)
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1)) % mLevelCount;
-        if (index < 0)
-          index += mLevelCount;
-        scanLine[i] = mColorBuffer.at(index);
-      }
-    } else
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1);
-        if (index < 0)
-          index = 0;
-        else if (index >= mLevelCount)
-          index = mLevelCount-1;
-        scanLine[i] = mColorBuffer.at(index);
-      }
-    }
+    const int blockSize = qMin(QCP_COLORIZE_BLOCK, n-blockBegin);
+    qcpColorIndices(data+dataIndexFactor*blockBegin, dataIndexFactor, indices, blockSize, range, mLevelCount, mPeriodic, logarithmic);
+    qcpLookupColors(mColorBuffer.constData(), indices, scanLine+blockBegin, blockSize);
   }
 }
 
@@ -15720,84 +16480,19 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
   if (mColorBufferInvalidated)
     updateColorBuffer();
   
-  if (!logarithmic)
-  {
-    const double posToIndexFactor = (mLevelCount-1)/range.size();
-    if (mPeriodic)
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (int)((data[dataIndexFactor*i]-range.lower)*posToIndexFactor) % mLevelCount;
-        if (index < 0)
-          index += mLevelCount;
-        if (alpha[dataIndexFactor*i] == 255)
-        {
-          scanLine[i] = mColorBuffer.at(index);
-        } else
-        {
-          const QRgb rgb = mColorBuffer.at(index);
-          const float alphaF = alpha[dataIndexFactor*i]/255.0f;
-          scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
-        }
-      }
-    } else
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (data[dataIndexFactor*i]-range.lower)*posToIndexFactor;
-        if (index < 0)
-          index = 0;
-        else if (index >= mLevelCount)
-          index = mLevelCount-1;
-        if (alpha[dataIndexFactor*i] == 255)
-        {
-          scanLine[i] = mColorBuffer.at(index);
-        } else
-        {
-          const QRgb rgb = mColorBuffer.at(index);
-          const float alphaF = alpha[dataIndexFactor*i]/255.0f;
-          scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
-        }
-      }
-    }
-  } else // logarithmic == true
+  // convert blocks of data to color buffer indices, look the colors up and apply alpha where it isn't opaque:
+  int indices[QCP_COLORIZE_BLOCK];
+  for (int blockBegin=0; blockBegin<n; blockBegin+=QCP_COLORIZE_BLOCK)
   {
-    if (mPeriodic)
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1)) % mLevelCount;
-        if (index < 0)
-          index += mLevelCount;
-        if (alpha[dataIndexFactor*i] == 255)
-        {
-          scanLine[i] = mColorBuffer.at(index);
-        } else
-        {
-          const QRgb rgb = mColorBuffer.at(index);
-          const float alphaF = alpha[dataIndexFactor*i]/255.0f;
-          scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
-        }
-      }
-    } else
+    const int blockSize = qMin(QCP_COLORIZE_BLOCK, n-blockBegin);
+    QRgb *blockScanLine = scanLine+blockBegin;
+    const unsigned char *blockAlpha = alpha+dataIndexFactor*blockBegin;
+    qcpColorIndices(data+dataIndexFactor*blockBegin, dataIndexFactor, indices, blockSize, range, mLevelCount, mPeriodic, logarithmic);
+    qcpLookupColors(mColorBuffer.constData(), indices, blockScanLine, blockSize);
+    for (int i=0; i<blockSize; ++i)
     {
-      for (int i=0; i<n; ++i)
-      {
-        int index = qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1);
-        if (index < 0)
-          index = 0;
-        else if (index >= mLevelCount)
-          index = mLevelCount-1;
-        if (alpha[dataIndexFactor*i] == 255)
-        {
-          scanLine[i] = mColorBuffer.at(index);
-        } else
-        {
-          const QRgb rgb = mColorBuffer.at(index);
-          const float alphaF = alpha[dataIndexFactor*i]/255.0f;
-          scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
-        }
-      }
+      if (blockAlpha[dataIndexFactor*i] != 255)
+        blockScanLine[i] = qcpScaleRgba(blockScanLine[i], blockAlpha[dataIndexFactor*i]);
     }
   }
 }
@@ -19626,26 +20321,30 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
 /* commit 633339dadc92cb10c58ef3556b55570685fafb99 2016-09-13 23:54:56 +0200 */
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-//////////////////// QCPGraphData
+//////////////////// QCPGraphDataT
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/*! \class QCPGraphData
-  \brief Holds the data of one single data point for QCPGraph.
+/*! \class QCPGraphDataT
+  \brief Holds the data of one single data point for QCPGraph and QCPFloatGraph.
   
   The stored data is:
   \li \a key: coordinate on the key axis of this data point (this is the \a mainKey and the \a sortKey)
   \li \a value: coordinate on the value axis of this data point (this is the \a mainValue)
   
-  The container for storing multiple data points is \ref QCPGraphDataContainer. It is a typedef for
-  \ref QCPDataContainer with \ref QCPGraphData as the DataType template parameter. See the
-  documentation there for an explanation regarding the data type's generic methods.
+  \a KeyType and \a ValueType are the storage types of the two members. \ref QCPGraphData, the
+  double/double instantiation, is the data type of QCPGraph; \ref QCPFloatGraphData, the
+  float/float one, takes half the memory and is the data type of QCPFloatGraph.
+  
+  The container for storing multiple data points is \ref QCPDataContainer with the instantiation as
+  the DataType template parameter (\ref QCPGraphDataContainer, \ref QCPFloatGraphDataContainer).
+  See the documentation there for an explanation regarding the data type's generic methods.
   
   \see QCPGraphDataContainer
 */
 
 /* start documentation of inline functions */
 
-/*! \fn double QCPGraphData::sortKey() const
+/*! \fn double QCPGraphDataT::sortKey() const
   
   Returns the \a key member of this data point.
   
@@ -19653,7 +20352,7 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
   see the documentation of \ref QCPDataContainer.
 */
 
-/*! \fn static QCPGraphData QCPGraphData::fromSortKey(double sortKey)
+/*! \fn static QCPGraphDataT QCPGraphDataT::fromSortKey(double sortKey)
   
   Returns a data point with the specified \a sortKey. All other members are set to zero.
   
@@ -19661,7 +20360,7 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
   see the documentation of \ref QCPDataContainer.
 */
 
-/*! \fn static static bool QCPGraphData::sortKeyIsMainKey()
+/*! \fn static static bool QCPGraphDataT::sortKeyIsMainKey()
   
   Since the member \a key is both the data point key coordinate and the data ordering parameter,
   this method returns true.
@@ -19670,7 +20369,7 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
   see the documentation of \ref QCPDataContainer.
 */
 
-/*! \fn double QCPGraphData::mainKey() const
+/*! \fn double QCPGraphDataT::mainKey() const
   
   Returns the \a key member of this data point.
   
@@ -19678,7 +20377,7 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
   see the documentation of \ref QCPDataContainer.
 */
 
-/*! \fn double QCPGraphData::mainValue() const
+/*! \fn double QCPGraphDataT::mainValue() const
   
   Returns the \a value member of this data point.
   
@@ -19686,7 +20385,7 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
   see the documentation of \ref QCPDataContainer.
 */
 
-/*! \fn QCPRange QCPGraphData::valueRange() const
+/*! \fn QCPRange QCPGraphDataT::valueRange() const
   
   Returns a QCPRange with both lower and upper boundary set to \a value of this data point.
   
@@ -19696,24 +20395,6 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
 
 /* end documentation of inline functions */
 
-/*!
-  Constructs a data point with key and value set to zero.
-*/
-QCPGraphData::QCPGraphData() :
-  key(0),
-  value(0)
-{
-}
-
-/*!
-  Constructs a data point with the specified \a key and \a value.
-*/
-QCPGraphData::QCPGraphData(double key, double value) :
-  key(key),
-  value(value)
-{
-}
-
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPGraph
@@ -19793,6 +20474,7 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   setScatterSkip(0);
   setChannelFillGraph(0);
   setAdaptiveSampling(true);
+  setParallelSamplingThreshold(0);
 }
 
 QCPGraph::~QCPGraph()
@@ -19939,6 +20621,22 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
   mAdaptiveSampling = enabled;
 }
 
+/*!
+  Sets the number of visible data points from which on the adaptive sampling of line plots (see
+  \ref setAdaptiveSampling) is split into key range chunks that are sampled in parallel on the
+  global QThreadPool. The chunks are cut only where a new pixel interval is guaranteed to begin, so
+  the result is identical to the one of a single pass.
+  
+  Whether and from which size this saves wall time depends on the machine; bench/parallelsampling
+  times both paths over a range of sizes and checks that their output is identical. Until it has
+  been run on the target hardware, the default is 0, which always samples in a single pass on the
+  calling thread. Parallel sampling only applies to linear key axes.
+*/
+void QCPGraph::setParallelSamplingThreshold(int dataCount)
+{
+  mParallelSamplingThreshold = qMax(0, dataCount);
+}
+
 /*! \overload
   
   Adds the provided points in \a keys and \a values to the current data. The provided vectors
@@ -20020,7 +20718,7 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain,
 void QCPGraph::draw(QCPPainter *painter)
 {
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
-  if (mKeyAxis.data()->range().size() <= 0 || mDataContainer->isEmpty()) return;
+  if (mKeyAxis.data()->range().size() <= 0 || dataCount() == 0) return;
   if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
   
   QVector<QPointF> lines, scatters; // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments
@@ -20121,7 +20819,7 @@ void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 
 /*! \internal
 
-  This method retrieves an optimized set of data points via \ref getOptimizedLineData, an branches
+  This method retrieves an optimized set of data points via \ref getLineData, an branches
   out to the line style specific functions such as \ref dataToLines, \ref dataToStepLeftLines, etc.
   according to the line style of the graph.
 
@@ -20142,17 +20840,13 @@ void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 void QCPGraph::getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const
 {
   if (!lines) return;
-  QCPGraphDataContainer::const_iterator begin, end;
-  getVisibleDataBounds(begin, end, dataRange);
-  if (begin == end)
+  QVector<QCPGraphData> lineData;
+  getLineData(&lineData, dataRange);
+  if (lineData.isEmpty())
   {
     lines->clear();
     return;
   }
-  
-  QVector<QCPGraphData> lineData;
-  if (mLineStyle != lsNone)
-    getOptimizedLineData(&lineData, begin, end);
 
   switch (mLineStyle)
   {
@@ -20167,7 +20861,7 @@ void QCPGraph::getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange)
 
 /*! \internal
 
-  This method retrieves an optimized set of data points via \ref getOptimizedScatterData and then
+  This method retrieves an optimized set of data points via \ref getScatterData and then
   converts them to pixel coordinates. The resulting points are returned in \a scatters, and can be
   passed to \ref drawScatterPlot.
 
@@ -20184,40 +20878,54 @@ void QCPGraph::getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataR
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; scatters->clear(); return; }
   
-  QCPGraphDataContainer::const_iterator begin, end;
-  getVisibleDataBounds(begin, end, dataRange);
-  if (begin == end)
-  {
-    scatters->clear();
-    return;
-  }
-  
   QVector<QCPGraphData> data;
-  getOptimizedScatterData(&data, begin, end);
+  getScatterData(&data, dataRange);
   scatters->resize(data.size());
-  if (keyAxis->orientation() == Qt::Vertical)
+  dataToPixels(data.constData(), scatters->data(), data.size());
+  for (int i=0; i<data.size(); ++i)
   {
-    for (int i=0; i<data.size(); ++i)
-    {
-      if (!qIsNaN(data.at(i).value))
-      {
-        (*scatters)[i].setX(valueAxis->coordToPixel(data.at(i).value));
-        (*scatters)[i].setY(keyAxis->coordToPixel(data.at(i).key));
-      }
-    }
-  } else
-  {
-    for (int i=0; i<data.size(); ++i)
-    {
-      if (!qIsNaN(data.at(i).value))
-      {
-        (*scatters)[i].setX(keyAxis->coordToPixel(data.at(i).key));
-        (*scatters)[i].setY(valueAxis->coordToPixel(data.at(i).value));
-      }
-    }
+    if (qIsNaN(data.at(i).value))
+      (*scatters)[i] = QPointF();
   }
 }
 
+/*! \internal
+
+  Returns via \a lineData the data points of the visible part of \a dataRange that \ref getLines
+  converts to pixel coordinates, as provided by \ref getOptimizedLineData. If the line style is
+  \ref lsNone, \a lineData is left empty.
+
+  Subclasses that store their data in a different container than \ref data, like \ref
+  QCPFloatGraph, reimplement this method (and \ref getScatterData) to feed the line and scatter
+  generation of QCPGraph.
+
+  \see getScatterData
+*/
+void QCPGraph::getLineData(QVector<QCPGraphData> *lineData, const QCPDataRange &dataRange) const
+{
+  if (!lineData || mLineStyle == lsNone) return;
+  QCPGraphDataContainer::const_iterator begin, end;
+  getVisibleDataBounds(begin, end, dataRange);
+  if (begin != end)
+    getOptimizedLineData(lineData, begin, end);
+}
+
+/*! \internal
+
+  Returns via \a scatterData the data points of the visible part of \a dataRange that \ref
+  getScatters converts to pixel coordinates, as provided by \ref getOptimizedScatterData.
+
+  \see getLineData
+*/
+void QCPGraph::getScatterData(QVector<QCPGraphData> *scatterData, const QCPDataRange &dataRange) const
+{
+  if (!scatterData) return;
+  QCPGraphDataContainer::const_iterator begin, end;
+  getVisibleDataBounds(begin, end, dataRange);
+  if (begin != end)
+    getOptimizedScatterData(scatterData, begin, end);
+}
+
 /*! \internal
 
   Takes raw data points in plot coordinates as \a data, and returns a vector containing pixel
@@ -20239,21 +20947,7 @@ QVector<QPointF> QCPGraph::dataToLines(const QVector<QCPGraphData> &data) const
   result.resize(data.size());
   
   // transform data points to pixels:
-  if (keyAxis->orientation() == Qt::Vertical)
-  {
-    for (int i=0; i<data.size(); ++i)
-    {
-      result[i].setX(valueAxis->coordToPixel(data.at(i).value));
-      result[i].setY(keyAxis->coordToPixel(data.at(i).key));
-    }
-  } else // key axis is horizontal
-  {
-    for (int i=0; i<data.size(); ++i)
-    {
-      result[i].setX(keyAxis->coordToPixel(data.at(i).key));
-      result[i].setY(valueAxis->coordToPixel(data.at(i).value));
-    }
-  }
+  dataToPixels(data.constData(), result.data(), data.size());
   return result;
 }
 
@@ -20277,28 +20971,30 @@ QVector<QPointF> QCPGraph::dataToStepLeftLines(const QVector<QCPGraphData> &data
   result.reserve(data.size()*2+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   result.resize(data.size()*2);
   
-  // calculate steps from data and transform to pixel coordinates:
+  // transform data points to pixels, then calculate steps in pixel coordinates:
+  QVector<QPointF> pixels(data.size());
+  dataToPixels(data.constData(), pixels.data(), data.size());
   if (keyAxis->orientation() == Qt::Vertical)
   {
-    double lastValue = valueAxis->coordToPixel(data.first().value);
+    double lastValue = pixels.first().x();
     for (int i=0; i<data.size(); ++i)
     {
-      const double key = keyAxis->coordToPixel(data.at(i).key);
+      const double key = pixels.at(i).y();
       result[i*2+0].setX(lastValue);
       result[i*2+0].setY(key);
-      lastValue = valueAxis->coordToPixel(data.at(i).value);
+      lastValue = pixels.at(i).x();
       result[i*2+1].setX(lastValue);
       result[i*2+1].setY(key);
     }
   } else // key axis is horizontal
   {
-    double lastValue = valueAxis->coordToPixel(data.first().value);
+    double lastValue = pixels.first().y();
     for (int i=0; i<data.size(); ++i)
     {
-      const double key = keyAxis->coordToPixel(data.at(i).key);
+      const double key = pixels.at(i).x();
       result[i*2+0].setX(key);
       result[i*2+0].setY(lastValue);
-      lastValue = valueAxis->coordToPixel(data.at(i).value);
+      lastValue = pixels.at(i).y();
       result[i*2+1].setX(key);
       result[i*2+1].setY(lastValue);
     }
@@ -20326,28 +21022,30 @@ QVector<QPointF> QCPGraph::dataToStepRightLines(const QVector<QCPGraphData> &dat
   result.reserve(data.size()*2+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   result.resize(data.size()*2);
   
-  // calculate steps from data and transform to pixel coordinates:
+  // transform data points to pixels, then calculate steps in pixel coordinates:
+  QVector<QPointF> pixels(data.size());
+  dataToPixels(data.constData(), pixels.data(), data.size());
   if (keyAxis->orientation() == Qt::Vertical)
   {
-    double lastKey = keyAxis->coordToPixel(data.first().key);
+    double lastKey = pixels.first().y();
     for (int i=0; i<data.size(); ++i)
     {
-      const double value = valueAxis->coordToPixel(data.at(i).value);
+      const double value = pixels.at(i).x();
       result[i*2+0].setX(value);
       result[i*2+0].setY(lastKey);
-      lastKey = keyAxis->coordToPixel(data.at(i).key);
+      lastKey = pixels.at(i).y();
       result[i*2+1].setX(value);
       result[i*2+1].setY(lastKey);
     }
   } else // key axis is horizontal
   {
-    double lastKey = keyAxis->coordToPixel(data.first().key);
+    double lastKey = pixels.first().x();
     for (int i=0; i<data.size(); ++i)
     {
-      const double value = valueAxis->coordToPixel(data.at(i).value);
+      const double value = pixels.at(i).y();
       result[i*2+0].setX(lastKey);
       result[i*2+0].setY(value);
-      lastKey = keyAxis->coordToPixel(data.at(i).key);
+      lastKey = pixels.at(i).x();
       result[i*2+1].setX(lastKey);
       result[i*2+1].setY(value);
     }
@@ -20375,20 +21073,22 @@ QVector<QPointF> QCPGraph::dataToStepCenterLines(const QVector<QCPGraphData> &da
   result.reserve(data.size()*2+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   result.resize(data.size()*2);
   
-  // calculate steps from data and transform to pixel coordinates:
+  // transform data points to pixels, then calculate steps in pixel coordinates:
+  QVector<QPointF> pixels(data.size());
+  dataToPixels(data.constData(), pixels.data(), data.size());
   if (keyAxis->orientation() == Qt::Vertical)
   {
-    double lastKey = keyAxis->coordToPixel(data.first().key);
-    double lastValue = valueAxis->coordToPixel(data.first().value);
+    double lastKey = pixels.first().y();
+    double lastValue = pixels.first().x();
     result[0].setX(lastValue);
     result[0].setY(lastKey);
     for (int i=1; i<data.size(); ++i)
     {
-      const double key = (keyAxis->coordToPixel(data.at(i).key)+lastKey)*0.5;
+      const double key = (pixels.at(i).y()+lastKey)*0.5;
       result[i*2-1].setX(lastValue);
       result[i*2-1].setY(key);
-      lastValue = valueAxis->coordToPixel(data.at(i).value);
-      lastKey = keyAxis->coordToPixel(data.at(i).key);
+      lastValue = pixels.at(i).x();
+      lastKey = pixels.at(i).y();
       result[i*2+0].setX(lastValue);
       result[i*2+0].setY(key);
     }
@@ -20396,17 +21096,17 @@ QVector<QPointF> QCPGraph::dataToStepCenterLines(const QVector<QCPGraphData> &da
     result[data.size()*2-1].setY(lastKey);
   } else // key axis is horizontal
   {
-    double lastKey = keyAxis->coordToPixel(data.first().key);
-    double lastValue = valueAxis->coordToPixel(data.first().value);
+    double lastKey = pixels.first().x();
+    double lastValue = pixels.first().y();
     result[0].setX(lastKey);
     result[0].setY(lastValue);
     for (int i=1; i<data.size(); ++i)
     {
-      const double key = (keyAxis->coordToPixel(data.at(i).key)+lastKey)*0.5;
+      const double key = (pixels.at(i).x()+lastKey)*0.5;
       result[i*2-1].setX(key);
       result[i*2-1].setY(lastValue);
-      lastValue = valueAxis->coordToPixel(data.at(i).value);
-      lastKey = keyAxis->coordToPixel(data.at(i).key);
+      lastValue = pixels.at(i).y();
+      lastKey = pixels.at(i).x();
       result[i*2+0].setX(key);
       result[i*2+0].setY(lastValue);
     }
@@ -20436,30 +21136,77 @@ QVector<QPointF> QCPGraph::dataToImpulseLines(const QVector<QCPGraphData> &data)
   result.resize(data.size()*2); // no need to reserve 2 extra points because impulse plot has no fill
   
   // transform data points to pixels:
+  QVector<QPointF> pixels(data.size());
+  dataToPixels(data.constData(), pixels.data(), data.size());
+  const double zeroValue = valueAxis->coordToPixel(0);
   if (keyAxis->orientation() == Qt::Vertical)
   {
     for (int i=0; i<data.size(); ++i)
     {
-      const double key = keyAxis->coordToPixel(data.at(i).key);
-      result[i*2+0].setX(valueAxis->coordToPixel(0));
+      const double key = pixels.at(i).y();
+      result[i*2+0].setX(zeroValue);
       result[i*2+0].setY(key);
-      result[i*2+1].setX(valueAxis->coordToPixel(data.at(i).value));
+      result[i*2+1].setX(pixels.at(i).x());
       result[i*2+1].setY(key);
     }
   } else // key axis is horizontal
   {
     for (int i=0; i<data.size(); ++i)
     {
-      const double key = keyAxis->coordToPixel(data.at(i).key);
+      const double key = pixels.at(i).x();
       result[i*2+0].setX(key);
-      result[i*2+0].setY(valueAxis->coordToPixel(0));
+      result[i*2+0].setY(zeroValue);
       result[i*2+1].setX(key);
-      result[i*2+1].setY(valueAxis->coordToPixel(data.at(i).value));
+      result[i*2+1].setY(pixels.at(i).y());
     }
   }
   return result;
 }
 
+/*! \internal
+
+  Transforms \a count data points from \a data to pixel coordinates in \a pixels, taking the
+  orientation of the key axis into account.
+  
+  This is the common transform step of \ref getScatters and the \ref dataToLines family. Keys and
+  values are converted with one batched call per axis (\ref QCPAxis::coordsToPixels) instead of
+  two \ref QCPAxis::coordToPixel calls per point; if both axes are linear, keys and values are
+  transformed together in a single SIMD pass over the interleaved data.
+*/
+void QCPGraph::dataToPixels(const QCPGraphData *data, QPointF *pixels, int count) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  
+  const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+  if (sizeof(qreal) != sizeof(double)) // QPointF can't be treated as a pair of doubles
+  {
+    for (int i=0; i<count; ++i)
+    {
+      const double key = keyAxis->coordToPixel(data[i].key);
+      const double value = valueAxis->coordToPixel(data[i].value);
+      pixels[i] = keyIsVertical ? QPointF(value, key) : QPointF(key, value);
+    }
+    return;
+  }
+  
+  // QCPGraphData and QPointF are both laid out as two doubles, so the point arrays are transformed as interleaved pairs:
+  const double *coords = reinterpret_cast<const double*>(data);
+  double *out = reinterpret_cast<double*>(pixels);
+  if (keyAxis->scaleType() == QCPAxis::stLinear && valueAxis->scaleType() == QCPAxis::stLinear)
+  {
+    double keyScale, keyOffset, valueScale, valueOffset;
+    keyAxis->pixelTransform(&keyScale, &keyOffset);
+    valueAxis->pixelTransform(&valueScale, &valueOffset);
+    qcpAffineTransformPairs(coords, out, count, keyScale, keyOffset, valueScale, valueOffset, keyIsVertical);
+  } else
+  {
+    keyAxis->coordsToPixels(coords, out+(keyIsVertical ? 1 : 0), count, 2);
+    valueAxis->coordsToPixels(coords+1, out+(keyIsVertical ? 0 : 1), count, 2);
+  }
+}
+
 /*! \internal
 
   Draws the fill of the graph using the specified \a painter, with the currently set brush.
@@ -20548,90 +21295,248 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, const QVector<QPointF> &line
 }
 
 /*! \internal
-
-  Returns via \a lineData the data points that need to be visualized for this graph when plotting
-  graph lines, taking into consideration the currently visible axis ranges and, if \ref
-  setAdaptiveSampling is enabled, local point densities. The considered data can be restricted
-  further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
-  getDataSegments).
-
-  This method is used by \ref getLines to retrieve the basic working set of data.
-
-  \see getOptimizedScatterData
+  
+  Returns the key at which the pixel interval containing \a key begins on \a keyAxis, as used by the
+  adaptive sampling of \ref QCPGraph::getOptimizedLineData. \a reversedRound is 1 for reversed
+  pixel orientations, and 0 otherwise.
 */
-void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+static inline double qcpPixelIntervalStartKey(const QCPAxis *keyAxis, double key, int reversedRound)
 {
-  if (!lineData) return;
-  QCPAxis *keyAxis = mKeyAxis.data();
-  QCPAxis *valueAxis = mValueAxis.data();
-  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
-  if (begin == end) return;
+  return keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(key)+reversedRound));
+}
+
+/*! \internal
   
-  int dataCount = end-begin;
-  int maxCount = std::numeric_limits<int>::max();
-  if (mAdaptiveSampling)
+  Appends the adaptively sampled points of the data in [\a begin, \a end) to \a lineData. This is
+  the sampling pass of \ref QCPGraph::getOptimizedLineData, see there for the algorithm.
+  
+  \a Iterator points to graph data with \a key and \a value members, for example of \ref
+  QCPGraphDataContainer or \ref QCPFloatGraphDataContainer. The keys are relative to \a keyOrigin,
+  all keys passed to \a keyAxis and appended to \a lineData are absolute.
+  
+  \a begin must be the first point of a pixel interval. \a lastIntervalEndKey is the key of the
+  point before \a begin (or the key of the first interval start, if \a begin is the first visible
+  point), and \a keyEpsilon the key span of one pixel at the first visible point. If \a end is
+  before \a dataEnd, it must be the first point of a pixel interval too; it is then visited to close
+  the last interval of this chunk exactly like a single pass over [\a begin, \a dataEnd) would.
+*/
+template <class Iterator>
+static void qcpAdaptiveSampleLine(QVector<QCPGraphData> *lineData, const QCPAxis *keyAxis, Iterator begin, Iterator end, Iterator dataEnd,
+                                  double keyOrigin, double lastIntervalEndKey, double keyEpsilon)
+{
+  Iterator it = begin;
+  double minValue = it->value;
+  double maxValue = it->value;
+  Iterator currentIntervalFirstPoint = it;
+  int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  double currentIntervalStartKey = qcpPixelIntervalStartKey(keyAxis, begin->key+keyOrigin, reversedRound);
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+  if (keyEpsilonVariable)
+    keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+  int intervalDataCount = 1;
+  const Iterator stop = end == dataEnd ? end : end+1; // visit the next chunk's first point to close the last interval
+  ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
+  while (it != stop)
+  {
+    if (it->key+keyOrigin < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
+    {
+      if (it->value < minValue)
+        minValue = it->value;
+      else if (it->value > maxValue)
+        maxValue = it->value;
+      ++intervalDataCount;
+    } else // new pixel interval started
+    {
+      if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
+      {
+        if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+        if (it->key+keyOrigin > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (it-1)->value));
+      } else
+        lineData->append(QCPGraphData(currentIntervalFirstPoint->key+keyOrigin, currentIntervalFirstPoint->value));
+      lastIntervalEndKey = (it-1)->key+keyOrigin;
+      minValue = it->value;
+      maxValue = it->value;
+      currentIntervalFirstPoint = it;
+      currentIntervalStartKey = qcpPixelIntervalStartKey(keyAxis, it->key+keyOrigin, reversedRound);
+      if (keyEpsilonVariable)
+        keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+      intervalDataCount = 1;
+    }
+    ++it;
+  }
+  if (end != dataEnd) // last interval was closed by the first point of the next chunk
+    return;
+  // handle last interval:
+  if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
   {
-    double keyPixelSpan = qAbs(keyAxis->coordToPixel(begin->key)-keyAxis->coordToPixel((end-1)->key));
+    if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point wasn't a cluster, so first point of this cluster must be at a real data point
+      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
+    lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+    lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+  } else
+    lineData->append(QCPGraphData(currentIntervalFirstPoint->key+keyOrigin, currentIntervalFirstPoint->value));
+}
+
+/*! \internal
+  
+  Shared state of a parallel adaptive sampling pass in \ref QCPGraph::getOptimizedLineData. The
+  calling thread and the QCPAdaptiveSamplingTask instances on the thread pool all call \ref work,
+  which claims and samples chunks until none are left, each into its own output vector.
+*/
+template <class Iterator>
+class QCPAdaptiveSamplingJob
+{
+public:
+  QCPAdaptiveSamplingJob(const QCPAxis *keyAxis, const QVector<Iterator> &chunkBounds, double keyOrigin, double firstIntervalStartKey, double keyEpsilon) :
+    mKeyAxis(keyAxis),
+    mChunkBounds(chunkBounds),
+    mKeyOrigin(keyOrigin),
+    mFirstIntervalStartKey(firstIntervalStartKey),
+    mKeyEpsilon(keyEpsilon),
+    mChunkData(chunkBounds.size()-1),
+    mNextChunk(0)
+  {}
+  
+  int chunkCount() const { return mChunkData.size(); }
+  const QVector<QCPGraphData> &chunkData(int chunk) const { return mChunkData.at(chunk); }
+  
+  void work()
+  {
+    int chunk;
+    while ((chunk = mNextChunk.fetchAndAddOrdered(1)) < chunkCount())
+    {
+      Iterator chunkBegin = mChunkBounds.at(chunk);
+      double lastIntervalEndKey = chunk == 0 ? mFirstIntervalStartKey : (chunkBegin-1)->key+mKeyOrigin;
+      qcpAdaptiveSampleLine(&mChunkData[chunk], mKeyAxis, chunkBegin, mChunkBounds.at(chunk+1), mChunkBounds.last(), mKeyOrigin, lastIntervalEndKey, mKeyEpsilon);
+      mDoneChunks.release();
+    }
+  }
+  void waitForDone() { mDoneChunks.acquire(chunkCount()); }
+  
+private:
+  const QCPAxis *mKeyAxis;
+  QVector<Iterator> mChunkBounds;
+  double mKeyOrigin, mFirstIntervalStartKey, mKeyEpsilon;
+  QVector<QVector<QCPGraphData> > mChunkData;
+  QAtomicInt mNextChunk;
+  QSemaphore mDoneChunks;
+};
+
+/*! \internal
+  
+  Runs \ref QCPAdaptiveSamplingJob::work on a thread pool thread. The task shares ownership of the
+  job, so tasks that only start after all chunks were claimed by other threads find no work left and
+  return.
+*/
+template <class Iterator>
+class QCPAdaptiveSamplingTask : public QRunnable
+{
+public:
+  explicit QCPAdaptiveSamplingTask(const QSharedPointer<QCPAdaptiveSamplingJob<Iterator> > &job) : mJob(job) {}
+  virtual void run() Q_DECL_OVERRIDE { mJob->work(); }
+  
+private:
+  QSharedPointer<QCPAdaptiveSamplingJob<Iterator> > mJob;
+};
+
+/*! \internal
+  
+  Appends the adaptively sampled line data of [\a begin, \a end) to \a lineData, distributing the
+  sampling over the global QThreadPool if at least \a parallelThreshold points are passed (0
+  disables this). \a Iterator and \a keyOrigin are as for \ref qcpAdaptiveSampleLine.
+  
+  This is the adaptive branch of \ref QCPGraph::getOptimizedLineData, shared with \ref
+  QCPFloatGraph.
+*/
+template <class Iterator>
+static void qcpAdaptiveSampleLineData(QVector<QCPGraphData> *lineData, const QCPAxis *keyAxis, Iterator begin, Iterator end, double keyOrigin, int parallelThreshold)
+{
+  const int dataCount = end-begin;
+  int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  double firstIntervalStartKey = qcpPixelIntervalStartKey(keyAxis, begin->key+keyOrigin, reversedRound);
+  double keyEpsilon = qAbs(firstIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(firstIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
+  
+  // find chunk boundaries for parallel sampling. A point starts a new pixel interval in the serial pass if it lies one
+  // keyEpsilon beyond the interval start of its predecessor, because no interval that contains the predecessor can start
+  // later than that. On linear axes keyEpsilon is constant, so chunks cut at such points sample exactly like the serial pass:
+  QVector<Iterator> chunkBounds;
+  chunkBounds << begin;
+  if (parallelThreshold > 0 && dataCount >= parallelThreshold && keyAxis->scaleType() == QCPAxis::stLinear)
+  {
+    const int chunkCount = qBound(1, qMin(QThread::idealThreadCount(), dataCount/QCP_PARALLEL_SAMPLING_MIN_CHUNK), 64);
+    const int chunkSize = dataCount/chunkCount;
+    for (int i=1; i<chunkCount; ++i)
+    {
+      Iterator it = begin+i*chunkSize;
+      Iterator searchEnd = qMin(end, it+chunkSize);
+      while (it != searchEnd && it->key+keyOrigin < qcpPixelIntervalStartKey(keyAxis, (it-1)->key+keyOrigin, reversedRound)+keyEpsilon)
+        ++it;
+      if (it != searchEnd && it != chunkBounds.last())
+        chunkBounds << it;
+    }
+  }
+  chunkBounds << end;
+  
+  if (chunkBounds.size() > 2)
+  {
+    // this thread samples chunks alongside the pool, and only waits for chunks that are already being sampled elsewhere,
+    // so a busy or exhausted pool can't stall or deadlock the replot:
+    QSharedPointer<QCPAdaptiveSamplingJob<Iterator> > job(new QCPAdaptiveSamplingJob<Iterator>(keyAxis, chunkBounds, keyOrigin, firstIntervalStartKey, keyEpsilon));
+    for (int i=1; i<job->chunkCount(); ++i)
+      QThreadPool::globalInstance()->start(new QCPAdaptiveSamplingTask<Iterator>(job));
+    job->work();
+    job->waitForDone();
+    int resultCount = lineData->size();
+    for (int i=0; i<job->chunkCount(); ++i)
+      resultCount += job->chunkData(i).size();
+    lineData->reserve(resultCount+2); // +2 for possible fill end points
+    for (int i=0; i<job->chunkCount(); ++i)
+      *lineData += job->chunkData(i);
+  } else
+    qcpAdaptiveSampleLine(lineData, keyAxis, begin, end, end, keyOrigin, firstIntervalStartKey, keyEpsilon);
+}
+
+/*! \internal
+
+  Returns via \a lineData the data points that need to be visualized for this graph when plotting
+  graph lines, taking into consideration the currently visible axis ranges and, if \ref
+  setAdaptiveSampling is enabled, local point densities. The considered data can be restricted
+  further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
+  getDataSegments).
+
+  If more than \ref setParallelSamplingThreshold points are visible, the adaptive sampling is
+  distributed over the global QThreadPool in key range chunks, with identical results.
+
+  This method is used by \ref getLineData to retrieve the basic working set of data.
+
+  \see getOptimizedScatterData
+*/
+void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+{
+  if (!lineData) return;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  if (begin == end) return;
+  
+  int dataCount = end-begin;
+  int maxCount = std::numeric_limits<int>::max();
+  if (mAdaptiveSampling)
+  {
+    double keyPixelSpan = qAbs(keyAxis->coordToPixel(begin->key)-keyAxis->coordToPixel((end-1)->key));
     if (2*keyPixelSpan+2 < (double)std::numeric_limits<int>::max())
       maxCount = 2*keyPixelSpan+2;
   }
   
   if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
   {
-    QCPGraphDataContainer::const_iterator it = begin;
-    double minValue = it->value;
-    double maxValue = it->value;
-    QCPGraphDataContainer::const_iterator currentIntervalFirstPoint = it;
-    int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
-    int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
-    double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(begin->key)+reversedRound));
-    double lastIntervalEndKey = currentIntervalStartKey;
-    double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
-    bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
-    int intervalDataCount = 1;
-    ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
-    while (it != end)
-    {
-      if (it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
-      {
-        if (it->value < minValue)
-          minValue = it->value;
-        else if (it->value > maxValue)
-          maxValue = it->value;
-        ++intervalDataCount;
-      } else // new pixel interval started
-      {
-        if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
-        {
-          if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
-            lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
-          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
-          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
-          if (it->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
-            lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (it-1)->value));
-        } else
-          lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
-        lastIntervalEndKey = (it-1)->key;
-        minValue = it->value;
-        maxValue = it->value;
-        currentIntervalFirstPoint = it;
-        currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it->key)+reversedRound));
-        if (keyEpsilonVariable)
-          keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
-        intervalDataCount = 1;
-      }
-      ++it;
-    }
-    // handle last interval:
-    if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
-    {
-      if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point wasn't a cluster, so first point of this cluster must be at a real data point
-        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
-      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
-      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
-    } else
-      lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
-    
+    qcpAdaptiveSampleLineData(lineData, keyAxis, begin, end, 0.0, mParallelSamplingThreshold);
   } else // don't use adaptive sampling algorithm, transfer points one-to-one from the data container into the output
   {
     QCPGraphDataContainer::const_iterator it = begin;
@@ -20652,11 +21557,22 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
   further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
   getDataSegments).
 
-  This method is used by \ref getScatters to retrieve the basic working set of data.
+  This method is used by \ref getScatterData to retrieve the basic working set of data.
 
   \see getOptimizedLineData
 */
 void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end) const
+{
+  sampleScatterData(scatterData, begin, end, begin-mDataContainer->constBegin());
+}
+
+/*! \internal
+
+  Implements \ref getOptimizedScatterData for the data in [\a begin, \a end), which needn't be
+  part of this graph's own data container. \a beginIndex is the data index of \a begin, so the
+  scatter skip (\ref setScatterSkip) stays aligned to the data indices of the graph.
+*/
+void QCPGraph::sampleScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end, int beginIndex) const
 {
   if (!scatterData) return;
   QCPAxis *keyAxis = mKeyAxis.data();
@@ -20665,8 +21581,7 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
   
   const int scatterModulo = mScatterSkip+1;
   const bool doScatterSkip = mScatterSkip > 0;
-  int beginIndex = begin-mDataContainer->constBegin();
-  int endIndex = end-mDataContainer->constBegin();
+  int endIndex = beginIndex+int(end-begin);
   while (doScatterSkip && begin != end && beginIndex % scatterModulo != 0) // advance begin iterator to first non-skipped scatter
   {
     ++beginIndex;
@@ -20778,7 +21693,7 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
       double valuePixelSpan = qAbs(valueAxis->coordToPixel(minValue)-valueAxis->coordToPixel(maxValue));
       int dataModulo = qMax(1, qRound(intervalDataCount/(valuePixelSpan/4.0))); // approximately every 4 value pixels one data point on average
       QCPGraphDataContainer::const_iterator intervalIt = currentIntervalStart;
-      int intervalItIndex = intervalIt-mDataContainer->constBegin();
+      int intervalItIndex = beginIndex+int(intervalIt-begin);
       int c = 0;
       while (intervalIt != it)
       {
@@ -20849,13 +21764,36 @@ void QCPGraph::getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin
     QCPAxis *valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
     // get visible data range:
-    begin = mDataContainer->findBegin(keyAxis->range().lower);
-    end = mDataContainer->findEnd(keyAxis->range().upper);
+    const QCPRange keyRange = getVisibleKeyRange();
+    begin = mDataContainer->findBegin(keyRange.lower);
+    end = mDataContainer->findEnd(keyRange.upper);
     // limit lower/upperEnd to rangeRestriction:
     mDataContainer->limitIteratorsToDataRange(begin, end, rangeRestriction); // this also ensures rangeRestriction outside data bounds doesn't break anything
   }
 }
 
+/*! \internal
+
+  Returns the key range in which data needs to be drawn. This is the key axis range, unless the
+  layer of this graph only redraws the strip uncovered by scrolling its paint buffer (see \ref
+  QCPLayer::setScrollAxis). Then it is the key range of that strip, so only the new data is sampled
+  and drawn.
+*/
+QCPRange QCPGraph::getVisibleKeyRange() const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  const QRect exposed = mLayer ? mLayer->scrollExposedRect() : QRect();
+  if (exposed.isNull())
+    return keyAxis->range();
+  QCPRange result;
+  if (keyAxis->orientation() == Qt::Horizontal)
+    result = QCPRange(keyAxis->pixelToCoord(exposed.left()), keyAxis->pixelToCoord(exposed.right()+1));
+  else
+    result = QCPRange(keyAxis->pixelToCoord(exposed.bottom()+1), keyAxis->pixelToCoord(exposed.top()));
+  result.normalize();
+  return result;
+}
+
 /*! \internal
   
   The line vector generated by e.g. \ref getLines describes only the line that connects the data
@@ -21327,6 +22265,398 @@ int QCPGraph::findIndexBelowY(const QVector<QPointF> *data, double y) const
   }
   return -1;
 }
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPFloatGraph
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPFloatGraph
+  \brief A graph that stores its data in single precision
+
+  QCPFloatGraph is drawn, styled and selected like a QCPGraph, but holds its data points as \ref
+  QCPFloatGraphData, a key and a value of type float, in a \ref QCPFloatGraphDataContainer. A data
+  point takes 8 instead of 16 bytes, so long recordings need half the memory, and the line and
+  scatter generation streams half as many bytes through the cache.
+
+  A float has a 24 bit mantissa, which isn't enough for absolute keys like seconds since 1970. The
+  keys are therefore stored relative to the \ref setKeyOrigin "key origin", typically the start of
+  a recording session. With seconds as key unit, keys eight hours past the origin still resolve
+  about 2 ms. All methods of the graph (\ref setData, \ref addData, \ref getKeyRange, \ref
+  findBegin, etc.) take and return absolute keys, only \ref floatData exposes the relative keys.
+
+  The data of a QCPFloatGraph lives in \ref floatData, the double precision container of QCPGraph
+  (\ref QCPGraph::data) stays empty. Call \ref setData and \ref addData on a QCPFloatGraph pointer,
+  since the QCPGraph methods of the same name aren't virtual.
+
+  Unlike QCPGraph instances created by \ref QCustomPlot::addGraph, the graph is created with \a
+  new, and is registered with the parent plot of \a keyAxis like any other graph.
+*/
+
+/* start of documentation of inline functions */
+
+/*! \fn QSharedPointer<QCPFloatGraphDataContainer> QCPFloatGraph::floatData() const
+  
+  Returns a shared pointer to the internal data storage of type \ref QCPFloatGraphDataContainer.
+  The keys in the container are relative to \ref keyOrigin.
+*/
+
+/* end of documentation of inline functions */
+
+/*!
+  Constructs a graph which uses \a keyAxis as its key axis ("x") and \a valueAxis as its value
+  axis ("y"), like \ref QCPGraph::QCPGraph. The key origin is initially 0.
+*/
+QCPFloatGraph::QCPFloatGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
+  QCPGraph(keyAxis, valueAxis),
+  mFloatDataContainer(new QCPFloatGraphDataContainer),
+  mKeyOrigin(0)
+{
+}
+
+QCPFloatGraph::~QCPFloatGraph()
+{
+}
+
+/*!
+  Replaces the current data with the provided points in \a keys and \a values, see \ref
+  QCPGraph::setData. The keys are converted relative to \ref keyOrigin.
+  
+  \see addData
+*/
+void QCPFloatGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+  mFloatDataContainer->clear();
+  addData(keys, values, alreadySorted);
+}
+
+/*!
+  Sets the key which the keys in \ref floatData are relative to. Choose it close to the keys of the
+  data, e.g. the start of the recording, to keep the float keys precise.
+  
+  Existing data points are converted to the new origin, which rounds their keys once more. So
+  preferably set the origin before adding data.
+*/
+void QCPFloatGraph::setKeyOrigin(double origin)
+{
+  if (origin == mKeyOrigin)
+    return;
+  for (QCPFloatGraphDataContainer::iterator it=mFloatDataContainer->begin(); it!=mFloatDataContainer->end(); ++it)
+    it->key = float(it->key+mKeyOrigin-origin);
+  mKeyOrigin = origin;
+}
+
+/*! \overload
+  
+  Adds the provided points in \a keys and \a values to the current data, see \ref
+  QCPGraph::addData. The keys are converted relative to \ref keyOrigin.
+*/
+void QCPFloatGraph::addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+  if (keys.size() != values.size())
+    qDebug() << Q_FUNC_INFO << "keys and values have different sizes:" << keys.size() << values.size();
+  const int n = qMin(keys.size(), values.size());
+  QVector<QCPFloatGraphData> tempData(n);
+  for (int i=0; i<n; ++i)
+    tempData[i] = toFloatData(keys.at(i), values.at(i));
+  mFloatDataContainer->add(tempData, alreadySorted); // don't modify tempData beyond this to prevent copy on write
+}
+
+/*! \overload
+  
+  Adds the provided data point as \a key and \a value to the current data. \a key is converted
+  relative to \ref keyOrigin.
+*/
+void QCPFloatGraph::addData(double key, double value)
+{
+  mFloatDataContainer->add(toFloatData(key, value));
+}
+
+/* inherits documentation from base class */
+int QCPFloatGraph::dataCount() const
+{
+  return mFloatDataContainer->size();
+}
+
+/* inherits documentation from base class */
+double QCPFloatGraph::dataMainKey(int index) const
+{
+  if (index >= 0 && index < mFloatDataContainer->size())
+  {
+    return (mFloatDataContainer->constBegin()+index)->key+mKeyOrigin;
+  } else
+  {
+    qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+    return 0;
+  }
+}
+
+/* inherits documentation from base class */
+double QCPFloatGraph::dataSortKey(int index) const
+{
+  return dataMainKey(index);
+}
+
+/* inherits documentation from base class */
+double QCPFloatGraph::dataMainValue(int index) const
+{
+  if (index >= 0 && index < mFloatDataContainer->size())
+  {
+    return (mFloatDataContainer->constBegin()+index)->value;
+  } else
+  {
+    qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+    return 0;
+  }
+}
+
+/* inherits documentation from base class */
+QCPRange QCPFloatGraph::dataValueRange(int index) const
+{
+  if (index >= 0 && index < mFloatDataContainer->size())
+  {
+    return (mFloatDataContainer->constBegin()+index)->valueRange();
+  } else
+  {
+    qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+    return QCPRange(0, 0);
+  }
+}
+
+/* inherits documentation from base class */
+QPointF QCPFloatGraph::dataPixelPosition(int index) const
+{
+  if (index >= 0 && index < mFloatDataContainer->size())
+  {
+    const QCPFloatGraphDataContainer::const_iterator it = mFloatDataContainer->constBegin()+index;
+    return coordsToPixels(it->key+mKeyOrigin, it->value);
+  } else
+  {
+    qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+    return QPointF();
+  }
+}
+
+/* inherits documentation from base class */
+QCPDataSelection QCPFloatGraph::selectTestRect(const QRectF &rect, bool onlySelectable) const
+{
+  QCPDataSelection result;
+  if ((onlySelectable && mSelectable == QCP::stNone) || mFloatDataContainer->isEmpty())
+    return result;
+  if (!mKeyAxis || !mValueAxis)
+    return result;
+  
+  // convert rect given in pixels to ranges given in plot coordinates:
+  double key1, value1, key2, value2;
+  pixelsToCoords(rect.topLeft(), key1, value1);
+  pixelsToCoords(rect.bottomRight(), key2, value2);
+  QCPRange keyRange(key1, key2); // QCPRange normalizes internally so we don't have to care about whether key1 < key2
+  QCPRange valueRange(value1, value2);
+  const QCPFloatGraphDataContainer::const_iterator dataBegin = mFloatDataContainer->constBegin();
+  QCPFloatGraphDataContainer::const_iterator begin = mFloatDataContainer->findBegin(keyRange.lower-mKeyOrigin, false);
+  QCPFloatGraphDataContainer::const_iterator end = mFloatDataContainer->findEnd(keyRange.upper-mKeyOrigin, false);
+  
+  int currentSegmentBegin = -1; // -1 means we're currently not in a segment that's contained in rect
+  for (QCPFloatGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+  {
+    const bool contained = valueRange.contains(it->value) && keyRange.contains(it->key+mKeyOrigin);
+    if (currentSegmentBegin == -1)
+    {
+      if (contained) // start segment
+        currentSegmentBegin = it-dataBegin;
+    } else if (!contained) // segment just ended
+    {
+      result.addDataRange(QCPDataRange(currentSegmentBegin, it-dataBegin), false);
+      currentSegmentBegin = -1;
+    }
+  }
+  // process potential last segment:
+  if (currentSegmentBegin != -1)
+    result.addDataRange(QCPDataRange(currentSegmentBegin, end-dataBegin), false);
+  
+  result.simplify();
+  return result;
+}
+
+/* inherits documentation from base class */
+int QCPFloatGraph::findBegin(double sortKey, bool expandedRange) const
+{
+  return mFloatDataContainer->findBegin(sortKey-mKeyOrigin, expandedRange)-mFloatDataContainer->constBegin();
+}
+
+/* inherits documentation from base class */
+int QCPFloatGraph::findEnd(double sortKey, bool expandedRange) const
+{
+  return mFloatDataContainer->findEnd(sortKey-mKeyOrigin, expandedRange)-mFloatDataContainer->constBegin();
+}
+
+/* inherits documentation from base class */
+double QCPFloatGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+  if ((onlySelectable && mSelectable == QCP::stNone) || mFloatDataContainer->isEmpty())
+    return -1;
+  if (!mKeyAxis || !mValueAxis)
+    return -1;
+  if (mLineStyle == lsNone && mScatterStyle.isNone())
+    return -1;
+  if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+    return -1;
+  
+  // find the closest data point within the selection tolerance, like QCPGraph::pointDistance:
+  double minDistSqr = std::numeric_limits<double>::max();
+  int closestIndex = -1;
+  double posKeyMin, posKeyMax, dummy;
+  pixelsToCoords(pos-QPointF(mParentPlot->selectionTolerance(), mParentPlot->selectionTolerance()), posKeyMin, dummy);
+  pixelsToCoords(pos+QPointF(mParentPlot->selectionTolerance(), mParentPlot->selectionTolerance()), posKeyMax, dummy);
+  if (posKeyMin > posKeyMax)
+    qSwap(posKeyMin, posKeyMax);
+  const QCPFloatGraphDataContainer::const_iterator dataBegin = mFloatDataContainer->constBegin();
+  QCPFloatGraphDataContainer::const_iterator begin = mFloatDataContainer->findBegin(posKeyMin-mKeyOrigin, true);
+  QCPFloatGraphDataContainer::const_iterator end = mFloatDataContainer->findEnd(posKeyMax-mKeyOrigin, true);
+  for (QCPFloatGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+  {
+    const double currentDistSqr = QCPVector2D(coordsToPixels(it->key+mKeyOrigin, it->value)-pos).lengthSquared();
+    if (currentDistSqr < minDistSqr)
+    {
+      minDistSqr = currentDistSqr;
+      closestIndex = it-dataBegin;
+    }
+  }
+  
+  // calculate distance to graph line if there is one (if so, will probably be smaller than distance to closest data point):
+  if (mLineStyle != lsNone)
+  {
+    QVector<QPointF> lineData;
+    getLines(&lineData, QCPDataRange(0, dataCount()));
+    QCPVector2D p(pos);
+    const int step = mLineStyle==lsImpulse ? 2 : 1; // impulse plot differs from other line styles in that the lineData points are only pairwise connected
+    for (int i=0; i<lineData.size()-1; i+=step)
+    {
+      const double currentDistSqr = p.distanceSquaredToLine(lineData.at(i), lineData.at(i+1));
+      if (currentDistSqr < minDistSqr)
+        minDistSqr = currentDistSqr;
+    }
+  }
+  
+  if (details)
+  {
+    QCPDataSelection selectionResult;
+    if (closestIndex != -1)
+      selectionResult.addDataRange(QCPDataRange(closestIndex, closestIndex+1), false);
+    details->setValue(selectionResult);
+  }
+  return qSqrt(minDistSqr);
+}
+
+/* inherits documentation from base class */
+QCPRange QCPFloatGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+  foundRange = false;
+  QCPFloatGraphDataContainer::const_iterator begin = mFloatDataContainer->constBegin();
+  QCPFloatGraphDataContainer::const_iterator end = mFloatDataContainer->constEnd();
+  // keys are sorted, so the keys of the requested sign domain are a contiguous range at the front or back:
+  if (inSignDomain == QCP::sdPositive)
+  {
+    while (begin != end && !(begin->key+mKeyOrigin > 0))
+      ++begin;
+  } else if (inSignDomain == QCP::sdNegative)
+  {
+    while (begin != end && !((end-1)->key+mKeyOrigin < 0))
+      --end;
+  }
+  if (begin == end)
+    return QCPRange();
+  foundRange = true;
+  return QCPRange(begin->key+mKeyOrigin, (end-1)->key+mKeyOrigin);
+}
+
+/* inherits documentation from base class */
+QCPRange QCPFloatGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+  QCPRange relativeKeyRange;
+  if (inKeyRange != QCPRange())
+    relativeKeyRange = QCPRange(inKeyRange.lower-mKeyOrigin, inKeyRange.upper-mKeyOrigin);
+  return mFloatDataContainer->valueRange(foundRange, inSignDomain, relativeKeyRange);
+}
+
+/*! \internal
+  
+  Converts the visible part of \a dataRange to absolute keys and double precision, adaptively
+  sampled like \ref QCPGraph::getOptimizedLineData, with the same parallel sampling of large data
+  sets.
+*/
+void QCPFloatGraph::getLineData(QVector<QCPGraphData> *lineData, const QCPDataRange &dataRange) const
+{
+  if (!lineData || mLineStyle == lsNone) return;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  QCPFloatGraphDataContainer::const_iterator begin, end;
+  getVisibleFloatDataBounds(begin, end, dataRange);
+  if (begin == end) return;
+  
+  const int dataCount = end-begin;
+  if (mAdaptiveSampling)
+  {
+    double keyPixelSpan = qAbs(keyAxis->coordToPixel(begin->key+mKeyOrigin)-keyAxis->coordToPixel((end-1)->key+mKeyOrigin));
+    if (dataCount >= 2*keyPixelSpan+2) // use adaptive sampling only if there are at least two points per pixel on average
+    {
+      qcpAdaptiveSampleLineData(lineData, keyAxis, begin, end, mKeyOrigin, mParallelSamplingThreshold);
+      return;
+    }
+  }
+  lineData->reserve(dataCount+2); // +2 for possible fill end points
+  for (QCPFloatGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+    lineData->append(QCPGraphData(it->key+mKeyOrigin, it->value));
+}
+
+/*! \internal
+  
+  Converts the visible part of \a dataRange to absolute keys and double precision, and samples it
+  like \ref QCPGraph::getOptimizedScatterData.
+*/
+void QCPFloatGraph::getScatterData(QVector<QCPGraphData> *scatterData, const QCPDataRange &dataRange) const
+{
+  if (!scatterData) return;
+  QCPFloatGraphDataContainer::const_iterator begin, end;
+  getVisibleFloatDataBounds(begin, end, dataRange);
+  if (begin == end) return;
+  
+  QVector<QCPGraphData> visibleData;
+  visibleData.reserve(end-begin);
+  for (QCPFloatGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+    visibleData.append(QCPGraphData(it->key+mKeyOrigin, it->value));
+  sampleScatterData(scatterData, visibleData.constBegin(), visibleData.constEnd(), begin-mFloatDataContainer->constBegin());
+}
+
+/*! \internal
+  
+  Like \ref QCPGraph::getVisibleDataBounds, for the data in \ref floatData.
+*/
+void QCPFloatGraph::getVisibleFloatDataBounds(QCPFloatGraphDataContainer::const_iterator &begin, QCPFloatGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const
+{
+  end = mFloatDataContainer->constEnd();
+  begin = end;
+  if (rangeRestriction.isEmpty())
+    return;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  // get visible data range:
+  const QCPRange keyRange = getVisibleKeyRange();
+  begin = mFloatDataContainer->findBegin(keyRange.lower-mKeyOrigin);
+  end = mFloatDataContainer->findEnd(keyRange.upper-mKeyOrigin);
+  // limit lower/upperEnd to rangeRestriction:
+  mFloatDataContainer->limitIteratorsToDataRange(begin, end, rangeRestriction);
+}
+
+/*! \internal
+  
+  Returns the data point of \a key and \a value as stored in \ref floatData, i.e. with \a key
+  relative to \ref keyOrigin.
+*/
+QCPFloatGraphData QCPFloatGraph::toFloatData(double key, double value) const
+{
+  return QCPFloatGraphData(float(key-mKeyOrigin), float(value));
+}
 /* end of 'src/plottables/plottable-graph.cpp' */
 
 
@@ -24605,6 +25935,10 @@ QVector<QLineF> QCPStatisticalBox::getWhiskerBarLines(QCPStatisticalBoxDataConta
   true current minimum and maximum. The method QCPColorMap::rescaleDataRange offers a convenience
   parameter \a recalculateDataBounds which may be set to true to automatically call \ref
   recalculateDataBounds internally.
+  
+  For maps that scroll in the key direction, like a waterfall of spectra over time, \ref
+  appendKeyColumn drops the oldest column and adds a new one at the other end. The columns are then
+  kept in a ring, so neither the data array nor the color map's image has to be moved or rebuilt.
 */
 
 /* start of documentation of inline functions */
@@ -24632,7 +25966,9 @@ QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &key
   mIsEmpty(true),
   mData(0),
   mAlpha(0),
-  mDataModified(true)
+  mDataModified(true),
+  mKeyRingStart(0),
+  mAppendedColumns(0)
 {
   setSize(keySize, valueSize);
   fill(0);
@@ -24655,7 +25991,9 @@ QCPColorMapData::QCPColorMapData(const QCPColorMapData &other) :
   mIsEmpty(true),
   mData(0),
   mAlpha(0),
-  mDataModified(true)
+  mDataModified(true),
+  mKeyRingStart(0),
+  mAppendedColumns(0)
 {
   *this = other;
 }
@@ -24683,6 +26021,8 @@ QCPColorMapData &QCPColorMapData::operator=(const QCPColorMapData &other)
         memcpy(mAlpha, other.mAlpha, sizeof(mAlpha[0])*keySize*valueSize);
     }
     mDataBounds = other.mDataBounds;
+    mKeyRingStart = other.mKeyRingStart;
+    mAppendedColumns = 0;
     mDataModified = true;
   }
   return *this;
@@ -24694,7 +26034,7 @@ double QCPColorMapData::data(double key, double value)
   int keyCell = (key-mKeyRange.lower)/(mKeyRange.upper-mKeyRange.lower)*(mKeySize-1)+0.5;
   int valueCell = (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5;
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
-    return mData[valueCell*mKeySize + keyCell];
+    return mData[valueCell*mKeySize + ringKeyIndex(keyCell)];
   else
     return 0;
 }
@@ -24703,7 +26043,7 @@ double QCPColorMapData::data(double key, double value)
 double QCPColorMapData::cell(int keyIndex, int valueIndex)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
-    return mData[valueIndex*mKeySize + keyIndex];
+    return mData[valueIndex*mKeySize + ringKeyIndex(keyIndex)];
   else
     return 0;
 }
@@ -24719,7 +26059,7 @@ double QCPColorMapData::cell(int keyIndex, int valueIndex)
 unsigned char QCPColorMapData::alpha(int keyIndex, int valueIndex)
 {
   if (mAlpha && keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
-    return mAlpha[valueIndex*mKeySize + keyIndex];
+    return mAlpha[valueIndex*mKeySize + ringKeyIndex(keyIndex)];
   else
     return 255;
 }
@@ -24742,6 +26082,8 @@ void QCPColorMapData::setSize(int keySize, int valueSize)
   {
     mKeySize = keySize;
     mValueSize = valueSize;
+    mKeyRingStart = 0;
+    mAppendedColumns = 0;
     if (mData)
       delete[] mData;
     mIsEmpty = mKeySize == 0 || mValueSize == 0;
@@ -24862,7 +26204,7 @@ void QCPColorMapData::setData(double key, double value, double z)
   int valueCell = (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5;
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
   {
-    mData[valueCell*mKeySize + keyCell] = z;
+    mData[valueCell*mKeySize + ringKeyIndex(keyCell)] = z;
     if (z < mDataBounds.lower)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
@@ -24886,7 +26228,7 @@ void QCPColorMapData::setCell(int keyIndex, int valueIndex, double z)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
   {
-    mData[valueIndex*mKeySize + keyIndex] = z;
+    mData[valueIndex*mKeySize + ringKeyIndex(keyIndex)] = z;
     if (z < mDataBounds.lower)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
@@ -24917,7 +26259,7 @@ void QCPColorMapData::setAlpha(int keyIndex, int valueIndex, unsigned char alpha
   {
     if (mAlpha || createAlpha())
     {
-      mAlpha[valueIndex*mKeySize + keyIndex] = alpha;
+      mAlpha[valueIndex*mKeySize + ringKeyIndex(keyIndex)] = alpha;
       mDataModified = true;
     }
   } else
@@ -25059,6 +26401,50 @@ void QCPColorMapData::cellToCoord(int keyIndex, int valueIndex, double *key, dou
     *value = valueIndex/(double)(mValueSize-1)*(mValueRange.upper-mValueRange.lower)+mValueRange.lower;
 }
 
+/*!
+  Scrolls the map by one cell in the key direction: The column at key index 0 is dropped, all other
+  columns move down by one key index, and \a column, which must hold \ref valueSize values ordered
+  by value index, becomes the column at key index <tt>keySize()-1</tt>. The key range (\ref
+  setKeyRange) is shifted by one cell, so the remaining columns keep their plot coordinates. If an
+  alpha map exists, the new column is fully opaque.
+  
+  The columns are stored in a ring, so this only writes the new column, independently of the key
+  size. A \ref QCPColorMap displaying this data colorizes just the appended columns on its next
+  redraw, instead of regenerating its whole map image.
+  
+  \see setCell
+*/
+void QCPColorMapData::appendKeyColumn(const double *column)
+{
+  if (mIsEmpty || !mData)
+    return;
+  
+  const int keyIndex = mKeyRingStart; // the oldest column is overwritten by the newest
+  for (int valueIndex=0; valueIndex<mValueSize; ++valueIndex)
+  {
+    const double z = column[valueIndex];
+    mData[valueIndex*mKeySize + keyIndex] = z;
+    if (z < mDataBounds.lower)
+      mDataBounds.lower = z;
+    if (z > mDataBounds.upper)
+      mDataBounds.upper = z;
+  }
+  if (mAlpha)
+  {
+    for (int valueIndex=0; valueIndex<mValueSize; ++valueIndex)
+      mAlpha[valueIndex*mKeySize + keyIndex] = 255;
+  }
+  mKeyRingStart = (mKeyRingStart+1) % mKeySize;
+  if (mAppendedColumns < mKeySize)
+    ++mAppendedColumns;
+  if (mKeySize > 1)
+  {
+    const double cellWidth = (mKeyRange.upper-mKeyRange.lower)/(double)(mKeySize-1);
+    mKeyRange.lower += cellWidth;
+    mKeyRange.upper += cellWidth;
+  }
+}
+
 /*! \internal
 
   Allocates the internal alpha map with the current data map key/value size and, if \a
@@ -25227,7 +26613,8 @@ QCPColorMap::QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mMapData(new QCPColorMapData(10, 10, QCPRange(0, 5), QCPRange(0, 5))),
   mInterpolate(true),
   mTightBoundary(false),
-  mMapImageInvalidated(true)
+  mMapImageInvalidated(true),
+  mMapImageRingStart(0)
 {
 }
 
@@ -25565,6 +26952,7 @@ void QCPColorMap::updateMapImage()
   
   const double *rawData = mMapData->mData;
   const unsigned char *rawAlpha = mMapData->mAlpha;
+  const int ringStart = mMapData->mKeyRingStart; // the image is built in key index order, i.e. starting at the oldest column of the ring
   if (keyAxis->orientation() == Qt::Horizontal)
   {
     const int lineCount = valueSize;
@@ -25573,9 +26961,16 @@ void QCPColorMap::updateMapImage()
     {
       QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
       if (rawAlpha)
-        mGradient.colorize(rawData+line*rowCount, rawAlpha+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
-      else
-        mGradient.colorize(rawData+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
+      {
+        mGradient.colorize(rawData+line*rowCount+ringStart, rawAlpha+line*rowCount+ringStart, mDataRange, pixels, rowCount-ringStart, 1, mDataScaleType==QCPAxis::stLogarithmic);
+        if (ringStart > 0)
+          mGradient.colorize(rawData+line*rowCount, rawAlpha+line*rowCount, mDataRange, pixels+rowCount-ringStart, ringStart, 1, mDataScaleType==QCPAxis::stLogarithmic);
+      } else
+      {
+        mGradient.colorize(rawData+line*rowCount+ringStart, mDataRange, pixels, rowCount-ringStart, 1, mDataScaleType==QCPAxis::stLogarithmic);
+        if (ringStart > 0)
+          mGradient.colorize(rawData+line*rowCount, mDataRange, pixels+rowCount-ringStart, ringStart, 1, mDataScaleType==QCPAxis::stLogarithmic);
+      }
     }
   } else // keyAxis->orientation() == Qt::Vertical
   {
@@ -25583,11 +26978,12 @@ void QCPColorMap::updateMapImage()
     const int rowCount = valueSize;
     for (int line=0; line<lineCount; ++line)
     {
+      const int column = (line+ringStart) % keySize;
       QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
       if (rawAlpha)
-        mGradient.colorize(rawData+line, rawAlpha+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+        mGradient.colorize(rawData+column, rawAlpha+column, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
       else
-        mGradient.colorize(rawData+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+        mGradient.colorize(rawData+column, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
     }
   }
   
@@ -25599,7 +26995,49 @@ void QCPColorMap::updateMapImage()
       mMapImage = mUndersampledMapImage.scaled(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor, Qt::IgnoreAspectRatio, Qt::FastTransformation);
   }
   mMapData->mDataModified = false;
+  mMapData->mAppendedColumns = 0;
   mMapImageInvalidated = false;
+  mMapImageRingStart = ringStart;
+}
+
+/*! \internal
+  
+  Colorizes only the columns added with \ref QCPColorMapData::appendKeyColumn since the map image
+  was last updated, writing each over the image column of the data column it replaced. The image
+  then holds the columns in ring order, which \ref draw accounts for by drawing it in two parts.
+  
+  Falls back to \ref updateMapImage if the whole map was replaced meanwhile, or if the image isn't
+  laid out one pixel per cell with the key axis horizontal.
+*/
+void QCPColorMap::updateMapImageColumns()
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis) return;
+  const int keySize = mMapData->keySize();
+  const int valueSize = mMapData->valueSize();
+  const int appended = mMapData->mAppendedColumns;
+  if (appended >= keySize || keyAxis->orientation() != Qt::Horizontal ||
+      mMapImage.width() != keySize || mMapImage.height() != valueSize)
+  {
+    updateMapImage();
+    return;
+  }
+  
+  const double *rawData = mMapData->mData;
+  const unsigned char *rawAlpha = mMapData->mAlpha;
+  QVector<QRgb> columnPixels(valueSize);
+  for (int i=0; i<appended; ++i)
+  {
+    const int column = (mMapData->mKeyRingStart-appended+i+keySize) % keySize;
+    if (rawAlpha)
+      mGradient.colorize(rawData+column, rawAlpha+column, mDataRange, columnPixels.data(), valueSize, keySize, mDataScaleType==QCPAxis::stLogarithmic);
+    else
+      mGradient.colorize(rawData+column, mDataRange, columnPixels.data(), valueSize, keySize, mDataScaleType==QCPAxis::stLogarithmic);
+    const int imageColumn = (column-mMapImageRingStart+keySize) % keySize;
+    for (int line=0; line<valueSize; ++line)
+      reinterpret_cast<QRgb*>(mMapImage.scanLine(valueSize-1-line))[imageColumn] = columnPixels.at(line);
+  }
+  mMapData->mAppendedColumns = 0;
 }
 
 /* inherits documentation from base class */
@@ -25611,6 +27049,8 @@ void QCPColorMap::draw(QCPPainter *painter)
   
   if (mMapData->mDataModified || mMapImageInvalidated)
     updateMapImage();
+  else if (mMapData->mAppendedColumns > 0)
+    updateMapImageColumns();
   
   // use buffer if painting vectorized (PDF):
   const bool useBuffer = painter->modes().testFlag(QCPPainter::pmVectorized);
@@ -25659,7 +27099,24 @@ void QCPColorMap::draw(QCPPainter *painter)
                                   coordsToPixels(mMapData->keyRange().upper, mMapData->valueRange().upper)).normalized();
     localPainter->setClipRect(tightClipRect, Qt::IntersectClip);
   }
-  localPainter->drawImage(imageRect, mMapImage.mirrored(mirrorX, mirrorY));
+  const int imageSplit = (mMapData->mKeyRingStart-mMapImageRingStart+mMapData->keySize()) % qMax(1, mMapData->keySize()); // image column of key index 0
+  if (imageSplit == 0)
+    localPainter->drawImage(imageRect, mMapImage.mirrored(mirrorX, mirrorY));
+  else // image holds the columns in ring order (only with horizontal key axis and no oversampling, see updateMapImageColumns)
+  {
+    const QTransform transformBackup = localPainter->transform();
+    if (mirrorX || mirrorY)
+    {
+      localPainter->translate(imageRect.center());
+      localPainter->scale(mirrorX ? -1 : 1, mirrorY ? -1 : 1);
+      localPainter->translate(-imageRect.center());
+    }
+    const int keySize = mMapData->keySize();
+    const double splitX = imageRect.left()+imageRect.width()*(keySize-imageSplit)/(double)keySize;
+    localPainter->drawImage(QRectF(imageRect.left(), imageRect.top(), splitX-imageRect.left(), imageRect.height()), mMapImage, QRectF(imageSplit, 0, keySize-imageSplit, mMapImage.height()));
+    localPainter->drawImage(QRectF(splitX, imageRect.top(), imageRect.right()-splitX, imageRect.height()), mMapImage, QRectF(0, 0, imageSplit, mMapImage.height()));
+    localPainter->setTransform(transformBackup);
+  }
   if (mTightBoundary)
     localPainter->setClipRegion(clipBackup);
   localPainter->setRenderHint(QPainter::SmoothPixmapTransform, smoothBackup);
@@ -62,6 +62,10 @@
 #include <QtCore/QStack>
 #include <QtCore/QCache>
 #include <QtCore/QMargins>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <qmath.h>
 #include <limits>
 #include <algorithm>
@@ -235,6 +239,7 @@ enum PlottingHint { phNone              = 0x000 ///< <tt>0x000</tt> No hints are
                     ,phImmediateRefresh = 0x002 ///< <tt>0x002</tt> causes an immediate repaint() instead of a soft update() when QCustomPlot::replot() is called with parameter \ref QCustomPlot::rpRefreshHint.
                                                 ///<                This is set by default to prevent the plot from freezing on fast consecutive replots (e.g. user drags ranges with mouse).
                     ,phCacheLabels      = 0x004 ///< <tt>0x004</tt> axis (tick) labels will be cached as pixmaps, increasing replot performance.
+                    ,phCacheLayout      = 0x008 ///< <tt>0x008</tt> the margin and layout passes of a replot are skipped while the layout is still valid (see \ref QCustomPlot::invalidateLayout).
                   };
 Q_DECLARE_FLAGS(PlottingHints, PlottingHint)
 
@@ -530,6 +535,7 @@ public:
   virtual void donePainting() {}
   virtual void draw(QCPPainter *painter) const = 0;
   virtual void clear(const QColor &color) = 0;
+  virtual bool scroll(int dx, int dy, const QRect &rect);
   
 protected:
   // property members:
@@ -554,6 +560,7 @@ public:
   virtual QCPPainter *startPainting() Q_DECL_OVERRIDE;
   virtual void draw(QCPPainter *painter) const Q_DECL_OVERRIDE;
   void clear(const QColor &color) Q_DECL_OVERRIDE;
+  virtual bool scroll(int dx, int dy, const QRect &rect) Q_DECL_OVERRIDE;
   
 protected:
   // non-property members:
@@ -599,12 +606,14 @@ public:
   virtual void donePainting() Q_DECL_OVERRIDE;
   virtual void draw(QCPPainter *painter) const Q_DECL_OVERRIDE;
   void clear(const QColor &color) Q_DECL_OVERRIDE;
+  virtual bool scroll(int dx, int dy, const QRect &rect) Q_DECL_OVERRIDE;
   
 protected:
   // non-property members:
   QWeakPointer<QOpenGLContext> mGlContext;
   QWeakPointer<QOpenGLPaintDevice> mGlPaintDevice;
   QOpenGLFramebufferObject *mGlFrameBuffer;
+  QOpenGLFramebufferObject *mGlScrollFrameBuffer;
   
   // reimplemented virtual methods:
   virtual void reallocateBuffer() Q_DECL_OVERRIDE;
@@ -627,6 +636,7 @@ class QCP_LIB_DECL QCPLayer : public QObject
   Q_PROPERTY(QList<QCPLayerable*> children READ children)
   Q_PROPERTY(bool visible READ visible WRITE setVisible)
   Q_PROPERTY(LayerMode mode READ mode WRITE setMode)
+  Q_PROPERTY(QCPAxis* scrollAxis READ scrollAxis WRITE setScrollAxis)
   /// \endcond
 public:
   
@@ -652,10 +662,13 @@ public:
   QList<QCPLayerable*> children() const { return mChildren; }
   bool visible() const { return mVisible; }
   LayerMode mode() const { return mMode; }
+  QCPAxis *scrollAxis() const;
+  QRect scrollExposedRect() const { return mScrollExposedRect; }
   
   // setters:
   void setVisible(bool visible);
   void setMode(LayerMode mode);
+  void setScrollAxis(QCPAxis *axis);
   
   // non-virtual methods:
   void replot();
@@ -668,13 +681,18 @@ protected:
   QList<QCPLayerable*> mChildren;
   bool mVisible;
   LayerMode mMode;
+  QPointer<QCPAxis> mScrollAxis;
   
   // non-property members:
   QWeakPointer<QCPAbstractPaintBuffer> mPaintBuffer;
+  QVector<double> mScrollBounds;
+  QRect mScrollRect, mScrollExposedRect;
   
   // non-virtual methods:
   void draw(QCPPainter *painter);
   void drawToPaintBuffer();
+  bool scrollPaintBuffer();
+  void updateScrollState();
   void addChild(QCPLayerable *layerable, bool prepend);
   void removeChild(QCPLayerable *layerable);
   
@@ -1531,6 +1549,7 @@ public:
   TickStepStrategy tickStepStrategy() const { return mTickStepStrategy; }
   int tickCount() const { return mTickCount; }
   double tickOrigin() const { return mTickOrigin; }
+  int revision() const { return mRevision; }
   
   // setters:
   void setTickStepStrategy(TickStepStrategy strategy);
@@ -1546,6 +1565,9 @@ protected:
   int mTickCount;
   double mTickOrigin;
   
+  // non-property members:
+  int mRevision;
+  
   // introduced virtual methods:
   virtual double getTickStep(const QCPRange &range);
   virtual int getSubTickCount(double tickStep);
@@ -1710,7 +1732,7 @@ public:
   QCPAxisTickerText();
   
   // getters:
-  QMap<double, QString> &ticks() { return mTicks; }
+  QMap<double, QString> &ticks() { ++mRevision; return mTicks; } // the caller may modify the ticks
   int subTickCount() const { return mSubTickCount; }
   
   // setters:
@@ -2084,6 +2106,8 @@ public:
   void rescale(bool onlyVisiblePlottables=false);
   double pixelToCoord(double value) const;
   double coordToPixel(double value) const;
+  void coordsToPixels(const double *coords, double *pixels, int count, int stride=1) const;
+  void pixelTransform(double *scale, double *offset) const;
   SelectablePart getPartAt(const QPointF &pos) const;
   QList<QCPAbstractPlottable*> plottables() const;
   QList<QCPGraph*> graphs() const;
@@ -2144,6 +2168,7 @@ protected:
   QVector<double> mTickVector;
   QVector<QString> mTickVectorLabels;
   QVector<double> mSubTickVector;
+  QByteArray mTickVectorHash; // parameters the tick vectors were generated with, to skip regenerating them if unchanged
   bool mCachedMarginValid;
   int mCachedMargin;
   
@@ -2160,6 +2185,7 @@ protected:
   
   // non-virtual methods:
   void setupTickVectors();
+  QByteArray generateTickVectorHash() const;
   QPen getBasePen() const;
   QPen getTickPen() const;
   QPen getSubTickPen() const;
@@ -2193,6 +2219,9 @@ public:
   virtual int size() const;
   void clearCache();
   
+  static int labelCacheSize();
+  static void setLabelCacheSize(int bytes);
+  
   QRect axisSelectionBox() const { return mAxisSelectionBox; }
   QRect tickLabelsSelectionBox() const { return mTickLabelsSelectionBox; }
   QRect labelSelectionBox() const { return mLabelSelectionBox; }
@@ -2236,10 +2265,11 @@ protected:
     QFont baseFont, expFont;
   };
   QCustomPlot *mParentPlot;
-  QByteArray mLabelParameterHash; // to determine whether mLabelCache needs to be cleared due to changed parameters
-  QCache<QString, CachedLabel> mLabelCache;
+  QByteArray mLabelParameterHash; // prefix of this axis' keys in the shared label cache, changes with the label parameters
   QRect mAxisSelectionBox, mTickLabelsSelectionBox, mLabelSelectionBox;
   
+  static QCache<QString, CachedLabel> &labelCache();
+  QString labelCacheKey(const QString &text) const;
   virtual QByteArray generateLabelParameterHash() const;
   
   virtual void placeTickLabel(QCPPainter *painter, double position, int distanceToAxis, const QString &text, QSize *tickLabelsSize);
@@ -2380,12 +2410,14 @@ public:
   QCPDataContainer();
   
   // getters:
-  int size() const { return mData.size()-mPreallocSize; }
+  int size() const { return (mRingCapacity > 0 ? mRingEnd : mData.size())-mPreallocSize; }
   bool isEmpty() const { return size() == 0; }
   bool autoSqueeze() const { return mAutoSqueeze; }
+  int ringCapacity() const { return mRingCapacity; }
   
   // setters:
   void setAutoSqueeze(bool enabled);
+  void setRingCapacity(int capacity);
   
   // non-virtual methods:
   void set(const QCPDataContainer<DataType> &data);
@@ -2402,9 +2434,9 @@ public:
   void squeeze(bool preAllocation=true, bool postAllocation=true);
   
   const_iterator constBegin() const { return mData.constBegin()+mPreallocSize; }
-  const_iterator constEnd() const { return mData.constEnd(); }
+  const_iterator constEnd() const { return mRingCapacity > 0 ? mData.constBegin()+mRingEnd : mData.constEnd(); }
   iterator begin() { return mData.begin()+mPreallocSize; }
-  iterator end() { return mData.end(); }
+  iterator end() { return mRingCapacity > 0 ? mData.begin()+mRingEnd : mData.end(); }
   const_iterator findBegin(double sortKey, bool expandedRange=true) const;
   const_iterator findEnd(double sortKey, bool expandedRange=true) const;
   const_iterator at(int index) const { return constBegin()+qBound(0, index, size()); }
@@ -2421,10 +2453,13 @@ protected:
   QVector<DataType> mData;
   int mPreallocSize;
   int mPreallocIteration;
+  int mRingCapacity;
+  int mRingEnd;
   
   // non-virtual methods:
   void preallocateGrow(int minimumPreallocSize);
   void performAutoSqueeze();
+  void ringWrap();
 };
 
 // include implementation in header since it is a class template:
@@ -2457,6 +2492,10 @@ protected:
   \ref end). Changing data members that are not the sort key (for most data types called \a key) is
   safe from the container's perspective.
 
+  For sliding windows over real-time data, the container can be switched to a ring buffer with
+  \ref setRingCapacity. Appending in key order and removing the oldest data points (\ref
+  removeBefore) then never move or reallocate memory, see \ref setRingCapacity for details.
+
   Great care must be taken however if the sort key is modified through the non-const iterators. For
   performance reasons, the iterators don't automatically cause a re-sorting upon their
   manipulation. It is thus the responsibility of the user to leave the container in a sorted state
@@ -2569,7 +2608,9 @@ template <class DataType>
 QCPDataContainer<DataType>::QCPDataContainer() :
   mAutoSqueeze(true),
   mPreallocSize(0),
-  mPreallocIteration(0)
+  mPreallocIteration(0),
+  mRingCapacity(0),
+  mRingEnd(0)
 {
 }
 
@@ -2592,6 +2633,47 @@ void QCPDataContainer<DataType>::setAutoSqueeze(bool enabled)
   }
 }
 
+/*!
+  Turns the container into a ring buffer holding at most \a capacity data points, or back into the
+  regular container if \a capacity is 0.
+
+  The ring is stored mirrored in a block of twice the capacity: the data point in slot \e i is
+  kept both at \e i and at \e i + \a capacity. This way the data points between the oldest and the
+  newest are always contiguous in memory, so the iterators, \ref findBegin, \ref findEnd, \ref
+  keyRange and everything built on them (e.g. the drawing code of the plottables) work unchanged.
+  Adding a single data point with a key not smaller than the last one, and \ref removeBefore /
+  \ref removeAfter, are O(1) (apart from the binary search) and never move or reallocate memory.
+  When the ring is full, adding a data point drops the oldest one.
+
+  All other modifications are still possible but temporarily convert the container to the regular
+  layout, which costs O(n). Data points must not be modified through the non-const iterators
+  while in ring mode, since that would only update one of the two copies.
+
+  If the current data doesn't fit into \a capacity, only the newest data points are kept.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::setRingCapacity(int capacity)
+{
+  capacity = qMax(0, capacity);
+  QVector<DataType> live = mData.mid(mPreallocSize, size());
+  mRingCapacity = capacity;
+  mPreallocSize = 0;
+  mPreallocIteration = 0;
+  mRingEnd = 0;
+  if (capacity == 0)
+  {
+    mData = live;
+    return;
+  }
+  
+  if (live.size() > capacity)
+    live.remove(0, live.size()-capacity);
+  mData = QVector<DataType>(2*capacity);
+  std::copy(live.constBegin(), live.constEnd(), mData.begin());
+  std::copy(live.constBegin(), live.constEnd(), mData.begin()+capacity);
+  mRingEnd = live.size();
+}
+
 /*! \overload
   
   Replaces the current data in this container with the provided \a data.
@@ -2617,6 +2699,14 @@ void QCPDataContainer<DataType>::set(const QCPDataContainer<DataType> &data)
 template <class DataType>
 void QCPDataContainer<DataType>::set(const QVector<DataType> &data, bool alreadySorted)
 {
+  if (mRingCapacity > 0)
+  {
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    set(data, alreadySorted);
+    setRingCapacity(capacity);
+    return;
+  }
   mData = data;
   mPreallocSize = 0;
   mPreallocIteration = 0;
@@ -2635,6 +2725,14 @@ void QCPDataContainer<DataType>::add(const QCPDataContainer<DataType> &data)
 {
   if (data.isEmpty())
     return;
+  if (mRingCapacity > 0)
+  {
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    add(data);
+    setRingCapacity(capacity);
+    return;
+  }
   
   const int n = data.size();
   const int oldSize = size();
@@ -2667,6 +2765,14 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
 {
   if (data.isEmpty())
     return;
+  if (mRingCapacity > 0)
+  {
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    add(data, alreadySorted);
+    setRingCapacity(capacity);
+    return;
+  }
   if (isEmpty())
   {
     set(data, alreadySorted);
@@ -2702,6 +2808,28 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
 template <class DataType>
 void QCPDataContainer<DataType>::add(const DataType &data)
 {
+  if (mRingCapacity > 0)
+  {
+    if (isEmpty() || !qcpLessThanSortKey<DataType>(data, *(constEnd()-1))) // append, overwriting the oldest data point if full
+    {
+      if (size() == mRingCapacity)
+      {
+        ++mPreallocSize;
+        ringWrap();
+      }
+      const int slot = mRingEnd < mRingCapacity ? mRingEnd : mRingEnd-mRingCapacity;
+      mData[slot] = data;
+      mData[slot+mRingCapacity] = data;
+      ++mRingEnd;
+      return;
+    }
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    add(data);
+    setRingCapacity(capacity);
+    return;
+  }
+  
   if (isEmpty() || !qcpLessThanSortKey<DataType>(data, *(constEnd()-1))) // quickly handle appends if new data key is greater or equal to existing ones
   {
     mData.append(data);
@@ -2726,6 +2854,12 @@ void QCPDataContainer<DataType>::add(const DataType &data)
 template <class DataType>
 void QCPDataContainer<DataType>::removeBefore(double sortKey)
 {
+  if (mRingCapacity > 0)
+  {
+    mPreallocSize += std::lower_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>)-constBegin();
+    ringWrap();
+    return;
+  }
   QCPDataContainer<DataType>::iterator it = begin();
   QCPDataContainer<DataType>::iterator itEnd = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
   mPreallocSize += itEnd-it; // don't actually delete, just add it to the preallocated block (if it gets too large, squeeze will take care of it)
@@ -2741,6 +2875,11 @@ void QCPDataContainer<DataType>::removeBefore(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::removeAfter(double sortKey)
 {
+  if (mRingCapacity > 0)
+  {
+    mRingEnd = std::upper_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>)-mData.constBegin();
+    return;
+  }
   QCPDataContainer<DataType>::iterator it = std::upper_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
   QCPDataContainer<DataType>::iterator itEnd = end();
   mData.erase(it, itEnd); // typically adds it to the postallocated block
@@ -2760,6 +2899,14 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
 {
   if (sortKeyFrom >= sortKeyTo || isEmpty())
     return;
+  if (mRingCapacity > 0)
+  {
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    remove(sortKeyFrom, sortKeyTo);
+    setRingCapacity(capacity);
+    return;
+  }
   
   QCPDataContainer<DataType>::iterator it = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKeyFrom), qcpLessThanSortKey<DataType>);
   QCPDataContainer<DataType>::iterator itEnd = std::upper_bound(it, end(), DataType::fromSortKey(sortKeyTo), qcpLessThanSortKey<DataType>);
@@ -2780,6 +2927,14 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
 template <class DataType>
 void QCPDataContainer<DataType>::remove(double sortKey)
 {
+  if (mRingCapacity > 0)
+  {
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    remove(sortKey);
+    setRingCapacity(capacity);
+    return;
+  }
   QCPDataContainer::iterator it = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
   if (it != end() && it->sortKey() == sortKey)
   {
@@ -2800,6 +2955,12 @@ void QCPDataContainer<DataType>::remove(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::clear()
 {
+  if (mRingCapacity > 0) // keep the ring storage
+  {
+    mPreallocSize = 0;
+    mRingEnd = 0;
+    return;
+  }
   mData.clear();
   mPreallocIteration = 0;
   mPreallocSize = 0;
@@ -2819,6 +2980,14 @@ void QCPDataContainer<DataType>::clear()
 template <class DataType>
 void QCPDataContainer<DataType>::sort()
 {
+  if (mRingCapacity > 0)
+  {
+    const int capacity = mRingCapacity;
+    setRingCapacity(0);
+    sort();
+    setRingCapacity(capacity);
+    return;
+  }
   std::sort(begin(), end(), qcpLessThanSortKey<DataType>);
 }
 
@@ -2835,6 +3004,8 @@ void QCPDataContainer<DataType>::sort()
 template <class DataType>
 void QCPDataContainer<DataType>::squeeze(bool preAllocation, bool postAllocation)
 {
+  if (mRingCapacity > 0) // the ring storage has a fixed size
+    return;
   if (preAllocation)
   {
     if (mPreallocSize > 0)
@@ -3179,6 +3350,8 @@ void QCPDataContainer<DataType>::preallocateGrow(int minimumPreallocSize)
 template <class DataType>
 void QCPDataContainer<DataType>::performAutoSqueeze()
 {
+  if (mRingCapacity > 0)
+    return;
   const int totalAlloc = mData.capacity();
   const int postAllocSize = totalAlloc-mData.size();
   const int usedSize = size();
@@ -3197,6 +3370,21 @@ void QCPDataContainer<DataType>::performAutoSqueeze()
   if (shrinkPreAllocation || shrinkPostAllocation)
     squeeze(shrinkPreAllocation, shrinkPostAllocation);
 }
+
+/*! \internal
+  
+  Keeps the start of the ring in the lower half of the mirrored storage. Once the oldest data point
+  has moved into the upper half, the same data points are also found one capacity earlier.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::ringWrap()
+{
+  if (mPreallocSize >= mRingCapacity)
+  {
+    mPreallocSize -= mRingCapacity;
+    mRingEnd -= mRingCapacity;
+  }
+}
 /* end of 'src/datacontainer.cpp' */
 
 
@@ -3607,6 +3795,7 @@ public:
   QCP::SelectionRectMode selectionRectMode() const { return mSelectionRectMode; }
   QCPSelectionRect *selectionRect() const { return mSelectionRect; }
   bool openGl() const { return mOpenGl; }
+  static int labelCacheSize() { return QCPAxisPainterPrivate::labelCacheSize(); }
   
   // setters:
   void setViewport(const QRect &rect);
@@ -3631,6 +3820,7 @@ public:
   void setSelectionRectMode(QCP::SelectionRectMode mode);
   void setSelectionRect(QCPSelectionRect *selectionRect);
   void setOpenGl(bool enabled, int multisampling=16);
+  static void setLabelCacheSize(int bytes);
   
   // non-property methods:
   // plottable interface:
@@ -3696,6 +3886,7 @@ public:
   QPixmap toPixmap(int width=0, int height=0, double scale=1.0);
   void toPainter(QCPPainter *painter, int width=0, int height=0);
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpRefreshHint);
+  void invalidateLayout();
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
   QCPLegend *legend;
@@ -3719,6 +3910,8 @@ signals:
   void selectionChangedByUser();
   void beforeReplot();
   void afterReplot();
+  void beforePaint();
+  void afterPaint();
   
 protected:
   // property members:
@@ -3754,6 +3947,7 @@ protected:
   QVariant mMouseEventLayerableDetails;
   bool mReplotting;
   bool mReplotQueued;
+  bool mLayoutValid;
   int mOpenGlMultisamples;
   QCP::AntialiasedElements mOpenGlAntialiasedElementsBackup;
   bool mOpenGlCacheLabelsBackup;
@@ -5085,14 +5279,15 @@ private:
 /* including file 'src/plottables/plottable-graph.h', size 8826              */
 /* commit 633339dadc92cb10c58ef3556b55570685fafb99 2016-09-13 23:54:56 +0200 */
 
-class QCP_LIB_DECL QCPGraphData
+template <typename KeyType, typename ValueType>
+class QCPGraphDataT
 {
 public:
-  QCPGraphData();
-  QCPGraphData(double key, double value);
+  QCPGraphDataT() : key(0), value(0) {}
+  QCPGraphDataT(KeyType key, ValueType value) : key(key), value(value) {}
   
   inline double sortKey() const { return key; }
-  inline static QCPGraphData fromSortKey(double sortKey) { return QCPGraphData(sortKey, 0); }
+  inline static QCPGraphDataT fromSortKey(double sortKey) { return QCPGraphDataT(KeyType(sortKey), 0); }
   inline static bool sortKeyIsMainKey() { return true; }
   
   inline double mainKey() const { return key; }
@@ -5100,8 +5295,15 @@ public:
   
   inline QCPRange valueRange() const { return QCPRange(value, value); }
   
-  double key, value;
+  KeyType key;
+  ValueType value;
 };
+
+/*! \typedef QCPGraphData
+  
+  Graph data point with double precision key and value, the data type of \ref QCPGraph.
+*/
+typedef QCPGraphDataT<double, double> QCPGraphData;
 Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
 
 
@@ -5125,6 +5327,7 @@ class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable1D<QCPGraphData>
   Q_PROPERTY(int scatterSkip READ scatterSkip WRITE setScatterSkip)
   Q_PROPERTY(QCPGraph* channelFillGraph READ channelFillGraph WRITE setChannelFillGraph)
   Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
+  Q_PROPERTY(int parallelSamplingThreshold READ parallelSamplingThreshold WRITE setParallelSamplingThreshold)
   /// \endcond
 public:
   /*!
@@ -5152,6 +5355,7 @@ public:
   int scatterSkip() const { return mScatterSkip; }
   QCPGraph *channelFillGraph() const { return mChannelFillGraph.data(); }
   bool adaptiveSampling() const { return mAdaptiveSampling; }
+  int parallelSamplingThreshold() const { return mParallelSamplingThreshold; }
   
   // setters:
   void setData(QSharedPointer<QCPGraphDataContainer> data);
@@ -5161,6 +5365,7 @@ public:
   void setScatterSkip(int skip);
   void setChannelFillGraph(QCPGraph *targetGraph);
   void setAdaptiveSampling(bool enabled);
+  void setParallelSamplingThreshold(int dataCount);
   
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
@@ -5178,6 +5383,7 @@ protected:
   int mScatterSkip;
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
+  int mParallelSamplingThreshold;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
@@ -5191,9 +5397,13 @@ protected:
   
   virtual void getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const;
   virtual void getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end) const;
+  virtual void getLineData(QVector<QCPGraphData> *lineData, const QCPDataRange &dataRange) const;
+  virtual void getScatterData(QVector<QCPGraphData> *scatterData, const QCPDataRange &dataRange) const;
   
   // non-virtual methods:
+  void sampleScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end, int beginIndex) const;
   void getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
+  QCPRange getVisibleKeyRange() const;
   void getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
   void getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
   QVector<QPointF> dataToLines(const QVector<QCPGraphData> &data) const;
@@ -5201,6 +5411,7 @@ protected:
   QVector<QPointF> dataToStepRightLines(const QVector<QCPGraphData> &data) const;
   QVector<QPointF> dataToStepCenterLines(const QVector<QCPGraphData> &data) const;
   QVector<QPointF> dataToImpulseLines(const QVector<QCPGraphData> &data) const;
+  void dataToPixels(const QCPGraphData *data, QPointF *pixels, int count) const;
   void addFillBasePoints(QVector<QPointF> *lines) const;
   void removeFillBasePoints(QVector<QPointF> *lines) const;
   QPointF lowerFillBasePoint(double lowerKey) const;
@@ -5217,6 +5428,73 @@ protected:
 };
 Q_DECLARE_METATYPE(QCPGraph::LineStyle)
 
+
+/*! \typedef QCPFloatGraphData
+  
+  Graph data point with single precision key and value, 8 instead of 16 bytes per point. This is
+  the data type of \ref QCPFloatGraph, which stores keys relative to its \ref
+  QCPFloatGraph::setKeyOrigin "key origin".
+*/
+typedef QCPGraphDataT<float, float> QCPFloatGraphData;
+Q_DECLARE_TYPEINFO(QCPFloatGraphData, Q_PRIMITIVE_TYPE);
+
+/*! \typedef QCPFloatGraphDataContainer
+  
+  Container for storing \ref QCPFloatGraphData points, sorted by \a key. This is the container in
+  which QCPFloatGraph holds its data.
+*/
+typedef QCPDataContainer<QCPFloatGraphData> QCPFloatGraphDataContainer;
+
+class QCP_LIB_DECL QCPFloatGraph : public QCPGraph
+{
+  Q_OBJECT
+  /// \cond INCLUDE_QPROPERTIES
+  Q_PROPERTY(double keyOrigin READ keyOrigin WRITE setKeyOrigin)
+  /// \endcond
+public:
+  explicit QCPFloatGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
+  virtual ~QCPFloatGraph();
+  
+  // getters:
+  QSharedPointer<QCPFloatGraphDataContainer> floatData() const { return mFloatDataContainer; }
+  double keyOrigin() const { return mKeyOrigin; }
+  
+  // setters:
+  void setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+  void setKeyOrigin(double origin);
+  
+  // non-property methods:
+  void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+  void addData(double key, double value);
+  
+  // reimplemented virtual methods:
+  virtual int dataCount() const Q_DECL_OVERRIDE;
+  virtual double dataMainKey(int index) const Q_DECL_OVERRIDE;
+  virtual double dataSortKey(int index) const Q_DECL_OVERRIDE;
+  virtual double dataMainValue(int index) const Q_DECL_OVERRIDE;
+  virtual QCPRange dataValueRange(int index) const Q_DECL_OVERRIDE;
+  virtual QPointF dataPixelPosition(int index) const Q_DECL_OVERRIDE;
+  virtual QCPDataSelection selectTestRect(const QRectF &rect, bool onlySelectable) const Q_DECL_OVERRIDE;
+  virtual int findBegin(double sortKey, bool expandedRange=true) const Q_DECL_OVERRIDE;
+  virtual int findEnd(double sortKey, bool expandedRange=true) const Q_DECL_OVERRIDE;
+  virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
+  virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const Q_DECL_OVERRIDE;
+  virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const Q_DECL_OVERRIDE;
+  
+protected:
+  // property members:
+  QSharedPointer<QCPFloatGraphDataContainer> mFloatDataContainer;
+  double mKeyOrigin;
+  
+  // reimplemented virtual methods:
+  virtual void getLineData(QVector<QCPGraphData> *lineData, const QCPDataRange &dataRange) const Q_DECL_OVERRIDE;
+  virtual void getScatterData(QVector<QCPGraphData> *scatterData, const QCPDataRange &dataRange) const Q_DECL_OVERRIDE;
+  
+  // non-virtual methods:
+  void getVisibleFloatDataBounds(QCPFloatGraphDataContainer::const_iterator &begin, QCPFloatGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
+  QCPFloatGraphData toFloatData(double key, double value) const;
+};
+
 /* end of 'src/plottables/plottable-graph.h' */
 
 
@@ -5681,6 +5959,7 @@ public:
   bool isEmpty() const { return mIsEmpty; }
   void coordToCell(double key, double value, int *keyIndex, int *valueIndex) const;
   void cellToCoord(int keyIndex, int valueIndex, double *key, double *value) const;
+  void appendKeyColumn(const double *column);
   
 protected:
   // property members:
@@ -5693,8 +5972,11 @@ protected:
   unsigned char *mAlpha;
   QCPRange mDataBounds;
   bool mDataModified;
+  int mKeyRingStart;
+  int mAppendedColumns;
   
   bool createAlpha(bool initializeOpaque=true);
+  int ringKeyIndex(int keyIndex) const { return mKeyRingStart == 0 ? keyIndex : (keyIndex+mKeyRingStart) % mKeySize; }
   
   friend class QCPColorMap;
 };
@@ -5761,10 +6043,14 @@ protected:
   QImage mMapImage, mUndersampledMapImage;
   QPixmap mLegendIcon;
   bool mMapImageInvalidated;
+  int mMapImageRingStart;
   
   // introduced virtual methods:
   virtual void updateMapImage();
   
+  // non-virtual methods:
+  void updateMapImageColumns();
+  
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
@@ -0,0 +1,211 @@
+#include "rangetimemap.h"
+#include "qcustomplot.h"
+#include <algorithm>
+
+#define RANGE_TIME_DATA_HEADROOM   (1.25)   // color scale margin above the strongest return so far
+
+RangeTimeMap::RangeTimeMap(QCPColorMap *map, double windowSeconds) :
+    mMap(map),
+    mWindow(windowSeconds),
+    mFramePeriod(0.05),
+    mMaxColumns(0),
+    mFramesPerColumn(1),
+    mRing(RANGE_TIME_RING_COLUMNS),
+    mHead(0),
+    mTail(0),
+    mDropped(0),
+    mColumnFrames(0),
+    mLastKey(0),
+    mHaveKey(false),
+    mRangeLower(0),
+    mRangeUpper(0),
+    mNewestKey(0),
+    mHaveColumn(false)
+{
+    // RANGE_TIME_RING_COLUMNS is a power of two, so the free-running indices wrap with a mask
+    mSlots = mRing.data();
+    mMask = quint32(mRing.size() - 1);
+}
+
+void RangeTimeMap::setMap(QCPColorMap *map)
+{
+    mMap = map;
+    clear();
+}
+
+void RangeTimeMap::setWindow(double seconds)
+{
+    mWindow = seconds;
+    mFramesPerColumn.store(framesPerColumn(mMaxColumns));
+    clear();
+}
+
+void RangeTimeMap::setFramePeriod(double seconds)
+{
+    mFramePeriod = seconds;
+    mFramesPerColumn.store(framesPerColumn(mMaxColumns));
+    clear();
+}
+
+void RangeTimeMap::setMaxColumns(int columns)
+{
+    mMaxColumns = qMax(0, columns);
+    int frames = framesPerColumn(mMaxColumns);
+    if (frames != mFramesPerColumn.load())
+        resample(frames);
+}
+
+int RangeTimeMap::framesPerColumn(int maxColumns) const
+{
+    int frames = qMax(1, qRound(mWindow/mFramePeriod));
+    return maxColumns > 0 ? qMax(1, (frames + maxColumns - 1)/maxColumns) : 1;
+}
+
+int RangeTimeMap::columns() const
+{
+    int frames = qMax(1, qRound(mWindow/mFramePeriod));
+    int perColumn = mFramesPerColumn.load();
+    return qMax(2, (frames + perColumn - 1)/perColumn);
+}
+
+void RangeTimeMap::clear()
+{
+    mTail.store(mHead.load());
+    mColumnFrames = 0;
+    mLastKey = 0;
+    mHaveKey = false;
+    if (mMap)
+        mMap->data()->fill(0);
+    mHaveColumn = false;
+}
+
+void RangeTimeMap::append(double key, const QVector<double> &profile, double rangeLower, double rangeUpper)
+{
+    if (profile.size() < 2)
+        return;
+    // a new geometry or a key going backwards starts the column afresh; the consumer then resets the map
+    if (mHaveKey && (key < mLastKey || profile.size() != mColumn.values.size() ||
+                     rangeLower != mColumn.rangeLower || rangeUpper != mColumn.rangeUpper))
+        mColumnFrames = 0;
+    if (mColumnFrames == 0)
+    {
+        mColumn.values.resize(profile.size());
+        std::copy(profile.constBegin(), profile.constEnd(), mColumn.values.begin());
+        mColumn.rangeLower = rangeLower;
+        mColumn.rangeUpper = rangeUpper;
+    } else
+    {
+        for (int i = 0; i < profile.size(); i++)
+            mColumn.values[i] = qMax(mColumn.values.at(i), profile.at(i));
+    }
+    mLastKey = key;
+    mHaveKey = true;
+    if (++mColumnFrames < mFramesPerColumn.load())
+        return;
+    mColumnFrames = 0;
+
+    const quint32 head = mHead.load();
+    if (head - mTail.loadAcquire() > mMask)
+    {
+        mDropped.fetchAndAddRelaxed(1);
+        return;
+    }
+    Column &slot = mSlots[head & mMask];
+    slot.key = key;
+    slot.rangeLower = mColumn.rangeLower;
+    slot.rangeUpper = mColumn.rangeUpper;
+    slot.values.resize(mColumn.values.size());     // allocates only when the bin count changes
+    std::copy(mColumn.values.constBegin(), mColumn.values.constEnd(), slot.values.begin());
+    mHead.storeRelease(head + 1);
+}
+
+void RangeTimeMap::addColumn(const Column &column)
+{
+    QCPColorMapData *data = mMap->data();
+    const int bins = column.values.size();
+    if (!mHaveColumn || column.key < mNewestKey || bins != data->valueSize() || columns() != data->keySize() ||
+        column.rangeLower != mRangeLower || column.rangeUpper != mRangeUpper)
+        reset(column.key, bins, column.rangeLower, column.rangeUpper);
+
+    data->appendKeyColumn(column.values.constData());
+    // dropped frames would let the columns drift from their keys; re-anchor the newest one
+    const double period = columnPeriod();
+    if (qAbs(data->keyRange().upper - column.key) > period/2)
+        data->setKeyRange(QCPRange(column.key - (data->keySize() - 1)*period, column.key));
+    mNewestKey = column.key;
+    mHaveColumn = true;
+
+    // the color scale only ever grows, so the map is recolorized as a whole just a few times
+    double peak = *std::max_element(column.values.constBegin(), column.values.constEnd());
+    if (peak > mMap->dataRange().upper)
+        mMap->setDataRange(QCPRange(0, peak*RANGE_TIME_DATA_HEADROOM));
+}
+
+void RangeTimeMap::reset(double key, int bins, double rangeLower, double rangeUpper)
+{
+    QCPColorMapData *data = mMap->data();
+    const int keySize = columns();
+    const double period = columnPeriod();
+    data->setSize(keySize, bins);
+    data->fill(0);
+    // the first append shifts the map by one column, which brings its newest column to key
+    data->setKeyRange(QCPRange(key - keySize*period, key - period));
+    data->setValueRange(QCPRange(rangeLower, rangeUpper));
+    mRangeLower = rangeLower;
+    mRangeUpper = rangeUpper;
+}
+
+void RangeTimeMap::resample(int framesPerColumn)
+{
+    // keeps the history across resizes: each new column takes the max of the old columns it covers
+    QCPColorMapData *data = mMap ? mMap->data() : 0;
+    if (!data || !mHaveColumn || data->isEmpty())
+    {
+        mFramesPerColumn.store(framesPerColumn);
+        return;
+    }
+    const int oldColumns = data->keySize();
+    const int bins = data->valueSize();
+    const double upper = data->keyRange().upper;
+    QVector<double> old(oldColumns*bins);
+    for (int k = 0; k < oldColumns; k++)
+        for (int v = 0; v < bins; v++)
+            old[v*oldColumns + k] = data->cell(k, v);
+
+    mFramesPerColumn.store(framesPerColumn);
+    const int newColumns = columns();
+    data->setSize(newColumns, bins);
+    for (int k = 0; k < newColumns; k++)
+    {
+        int first = int(qint64(k)*oldColumns/newColumns);
+        int last = qMax(first + 1, int(qint64(k + 1)*oldColumns/newColumns));
+        for (int v = 0; v < bins; v++)
+        {
+            const double *row = old.constData() + v*oldColumns;
+            data->setCell(k, v, *std::max_element(row + first, row + last));
+        }
+    }
+    data->setKeyRange(QCPRange(upper - (newColumns - 1)*columnPeriod(), upper));
+    data->setValueRange(QCPRange(mRangeLower, mRangeUpper));
+}
+
+void RangeTimeMap::updateAxes()
+{
+    if (!mMap || !mMap->keyAxis() || !mMap->valueAxis())
+        return;
+    QCPAxisRect *rect = mMap->keyAxis()->axisRect();
+    if (rect && rect->width() > 0 && rect->width() != mMaxColumns)
+        setMaxColumns(rect->width());
+
+    const quint32 tail = mTail.load();
+    const quint32 head = mHead.loadAcquire();
+    for (quint32 i = tail; i != head; i++)
+        addColumn(mSlots[i & mMask]);
+    mTail.storeRelease(head);
+
+    // anchored to the newest completed column, so the axes stand still while one is filling
+    double upper = mHaveColumn ? mMap->data()->keyRange().upper : mWindow;
+    mMap->keyAxis()->setRange(upper - mWindow, upper);
+    if (mRangeUpper > mRangeLower)
+        mMap->valueAxis()->setRange(mRangeLower, mRangeUpper);
+}
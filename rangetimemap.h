@@ -0,0 +1,96 @@
+#ifndef RANGETIMEMAP_H
+#define RANGETIMEMAP_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+class QCPColorMap;
+
+// Range-time map (waterfall) of the range profiles over a scrolling time window.
+//
+// The map holds no more key columns than the plot has pixels across: consecutive frames are
+// max-reduced into a column (so short returns still show), and every completed column is appended
+// as the newest key column of the color map's data (QCPColorMapData::appendKeyColumn), which
+// overwrites the oldest column of a ring. A frame therefore costs one max over the profile, a
+// completed column one column of colorizing, and the map image stays about the size it is drawn
+// at, however long the window. The key axis only moves when a column is completed, so in between
+// the plot's data layer is redrawn without a full replot. The newest column lags by up to one
+// column period (a second for 10 minutes on 600 pixels).
+//
+// Like PlotFeed, the frame path and the render tick meet in a single-producer/single-consumer
+// ring: append() only reduces frames and hands completed columns over, and updateAxes() (called
+// from the render tick) is the only place that touches the color map. It takes the columns into
+// the map, follows the width of the key axis' rect, resampling the columns when that changes the
+// number of frames per column, and keeps the axes on the window. A change in the number of range
+// bins or in the range span, or a key going backwards, starts the map afresh.
+//
+// The configuration setters and clear() touch both sides and are for the GUI thread while no
+// other thread appends.
+
+#define RANGE_TIME_RING_COLUMNS    (64)     // completed columns waiting for the render tick
+
+class RangeTimeMap
+{
+public:
+    explicit RangeTimeMap(QCPColorMap *map = 0, double windowSeconds = 600.0);
+
+    void setMap(QCPColorMap *map);
+    QCPColorMap *map() const { return mMap; }
+    void setWindow(double seconds);
+    double window() const { return mWindow; }
+    void setFramePeriod(double seconds);
+    void setMaxColumns(int columns);    // 0 for one column per frame
+    int maxColumns() const { return mMaxColumns; }
+    void clear();
+
+    // producer side
+    void append(double key, const QVector<double> &profile, double rangeLower, double rangeUpper);
+
+    // consumer side
+    void updateAxes();
+
+    quint32 droppedCount() const { return mDropped.load(); }
+
+private:
+    Q_DISABLE_COPY(RangeTimeMap)
+
+    struct Column {
+        double key;                     // of the column's newest frame
+        double rangeLower, rangeUpper;
+        QVector<double> values;
+    };
+
+    void addColumn(const Column &column);
+    void reset(double key, int bins, double rangeLower, double rangeUpper);
+    void resample(int framesPerColumn);
+    int columns() const;
+    int framesPerColumn(int maxColumns) const;
+    double columnPeriod() const { return mFramesPerColumn.load()*mFramePeriod; }
+
+    QCPColorMap *mMap;
+    double mWindow;
+    double mFramePeriod;
+    int mMaxColumns;
+    QAtomicInt mFramesPerColumn;        // set by the consumer, read by the producer
+
+    // hand-over ring of completed columns
+    QVector<Column> mRing;
+    Column *mSlots;
+    quint32 mMask;
+    QAtomicInteger<quint32> mHead;      // next slot the producer writes
+    QAtomicInteger<quint32> mTail;      // next slot the consumer reads
+    QAtomicInteger<quint32> mDropped;
+
+    // producer state
+    Column mColumn;                     // max of the frames of the column being completed
+    int mColumnFrames;
+    double mLastKey;
+    bool mHaveKey;
+
+    // consumer state
+    double mRangeLower, mRangeUpper;
+    double mNewestKey;
+    bool mHaveColumn;
+};
+
+#endif // RANGETIMEMAP_H
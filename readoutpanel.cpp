@@ -0,0 +1,151 @@
+#include "readoutpanel.h"
+#include <QLCDNumber>
+#include <QPainter>
+#include <qmath.h>
+
+#define READOUT_COLUMNS      (2)
+#define READOUT_ROW_PADDING  (4)
+
+ReadoutPanel::ReadoutPanel(QWidget *parent) :
+    QWidget(parent),
+    mPainted(false),
+    mWidgetUpdateCount(0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    hide();
+}
+
+int ReadoutPanel::addReadout(QLCDNumber *lcd, const QString &label, int precision, int digitCount,
+                             char format, bool paintable)
+{
+    Readout readout;
+    readout.lcd = lcd;
+    readout.label = label;
+    readout.key = 0;
+    readout.scale = qPow(10.0, precision);
+    readout.precision = precision;
+    readout.format = format;
+    readout.paintable = paintable;
+    readout.alarm = false;
+    readout.shown = false;
+    if (lcd && digitCount > 0)
+        lcd->setDigitCount(digitCount);
+    mReadouts.append(readout);
+    return mReadouts.size() - 1;
+}
+
+void ReadoutPanel::setValue(int id, double value)
+{
+    Readout &readout = mReadouts[id];
+    if (readout.format == 'f')
+    {
+        qint64 key = qRound64(value*readout.scale);
+        if (readout.shown && key == readout.key)
+            return;
+        readout.key = key;
+        readout.text = QString::number(value, 'f', readout.precision);
+    }
+    else
+    {
+        QString text = QString::number(value, readout.format, readout.precision);
+        if (readout.shown && text == readout.text)
+            return;
+        readout.text = text;
+    }
+    readout.shown = true;
+    mWidgetUpdateCount++;
+
+    if (drawnHere(readout))
+        update();
+    else if (readout.lcd)
+        readout.lcd->display(readout.text);
+}
+
+void ReadoutPanel::setAlarm(int id, bool alarm)
+{
+    Readout &readout = mReadouts[id];
+    if (readout.alarm == alarm)
+        return;
+    readout.alarm = alarm;
+    mWidgetUpdateCount++;
+
+    if (drawnHere(readout))
+        update();
+    else
+        applyAlarm(readout);
+}
+
+void ReadoutPanel::applyAlarm(Readout &readout)
+{
+    if (!readout.lcd)
+        return;
+    QPalette palette = readout.lcd->palette();
+    palette.setColor(QPalette::Normal, QPalette::Window, readout.alarm ? Qt::red : Qt::white);
+    readout.lcd->setAutoFillBackground(true);
+    readout.lcd->setPalette(palette);
+}
+
+void ReadoutPanel::setPainted(bool painted)
+{
+    if (painted == mPainted)
+        return;
+    mPainted = painted;
+    for (int i = 0; i < mReadouts.size(); i++)
+    {
+        Readout &readout = mReadouts[i];
+        if (!readout.paintable || !readout.lcd)
+            continue;
+        readout.lcd->setVisible(!painted);
+        if (!painted)
+        {
+            // bring the LCD up to date with what was drawn here meanwhile
+            readout.lcd->display(readout.text);
+            applyAlarm(readout);
+        }
+    }
+    setVisible(painted);
+    updateGeometry();
+}
+
+int ReadoutPanel::paintedCount() const
+{
+    int count = 0;
+    for (int i = 0; i < mReadouts.size(); i++)
+        if (mReadouts.at(i).paintable)
+            count++;
+    return count;
+}
+
+QSize ReadoutPanel::sizeHint() const
+{
+    int rows = (paintedCount() + READOUT_COLUMNS - 1)/READOUT_COLUMNS;
+    int rowHeight = fontMetrics().height() + 2*READOUT_ROW_PADDING;
+    return QSize(READOUT_COLUMNS*fontMetrics().averageCharWidth()*32, rows*rowHeight);
+}
+
+void ReadoutPanel::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    const int rowHeight = fontMetrics().height() + 2*READOUT_ROW_PADDING;
+    const int columnWidth = width()/READOUT_COLUMNS;
+    int slot = 0;
+    for (int i = 0; i < mReadouts.size(); i++)
+    {
+        const Readout &readout = mReadouts.at(i);
+        if (!readout.paintable)
+            continue;
+        QRect cell((slot % READOUT_COLUMNS)*columnWidth, (slot/READOUT_COLUMNS)*rowHeight, columnWidth, rowHeight);
+        slot++;
+
+        if (readout.alarm)
+            painter.fillRect(cell, Qt::red);
+        QRect textRect = cell.adjusted(READOUT_ROW_PADDING, 0, -READOUT_ROW_PADDING, 0);
+        painter.setPen(Qt::darkGray);
+        painter.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, readout.label);
+        painter.setPen(Qt::black);
+        painter.drawText(textRect, Qt::AlignRight | Qt::AlignVCenter, readout.text);
+    }
+}
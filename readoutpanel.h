@@ -0,0 +1,67 @@
+#ifndef READOUTPANEL_H
+#define READOUTPANEL_H
+
+#include <QWidget>
+#include <QVector>
+#include <QString>
+
+class QLCDNumber;
+
+// Numeric readouts that only touch a widget when what the user sees actually changes.
+//
+// Each readout remembers the value it last showed, rounded to its display precision, and its alarm
+// state. setValue() returns early when the rounded value is unchanged, so no string is formatted
+// and no repaint or style update is scheduled; setAlarm() only rewrites the palette on a change.
+//
+// Readouts are shown by their own QLCDNumber by default. With setPainted(true) the paintable ones
+// are drawn by this widget instead, all of them in a single paint pass, and their LCDs are hidden.
+
+class ReadoutPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ReadoutPanel(QWidget *parent = 0);
+
+    // precision is the number of decimals for format 'f', or significant digits for 'g'; a
+    // digitCount of 0 keeps the digit count set in the form
+    int addReadout(QLCDNumber *lcd, const QString &label, int precision, int digitCount = 8,
+                   char format = 'f', bool paintable = true);
+
+    void setValue(int id, double value);
+    void setAlarm(int id, bool alarm);
+    const QString &text(int id) const { return mReadouts.at(id).text; }
+
+    void setPainted(bool painted);
+    bool isPainted() const { return mPainted; }
+
+    quint64 widgetUpdateCount() const { return mWidgetUpdateCount; }
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    struct Readout {
+        QLCDNumber *lcd;
+        QString label;
+        QString text;
+        qint64 key;         // rounded value currently shown, for format 'f'
+        double scale;       // 10^precision
+        int precision;
+        char format;
+        bool paintable;
+        bool alarm;
+        bool shown;
+    };
+
+    bool drawnHere(const Readout &readout) const { return mPainted && readout.paintable; }
+    void applyAlarm(Readout &readout);
+    int paintedCount() const;
+
+    QVector<Readout> mReadouts;
+    bool mPainted;
+    quint64 mWidgetUpdateCount;
+};
+
+#endif // READOUTPANEL_H
@@ -0,0 +1,150 @@
+#include "renderscheduler.h"
+#include "qcustomplot.h"
+#include "stageprofiler.h"
+
+#define RENDER_MIN_RATE_HZ    (1.0)
+#define RENDER_MAX_RATE_HZ    (120.0)
+
+RenderScheduler::RenderScheduler(QObject *parent) :
+    QObject(parent),
+    mRate(30.0),
+    mRedrawEnabled(true),
+    mProfiler(0),
+    mReplotStart(0),
+    mPaintStart(0),
+    mFullReplotTimed(false),
+    mTickCount(0),
+    mCoalescedCount(0),
+    mFullReplotCount(0),
+    mLayerReplotCount(0)
+{
+    mTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(tick()));
+    setRate(mRate);
+}
+
+void RenderScheduler::setRate(double hz)
+{
+    mRate = qBound(RENDER_MIN_RATE_HZ, hz, RENDER_MAX_RATE_HZ);
+    mTimer.setInterval(qRound(1000.0/mRate));
+}
+
+QCPLayer *RenderScheduler::createDataLayer(QCustomPlot *plot)
+{
+    if (!plot->layer("data"))
+        plot->addLayer("data", plot->layer("main"), QCustomPlot::limAbove);
+    QCPLayer *layer = plot->layer("data");
+    layer->setMode(QCPLayer::lmBuffered);
+    for (int i = 0; i < plot->plottableCount(); i++)
+        plot->plottable(i)->setLayer(layer);
+    return layer;
+}
+
+int RenderScheduler::addPlot(QCustomPlot *plot, const UpdateFunction &update, QCPLayer *dataLayer)
+{
+    plot->setPlottingHint(QCP::phCacheLayout);
+    // full replots are queued, so they are timed by the plot's own signals
+    connect(plot, &QCustomPlot::beforeReplot, this, [this]() {
+        mReplotStart = StageProfiler::now();
+    });
+    connect(plot, &QCustomPlot::afterReplot, this, [this]() {
+        if (mProfiler)
+            mProfiler->record(StageProfiler::stReplot, StageProfiler::now() - mReplotStart);
+        mFullReplotTimed = true;
+    });
+    connect(plot, &QCustomPlot::beforePaint, this, [this]() {
+        mPaintStart = StageProfiler::now();
+    });
+    connect(plot, &QCustomPlot::afterPaint, this, [this]() {
+        if (mProfiler)
+            mProfiler->record(StageProfiler::stPaint, StageProfiler::now() - mPaintStart);
+    });
+
+    Entry entry;
+    entry.plot = plot;
+    entry.update = update;
+    entry.dataLayer = dataLayer;
+    entry.dirty = false;
+    mEntries.append(entry);
+    return mEntries.size() - 1;
+}
+
+void RenderScheduler::markDirty(QCustomPlot *plot)
+{
+    for (int i = 0; i < mEntries.size(); i++)
+    {
+        if (mEntries.at(i).plot != plot)
+            continue;
+        if (mEntries.at(i).dirty)
+            mCoalescedCount++;
+        mEntries[i].dirty = true;
+    }
+}
+
+void RenderScheduler::markAllDirty()
+{
+    for (int i = 0; i < mEntries.size(); i++)
+    {
+        if (mEntries.at(i).dirty)
+            mCoalescedCount++;
+        mEntries[i].dirty = true;
+    }
+}
+
+void RenderScheduler::start()
+{
+    mTimer.start();
+}
+
+void RenderScheduler::stop()
+{
+    mTimer.stop();
+}
+
+void RenderScheduler::axisRanges(QCustomPlot *plot, QVector<QCPRange> *ranges)
+{
+    ranges->resize(0);
+    QList<QCPAxisRect*> rects = plot->axisRects();
+    for (int i = 0; i < rects.size(); i++)
+    {
+        QList<QCPAxis*> axes = rects.at(i)->axes();
+        for (int j = 0; j < axes.size(); j++)
+            ranges->append(axes.at(j)->range());
+    }
+}
+
+void RenderScheduler::tick()
+{
+    QVector<QCPRange> ranges;
+    mTickCount++;
+    for (int i = 0; i < mEntries.size(); i++)
+    {
+        Entry &entry = mEntries[i];
+        if (!entry.dirty)
+            continue;
+        entry.dirty = false;
+        if (entry.update)
+            entry.update();
+        if (!mRedrawEnabled)
+            continue;
+
+        if (entry.dataLayer)
+        {
+            axisRanges(entry.plot, &ranges);
+            if (ranges == entry.drawnRanges)
+            {
+                // falls back to a full replot by itself if the other buffers were invalidated
+                quint64 start = StageProfiler::now();
+                mFullReplotTimed = false;
+                entry.dataLayer->replot();
+                if (mProfiler && !mFullReplotTimed)
+                    mProfiler->record(StageProfiler::stReplot, StageProfiler::now() - start);
+                mLayerReplotCount++;
+                continue;
+            }
+            entry.drawnRanges = ranges;
+        }
+        entry.plot->replot(QCustomPlot::rpQueuedReplot);
+        mFullReplotCount++;
+    }
+}
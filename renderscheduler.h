@@ -0,0 +1,99 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+class QCustomPlot;
+class QCPLayer;
+class StageProfiler;
+
+// Redraws plots at a fixed rate, independently of how fast frames arrive.
+//
+// The data path only updates its model state and marks the plots it touched as dirty. On every
+// tick the scheduler runs the update function of each dirty plot, which copies the model state
+// into the plot (data, ranges), and queues one replot with QCustomPlot::rpQueuedReplot. The
+// rendering cost is bounded by the tick rate, several frames arriving between ticks cost a
+// single redraw, and nothing on the data path needs to spin the event loop.
+//
+// A plot registered with a buffered data layer (see createDataLayer) is only repainted in full when
+// one of its axis ranges differs from the last full replot, or its paint buffers were invalidated
+// (resize, layer changes). Otherwise only the data layer is redrawn into its own buffer, and the
+// cached buffers of the background, grid, axes and titles are composed with it again. If the data
+// layer also scrolls along the key axis (QCPLayer::setScrollAxis), the full replot after a whole
+// pixel shift of the key range moves the data buffer and redraws only the new samples.
+//
+// Registered plots get the QCP::phCacheLayout hint: full replots only regenerate ticks for ranges
+// that moved, and only lay the plot out again when the viewport or an axis margin changed.
+//
+// With redrawing disabled, ticks still run the update functions, so plot models keep consuming
+// their data feeds, but nothing is replotted.
+//
+// With a profiler set, every replot of a registered plot, full or data layer only, is recorded in
+// its replot stage. A replot only renders into the paint buffers; the widget paint that puts them on
+// screen runs later from the event loop, and is timed from the plot's beforePaint/afterPaint
+// signals in the paint stage.
+
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<void()> UpdateFunction;
+
+    explicit RenderScheduler(QObject *parent = 0);
+
+    void setRate(double hz);
+    double rate() const { return mRate; }
+
+    static QCPLayer *createDataLayer(QCustomPlot *plot);   // moves the plot's plottables to a buffered layer
+
+    int addPlot(QCustomPlot *plot, const UpdateFunction &update, QCPLayer *dataLayer = 0);
+    void markDirty(QCustomPlot *plot);
+    void markAllDirty();
+
+    void setRedrawEnabled(bool enabled) { mRedrawEnabled = enabled; }
+    bool redrawEnabled() const { return mRedrawEnabled; }
+
+    void setProfiler(StageProfiler *profiler) { mProfiler = profiler; }
+    StageProfiler *profiler() const { return mProfiler; }
+
+    void start();
+    void stop();
+    bool isActive() const { return mTimer.isActive(); }
+
+    quint64 tickCount() const { return mTickCount; }
+    quint64 coalescedCount() const { return mCoalescedCount; }   // dirty marks absorbed by an earlier one
+    quint64 fullReplotCount() const { return mFullReplotCount; }
+    quint64 layerReplotCount() const { return mLayerReplotCount; }
+
+public slots:
+    void tick();
+
+private:
+    struct Entry {
+        QCustomPlot *plot;
+        UpdateFunction update;
+        QCPLayer *dataLayer;
+        QVector<QCPRange> drawnRanges;  // axis ranges at the last full replot
+        bool dirty;
+    };
+
+    static void axisRanges(QCustomPlot *plot, QVector<QCPRange> *ranges);
+
+    QTimer mTimer;
+    double mRate;
+    bool mRedrawEnabled;
+    StageProfiler *mProfiler;
+    quint64 mReplotStart;           // profiler ticks at the beforeReplot of the running full replot
+    quint64 mPaintStart;            // profiler ticks at the beforePaint of the running widget paint
+    bool mFullReplotTimed;          // set by afterReplot, so a layer replot falling back to a full one isn't counted twice
+    QVector<Entry> mEntries;
+    quint64 mTickCount;
+    quint64 mCoalescedCount;
+    quint64 mFullReplotCount;
+    quint64 mLayerReplotCount;
+};
+
+#endif // RENDERSCHEDULER_H
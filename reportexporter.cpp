@@ -0,0 +1,167 @@
+#include "reportexporter.h"
+#include "qcustomplot.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QPdfWriter>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+
+struct ReportExporter::Page
+{
+    QString fileName;
+    QCustomPlot *plot;
+    bool written;
+};
+
+// Paints one page and writes its file, off the GUI thread
+class ReportExporter::PageWriter : public QRunnable
+{
+public:
+    PageWriter(Page *page, const QSize &size, double scale, int resolution) :
+        mPage(page),
+        mSize(size),
+        mScale(scale),
+        mResolution(resolution)
+    {
+    }
+
+    void run()
+    {
+        QString suffix = QFileInfo(mPage->fileName).suffix().toLower();
+        mPage->written = (suffix == "pdf") ? writePdf() : writeImage(suffix.toLatin1());
+    }
+
+private:
+    bool writeImage(const QByteArray &format)
+    {
+        // like QCustomPlot::toPixmap, but a QImage may be painted outside the GUI thread
+        QImage image(qRound(mScale*mSize.width()), qRound(mScale*mSize.height()), QImage::Format_ARGB32_Premultiplied);
+        if (image.isNull())
+            return false;
+        image.fill(Qt::transparent);
+        {
+            QCPPainter painter(&image);
+            if (!qFuzzyCompare(mScale, 1.0))
+            {
+                if (mScale > 1.0)
+                    painter.setMode(QCPPainter::pmNonCosmetic);
+                painter.scale(mScale, mScale);
+            }
+            mPage->plot->toPainter(&painter, mSize.width(), mSize.height());
+        }
+        QSaveFile file(mPage->fileName);
+        return file.open(QIODevice::WriteOnly) && image.save(&file, format.constData()) && file.commit();
+    }
+
+    bool writePdf()
+    {
+        // same page set-up as QCustomPlot::savePdf, whose QPrinter belongs to the GUI thread
+        QSaveFile file(mPage->fileName);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+        {
+            QPdfWriter writer(&file);
+            writer.setResolution(mResolution);
+            writer.setCreator(QCoreApplication::applicationName());
+            writer.setTitle(QFileInfo(mPage->fileName).completeBaseName());
+            QPageLayout pageLayout(QPageSize(mSize, QPageSize::Point, QString(), QPageSize::ExactMatch),
+                                   QPageLayout::Portrait, QMarginsF(0, 0, 0, 0));
+            pageLayout.setMode(QPageLayout::FullPageMode);
+            writer.setPageLayout(pageLayout);
+            QCPPainter painter;
+            if (!painter.begin(&writer))
+                return false;
+            painter.setMode(QCPPainter::pmVectorized);
+            painter.setWindow(QRect(QPoint(0, 0), mSize));
+            mPage->plot->toPainter(&painter, mSize.width(), mSize.height());
+            painter.end();
+        }
+        return file.commit();
+    }
+
+    Page *mPage;
+    QSize mSize;
+    double mScale;
+    int mResolution;
+};
+
+ReportExporter::ReportExporter(QObject *parent) :
+    QObject(parent),
+    mPageSize(800, 600),
+    mScale(1.0)
+{
+}
+
+ReportExporter::~ReportExporter()
+{
+    clear();
+}
+
+void ReportExporter::setThreadCount(int count)
+{
+    mPool.setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
+
+int ReportExporter::addPage(const QString &fileName, const BuildFunction &build)
+{
+    Page *page = new Page;
+    page->fileName = fileName;
+    page->plot = new QCustomPlot;
+    page->plot->setPlottingHint(QCP::phCacheLabels, false);
+    page->written = false;
+    if (build)
+        build(page->plot);
+    mPages.append(page);
+    return mPages.size() - 1;
+}
+
+QCustomPlot *ReportExporter::page(int index) const
+{
+    return mPages.at(index)->plot;
+}
+
+bool ReportExporter::pageWritten(int index) const
+{
+    return mPages.at(index)->written;
+}
+
+void ReportExporter::clear()
+{
+    mPool.waitForDone();
+    for (int i = 0; i < mPages.size(); i++)
+    {
+        delete mPages.at(i)->plot;
+        delete mPages.at(i);
+    }
+    mPages.clear();
+}
+
+int ReportExporter::exportAll()
+{
+    if (mPages.isEmpty())
+        return 0;
+
+    // PDF pages use the screen resolution, like QCustomPlot::savePdf, so text keeps its on-screen size
+    int resolution = mPages.first()->plot->logicalDpiX();
+    // text drawing off the GUI thread is only defined where the platform's font engine supports it
+    static const bool threaded = QFontDatabase::supportsThreadedFontRendering();
+    for (int i = 0; i < mPages.size(); i++)
+    {
+        mPages.at(i)->written = false;
+        if (threaded)
+            mPool.start(new PageWriter(mPages.at(i), mPageSize, mScale, resolution));
+        else
+            PageWriter(mPages.at(i), mPageSize, mScale, resolution).run();
+    }
+    mPool.waitForDone();
+
+    int written = 0;
+    for (int i = 0; i < mPages.size(); i++)
+    {
+        if (mPages.at(i)->written)
+            written++;
+    }
+    return written;
+}
@@ -0,0 +1,64 @@
+#ifndef REPORTEXPORTER_H
+#define REPORTEXPORTER_H
+
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+class QCustomPlot;
+
+// Batch export of report pages, one plot per PNG (or other image format) or PDF file.
+//
+// addPage() creates a hidden QCustomPlot for the page and runs the caller's build function on it
+// to add graphs, data and ranges. exportAll() then paints every page on a thread pool, into its
+// own QImage or, for .pdf files, into a QPdfWriter, encodes it and writes the file atomically, and
+// returns once all pages are on disk. Pages go through the same QCustomPlot::draw and raster
+// engine as the interactive plots, so they look like the plots on screen; PDF pages are laid out
+// like QCustomPlot::savePdf.
+//
+// QCustomPlot is a QWidget, so the plots are created and deleted on the GUI thread and only the
+// painting and encoding run in the pool. That is safe because exportAll() blocks the GUI thread
+// until the pool is done, and pages are painted without the label cache shared by all plots
+// (phCacheLabels off, QCPPainter::pmNoCaching), which holds QPixmaps and is not thread-safe. Build
+// functions must not turn that hint back on, give a page pixmaps (backgrounds, QCPItemPixmap,
+// color maps) or share objects between pages. Where QFontDatabase::supportsThreadedFontRendering()
+// is false, the pages are painted one after the other on the GUI thread instead.
+
+class ReportExporter : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(QCustomPlot *plot)> BuildFunction;
+
+    explicit ReportExporter(QObject *parent = 0);
+    ~ReportExporter();
+
+    void setPageSize(const QSize &size) { mPageSize = size; }
+    QSize pageSize() const { return mPageSize; }
+    void setScale(double scale) { mScale = scale; }     // image pages only, as in QCustomPlot::savePng
+    double scale() const { return mScale; }
+    void setThreadCount(int count);
+    int threadCount() const { return mPool.maxThreadCount(); }
+
+    int addPage(const QString &fileName, const BuildFunction &build);
+    int pageCount() const { return mPages.size(); }
+    QCustomPlot *page(int index) const;
+    bool pageWritten(int index) const;
+    void clear();
+
+    int exportAll();        // blocks until every page is written, returns how many succeeded
+
+private:
+    struct Page;
+    class PageWriter;
+
+    QVector<Page*> mPages;
+    QThreadPool mPool;
+    QSize mPageSize;
+    double mScale;
+};
+
+#endif // REPORTEXPORTER_H
@@ -0,0 +1,206 @@
+#include "snapshotrenderer.h"
+#include "plotfeed.h"
+#include "qcustomplot.h"
+#include "stripchart.h"
+#include "windowextrema.h"
+#include <QAtomicInt>
+#include <QDir>
+#include <QFontDatabase>
+#include <QRunnable>
+#include <QSaveFile>
+
+#define SNAPSHOT_MIN_RATE_HZ    (0.1)
+#define SNAPSHOT_MAX_RATE_HZ    (30.0)
+#define SNAPSHOT_FRAME_PERIOD_S (0.05)
+
+struct SnapshotRenderer::Sensor
+{
+    QString name;
+    QCustomPlot *plot;
+    QCPGraph *graphs[chCount];
+    PlotFeed feeds[chCount];
+    StripChart strips[chCount];         // unused for chRangeProfile
+    WindowExtrema extrema[chCount];     // unused for chRangeProfile
+    QVector<QCPGraphData> pending[chCount];  // taken from the feeds, not yet in the plot
+    QImage image;                       // painted in place every snapshot
+    QAtomicInt writing;                 // the pool owns plot and image while set
+};
+
+// Paints one sensor's snapshot, encodes it and replaces the sensor's file, off the GUI thread
+class SnapshotRenderer::SnapshotWriter : public QRunnable
+{
+public:
+    SnapshotWriter(Sensor *sensor, const QString &fileName) :
+        mSensor(sensor),
+        mFileName(fileName)
+    {
+    }
+
+    void run()
+    {
+        // as in ReportExporter, a QImage may be painted outside the GUI thread as long as nothing
+        // else touches the plot meanwhile and the shared label cache is bypassed (phCacheLabels off)
+        QImage &image = mSensor->image;
+        image.fill(Qt::white);
+        {
+            QCPPainter painter(&image);
+            mSensor->plot->toPainter(&painter, image.width(), image.height());
+        }
+        QSaveFile file(mFileName);
+        if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG"))
+            file.commit();
+        mSensor->writing.storeRelease(0);
+    }
+
+private:
+    Sensor *mSensor;
+    QString mFileName;
+};
+
+SnapshotRenderer::SnapshotRenderer(QObject *parent) :
+    QObject(parent),
+    mRate(2.0),
+    mWindow(10.0),
+    mImageSize(800, 600),
+    mSnapshotCount(0),
+    mSkippedCount(0)
+{
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(tick()));
+    setRate(mRate);
+}
+
+SnapshotRenderer::~SnapshotRenderer()
+{
+    mTimer.stop();
+    mPool.waitForDone();
+    for (int i = 0; i < mSensors.size(); i++)
+    {
+        delete mSensors.at(i)->plot;
+        delete mSensors.at(i);
+    }
+}
+
+void SnapshotRenderer::setRate(double hz)
+{
+    mRate = qBound(SNAPSHOT_MIN_RATE_HZ, hz, SNAPSHOT_MAX_RATE_HZ);
+    mTimer.setInterval(qRound(1000.0/mRate));
+}
+
+void SnapshotRenderer::setWindow(double seconds)
+{
+    mPool.waitForDone();    // the strips change the plots' axes
+    mWindow = seconds;
+    for (int i = 0; i < mSensors.size(); i++)
+    {
+        for (int channel = chPhase; channel < chCount; channel++)
+        {
+            mSensors.at(i)->strips[channel].setWindow(seconds);
+            mSensors.at(i)->extrema[channel].setWindow(seconds);
+        }
+    }
+}
+
+int SnapshotRenderer::addSensor(const QString &name)
+{
+    static const char *const labels[chCount] = { "Range profile", "Phase", "Breathing", "Heart" };
+
+    Sensor *sensor = new Sensor;
+    sensor->name = name;
+    sensor->plot = new QCustomPlot;
+    sensor->plot->setPlottingHint(QCP::phCacheLabels, false);
+    sensor->plot->plotLayout()->clear();
+    for (int channel = 0; channel < chCount; channel++)
+    {
+        QCPAxisRect *rect = new QCPAxisRect(sensor->plot);
+        sensor->plot->plotLayout()->addElement(channel/2, channel % 2, rect);
+        rect->axis(QCPAxis::atLeft)->setLabel(labels[channel]);
+        rect->axis(QCPAxis::atBottom)->setLabel(channel == chRangeProfile ? "Range (m)" : "Time (s)");
+        QCPAxis *keyAxis = rect->axis(QCPAxis::atBottom), *valueAxis = rect->axis(QCPAxis::atLeft);
+        if (channel == chRangeProfile)
+            sensor->graphs[channel] = sensor->plot->addGraph(keyAxis, valueAxis);
+        else
+        {
+            sensor->graphs[channel] = new QCPFloatGraph(keyAxis, valueAxis);
+            sensor->strips[channel].setGraph(sensor->graphs[channel]);
+            sensor->strips[channel].setWindow(mWindow);
+            sensor->strips[channel].setSampleInterval(SNAPSHOT_FRAME_PERIOD_S);
+            sensor->extrema[channel].setWindow(mWindow);
+        }
+    }
+    mSensors.append(sensor);
+    return mSensors.size() - 1;
+}
+
+PlotFeed *SnapshotRenderer::feed(int sensor, Channel channel)
+{
+    return &mSensors.at(sensor)->feeds[channel];
+}
+
+void SnapshotRenderer::start()
+{
+    QDir().mkpath(mDirectory);
+    mTimer.start();
+}
+
+void SnapshotRenderer::stop()
+{
+    mTimer.stop();
+}
+
+void SnapshotRenderer::updatePlot(Sensor *sensor)
+{
+    QSharedPointer<QCPGraphDataContainer> profile = sensor->feeds[chRangeProfile].takeSnapshot();
+    if (profile)
+    {
+        sensor->graphs[chRangeProfile]->setData(profile);
+        sensor->graphs[chRangeProfile]->rescaleAxes();
+    }
+
+    for (int channel = chPhase; channel < chCount; channel++)
+    {
+        const QVector<QCPGraphData> &samples = sensor->pending[channel];
+        for (int i = 0; i < samples.size(); i++)
+        {
+            sensor->strips[channel].append(samples.at(i).key, samples.at(i).value);
+            sensor->extrema[channel].append(samples.at(i).key, samples.at(i).value);
+        }
+        sensor->pending[channel].resize(0);
+        sensor->strips[channel].updateKeyAxis();
+        QCPAxis *valueAxis = sensor->graphs[channel]->valueAxis();
+        double lower = valueAxis->range().lower, upper = valueAxis->range().upper;
+        if (sensor->extrema[channel].fitRange(&lower, &upper))
+            valueAxis->setRange(lower, upper);
+    }
+}
+
+void SnapshotRenderer::tick()
+{
+    // text drawing off the GUI thread is only defined where the platform's font engine supports it
+    static const bool threaded = QFontDatabase::supportsThreadedFontRendering();
+    for (int i = 0; i < mSensors.size(); i++)
+    {
+        Sensor *sensor = mSensors.at(i);
+        // the feeds are drained every tick, so they don't overflow while a snapshot is in flight
+        for (int channel = chPhase; channel < chCount; channel++)
+            sensor->feeds[channel].take(&sensor->pending[channel]);
+        if (sensor->writing.loadAcquire())
+        {
+            mSkippedCount++;
+            continue;
+        }
+
+        updatePlot(sensor);
+        if (sensor->image.size() != mImageSize)
+            sensor->image = QImage(mImageSize, QImage::Format_ARGB32_Premultiplied);
+        sensor->writing.store(1);
+        SnapshotWriter *writer = new SnapshotWriter(sensor, QDir(mDirectory).filePath(sensor->name + ".png"));
+        if (threaded)
+            mPool.start(writer);
+        else
+        {
+            writer->run();
+            delete writer;
+        }
+        mSnapshotCount++;
+    }
+}
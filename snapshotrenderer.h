@@ -0,0 +1,77 @@
+#ifndef SNAPSHOTRENDERER_H
+#define SNAPSHOTRENDERER_H
+
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+class PlotFeed;
+
+// Offscreen snapshots of the vital-signs plots for remote dashboards.
+//
+// Each sensor (bed) gets a hidden QCustomPlot laid out like the main window's four plots (range
+// profile, phase, breathing and heart waveforms) and one PlotFeed per plot for its producer to
+// fill. At the snapshot rate every sensor's feeds are drained into its plot on the GUI thread; a
+// thread pool then paints each sensor's plot into an image kept across frames, PNG-encodes it and
+// writes it atomically to <directory>/<sensor>.png, one sensor per worker. A sensor whose previous
+// snapshot is still in flight keeps its samples pending and skips the frame rather than queueing
+// up behind it.
+//
+// QCustomPlot is a QWidget, so the plots are created, fed and deleted on the GUI thread, but like
+// ReportExporter pages they are painted in the pool: while a sensor's snapshot is in flight the GUI
+// thread leaves its plot alone, and the plots don't use the shared label cache (phCacheLabels off).
+// Where QFontDatabase::supportsThreadedFontRendering() is false, the snapshots are painted and
+// written on the GUI thread instead. A headless host runs with QT_QPA_PLATFORM=offscreen and never
+// shows a window.
+
+class SnapshotRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Channel { chRangeProfile, chPhase, chBreathing, chHeart, chCount };
+
+    explicit SnapshotRenderer(QObject *parent = 0);
+    ~SnapshotRenderer();
+
+    void setRate(double hz);
+    double rate() const { return mRate; }
+    void setDirectory(const QString &directory) { mDirectory = directory; }
+    QString directory() const { return mDirectory; }
+    void setImageSize(const QSize &size) { mImageSize = size; }
+    QSize imageSize() const { return mImageSize; }
+    void setWindow(double seconds);
+
+    int addSensor(const QString &name);
+    int sensorCount() const { return mSensors.size(); }
+    PlotFeed *feed(int sensor, Channel channel);
+
+    void start();
+    void stop();
+
+    quint64 snapshotCount() const { return mSnapshotCount; }
+    quint64 skippedCount() const { return mSkippedCount; }
+
+public slots:
+    void tick();
+
+private:
+    struct Sensor;
+    class SnapshotWriter;
+
+    void updatePlot(Sensor *sensor);
+
+    QVector<Sensor*> mSensors;
+    QThreadPool mPool;
+    QTimer mTimer;
+    double mRate;
+    double mWindow;
+    QString mDirectory;
+    QSize mImageSize;
+    quint64 mSnapshotCount;
+    quint64 mSkippedCount;
+};
+
+#endif // SNAPSHOTRENDERER_H
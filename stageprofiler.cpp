@@ -0,0 +1,110 @@
+#include "stageprofiler.h"
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() :
+    mMax(0)
+{
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+        mCounts[i].store(0);
+    mMax.store(0);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    quint64 total = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+        total += mCounts[i].load();
+    return total;
+}
+
+double LatencyHistogram::quantile(double q) const
+{
+    quint64 total = count();
+    if (total == 0)
+        return 0;
+    quint64 rank = qMax(quint64(1), quint64(std::ceil(qBound(0.0, q, 1.0)*total)));
+    quint64 seen = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        seen += mCounts[i].load();
+        if (seen >= rank)
+        {
+            // the bucket middle overestimates the top value while its bucket is sparse; the max is exact
+            double middle = bucketLower(i) + (bucketWidth(i) - 1)/2.0;
+            return qMin(middle, double(max()));
+        }
+    }
+    return double(max());   // counters recorded while summing
+}
+
+quint64 LatencyHistogram::bucketLower(int bucket)
+{
+    int group = bucket >> LATENCY_SUB_BUCKET_BITS;
+    if (group == 0)
+        return quint64(bucket);
+    return quint64(LATENCY_SUB_BUCKETS + (bucket & (LATENCY_SUB_BUCKETS - 1))) << (group - 1);
+}
+
+quint64 LatencyHistogram::bucketWidth(int bucket)
+{
+    int group = bucket >> LATENCY_SUB_BUCKET_BITS;
+    return (group == 0) ? 1 : quint64(1) << (group - 1);
+}
+
+StageProfiler::StageProfiler()
+{
+    mClock.start();
+    mClockStart = now();
+}
+
+const char *StageProfiler::stageName(Stage stage)
+{
+    static const char *const names[stCount] = { "Ingest", "Sync", "Decode", "Fusion", "Handover", "Readouts", "Replot", "Paint" };
+    return (stage >= 0 && stage < stCount) ? names[stage] : "";
+}
+
+void StageProfiler::reset()
+{
+    for (int i = 0; i < stCount; i++)
+        mHistograms[i].reset();
+}
+
+double StageProfiler::microsecondsPerTick() const
+{
+    // calibrated over the whole lifetime of the profiler, so the longer it runs the more precise
+    quint64 ticks = now() - mClockStart;
+    return ticks > 0 ? mClock.nsecsElapsed()/1000.0/ticks : 0;
+}
+
+StageProfiler::Stats StageProfiler::stats(Stage stage) const
+{
+    const LatencyHistogram &histogram = mHistograms[stage];
+    double scale = microsecondsPerTick();
+    Stats result;
+    result.count = histogram.count();
+    result.p50 = histogram.quantile(0.5)*scale;
+    result.p99 = histogram.quantile(0.99)*scale;
+    result.max = histogram.max()*scale;
+    return result;
+}
+
+double StageProfiler::quantile(Stage stage, double q) const
+{
+    return mHistograms[stage].quantile(q)*microsecondsPerTick();
+}
+
+QString StageProfiler::summary() const
+{
+    QString text = QString("%1 %2 %3 %4 %5").arg("Stage", -9).arg("p50 us", 9).arg("p99 us", 9).arg("max us", 9).arg("count", 9);
+    for (int i = 0; i < stCount; i++)
+    {
+        Stats s = stats(Stage(i));
+        text += QString("\n%1 %2 %3 %4 %5").arg(stageName(Stage(i)), -9)
+                .arg(s.p50, 9, 'f', 1).arg(s.p99, 9, 'f', 1).arg(s.max, 9, 'f', 1).arg(s.count, 9);
+    }
+    return text;
+}
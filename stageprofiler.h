@@ -0,0 +1,147 @@
+#ifndef STAGEPROFILER_H
+#define STAGEPROFILER_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QString>
+#include <QtAlgorithms>
+#if defined(Q_PROCESSOR_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(Q_PROCESSOR_X86)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Latency histograms of the frame path stages, cheap enough to stay compiled in.
+//
+// A probe reads the CPU timestamp counter (a steady clock off x86) and adds the elapsed ticks to
+// the stage's histogram. Histograms are log-linear like HDR histograms: exact below 32 ticks, then
+// 32 buckets per power of two, so every value lands in a bucket less than about 3 % wide, from a
+// few ticks up to hours. Recording is a clock read, a bucket index and one counter increment
+// (bench/stageprobe measures what that costs per probe); ticks are only converted to time when
+// queried, against a QElapsedTimer running since construction.
+//
+// Each stage must be recorded from one thread at a time (all stages run on the GUI thread), which
+// lets the counters be bumped without a locked instruction. Queries only read the counters, so they
+// are lock-free and may run on any thread while probes are recording.
+//
+// Lap measures consecutive stages with one clock read each:
+//     StageProfiler::Lap lap(&profiler);
+//     ... sync ...
+//     lap.record(StageProfiler::stSync);
+//     ... decode ...
+//     lap.record(StageProfiler::stDecode);
+
+#define LATENCY_SUB_BUCKET_BITS     (5)     // 32 buckets per power of two
+#define LATENCY_SUB_BUCKETS         (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_EXPONENT        (48)    // values from 2^48 ticks (a day at 3 GHz) on share the top bucket
+#define LATENCY_BUCKET_COUNT        ((LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS)
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(quint64 value)
+    {
+        QAtomicInteger<quint32> &counter = mCounts[bucket(value)];
+        counter.store(counter.load() + 1);
+        if (value > mMax.load())
+            mMax.store(value);
+    }
+    void reset();
+
+    quint64 count() const;
+    double quantile(double q) const;    // in ticks, the middle of the bucket holding the q-quantile
+    quint64 max() const { return mMax.load(); }
+
+    static int bucket(quint64 value);
+    static quint64 bucketLower(int bucket);
+    static quint64 bucketWidth(int bucket);
+
+private:
+    QAtomicInteger<quint32> mCounts[LATENCY_BUCKET_COUNT];
+    QAtomicInteger<quint64> mMax;
+};
+
+inline int LatencyHistogram::bucket(quint64 value)
+{
+    if (value < LATENCY_SUB_BUCKETS)
+        return int(value);
+    if (value >> LATENCY_MAX_EXPONENT)
+        return LATENCY_BUCKET_COUNT - 1;
+    int shift = 63 - qCountLeadingZeroBits(value) - LATENCY_SUB_BUCKET_BITS;
+    return ((shift + 1) << LATENCY_SUB_BUCKET_BITS) + int((value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+class StageProfiler
+{
+public:
+    enum Stage { stIngest, stSync, stDecode, stFusion, stHandover, stReadouts, stReplot, stPaint, stCount };
+
+    struct Stats {
+        quint64 count;
+        double p50;         // microseconds
+        double p99;
+        double max;
+    };
+
+    StageProfiler();
+
+    static const char *stageName(Stage stage);
+
+    static quint64 now()
+    {
+#if defined(Q_PROCESSOR_X86)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void record(Stage stage, quint64 ticks) { mHistograms[stage].record(ticks); }
+    void reset();
+
+    Stats stats(Stage stage) const;
+    double quantile(Stage stage, double q) const;   // microseconds
+    QString summary() const;                        // one line per stage, for the overlay
+
+    // Records the ticks from construction to destruction
+    class Probe
+    {
+    public:
+        Probe(StageProfiler *profiler, Stage stage) : mProfiler(profiler), mStage(stage), mStart(now()) {}
+        ~Probe() { mProfiler->record(mStage, now() - mStart); }
+    private:
+        StageProfiler *mProfiler;
+        Stage mStage;
+        quint64 mStart;
+    };
+
+    // Records the ticks since construction or the previous record() into the given stage
+    class Lap
+    {
+    public:
+        explicit Lap(StageProfiler *profiler) : mProfiler(profiler), mLast(now()) {}
+        void record(Stage stage)
+        {
+            quint64 time = now();
+            mProfiler->record(stage, time - mLast);
+            mLast = time;
+        }
+        void restart() { mLast = now(); }
+    private:
+        StageProfiler *mProfiler;
+        quint64 mLast;
+    };
+
+private:
+    double microsecondsPerTick() const;
+
+    LatencyHistogram mHistograms[stCount];
+    QElapsedTimer mClock;
+    quint64 mClockStart;
+};
+
+#endif // STAGEPROFILER_H
@@ -0,0 +1,107 @@
+#include "stripchart.h"
+#include "qcustomplot.h"
+#include <cmath>
+
+#define STRIP_RING_MARGIN   (4)     // samples beyond the window, for jitter in the sample keys
+
+StripChart::StripChart(QCPGraph *graph, double windowSeconds) :
+    mGraph(graph),
+    mFloatGraph(qobject_cast<QCPFloatGraph*>(graph)),
+    mWindow(windowSeconds),
+    mSampleInterval(0),
+    mLastKey(0),
+    mHaveKey(false),
+    mPixelAligned(false)
+{
+}
+
+void StripChart::setGraph(QCPGraph *graph)
+{
+    mGraph = graph;
+    mFloatGraph = qobject_cast<QCPFloatGraph*>(graph);
+    clear();
+    updateCapacity();
+}
+
+void StripChart::setWindow(double seconds)
+{
+    mWindow = seconds;
+    if (mFloatGraph && mHaveKey)
+        mFloatGraph->floatData()->removeBefore(mLastKey - mWindow - mFloatGraph->keyOrigin());
+    else if (mGraph && mHaveKey)
+        mGraph->data()->removeBefore(mLastKey - mWindow);
+    updateCapacity();
+}
+
+void StripChart::setSampleInterval(double seconds)
+{
+    mSampleInterval = seconds;
+    updateCapacity();
+}
+
+void StripChart::updateCapacity()
+{
+    if (!mGraph)
+        return;
+    int capacity = (mSampleInterval > 0) ? qCeil(mWindow/mSampleInterval) + STRIP_RING_MARGIN : 0;
+    if (mFloatGraph)
+    {
+        if (capacity != mFloatGraph->floatData()->ringCapacity())
+            mFloatGraph->floatData()->setRingCapacity(capacity);
+    }
+    else if (capacity != mGraph->data()->ringCapacity())
+        mGraph->data()->setRingCapacity(capacity);
+}
+
+void StripChart::append(double key, double value)
+{
+    if (!mGraph)
+        return;
+    if (mHaveKey && key < mLastKey)
+        clear();
+
+    if (mFloatGraph)
+    {
+        if (!mHaveKey)
+            mFloatGraph->setKeyOrigin(key);
+        mFloatGraph->addData(key, value);
+        mFloatGraph->floatData()->removeBefore(key - mWindow - mFloatGraph->keyOrigin());
+    }
+    else
+    {
+        QCPDataContainer<QCPGraphData> *data = mGraph->data().data();
+        data->add(QCPGraphData(key, value));
+        data->removeBefore(key - mWindow);
+    }
+    mLastKey = key;
+    mHaveKey = true;
+}
+
+void StripChart::clear()
+{
+    if (mFloatGraph)
+        mFloatGraph->floatData()->clear();
+    else if (mGraph)
+        mGraph->data()->clear();
+    mLastKey = 0;
+    mHaveKey = false;
+}
+
+void StripChart::updateKeyAxis()
+{
+    QCPAxis *keyAxis = mGraph ? mGraph->keyAxis() : 0;
+    if (!keyAxis)
+        return;
+    double upper = mHaveKey ? mLastKey : mWindow;
+    if (mPixelAligned)
+    {
+        // the axis rect has no size before the first layout; align from the next update on
+        int pixels = (keyAxis->orientation() == Qt::Horizontal) ? keyAxis->axisRect()->width() : keyAxis->axisRect()->height();
+        if (pixels > 0)
+        {
+            double keyPerPixel = mWindow/pixels;
+            upper = std::ceil(upper/keyPerPixel)*keyPerPixel;
+        }
+    }
+    keyAxis->setRange(upper - mWindow, upper);
+}
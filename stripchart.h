@@ -0,0 +1,56 @@
+#ifndef STRIPCHART_H
+#define STRIPCHART_H
+
+class QCPGraph;
+class QCPFloatGraph;
+
+// Scrolling time window over a QCPGraph.
+//
+// Samples are appended to the graph's data container with a time key, and samples that fell out
+// of the window are evicted from the front, so a frame costs O(new samples) whatever the window
+// length. A key going backwards (sensor restarted, frame counter wrapped) starts a new trace.
+// updateKeyAxis() moves the key axis to the current window and is all a redraw needs.
+//
+// A QCPFloatGraph is filled through its float container, with the key origin moved to the first
+// sample of each trace so the float keys stay precise however long the session runs.
+//
+// With a sample interval set, the graph's data container is switched to a ring buffer sized to
+// the window, so neither appending nor evicting ever moves or reallocates memory.
+//
+// Pixel-aligned, the window's upper end is rounded up to a whole pixel of the axis rect, so the key
+// axis only ever moves by whole pixels. A data layer scrolling along the key axis (see
+// QCPLayer::setScrollAxis) can then move its buffer and draw just the new samples.
+
+class StripChart
+{
+public:
+    explicit StripChart(QCPGraph *graph = 0, double windowSeconds = 10.0);
+
+    void setGraph(QCPGraph *graph);
+    QCPGraph *graph() const { return mGraph; }
+    void setWindow(double seconds);
+    double window() const { return mWindow; }
+    void setSampleInterval(double seconds);     // 0 keeps the regular container
+    void setPixelAligned(bool enabled) { mPixelAligned = enabled; }
+    bool pixelAligned() const { return mPixelAligned; }
+
+    void append(double key, double value);
+    void clear();
+
+    bool isEmpty() const { return !mHaveKey; }
+    double lastKey() const { return mLastKey; }
+    void updateKeyAxis();
+
+private:
+    void updateCapacity();
+
+    QCPGraph *mGraph;
+    QCPFloatGraph *mFloatGraph;     // mGraph if it is a QCPFloatGraph, else 0
+    double mWindow;
+    double mSampleInterval;
+    double mLastKey;
+    bool mHaveKey;
+    bool mPixelAligned;
+};
+
+#endif // STRIPCHART_H
@@ -0,0 +1,136 @@
+#include "trendplottable.h"
+
+TrendPlottable::TrendPlottable(QCPAxis *keyAxis, QCPAxis *valueAxis) :
+    QCPAbstractPlottable(keyAxis, valueAxis)
+{
+    setSelectable(QCP::stNone);
+}
+
+void TrendPlottable::addData(double key, double value)
+{
+    mPyramid.append(key, float(value));
+}
+
+void TrendPlottable::clearData()
+{
+    mPyramid.clear();
+}
+
+double TrendPlottable::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+    return -1;
+}
+
+QCPRange TrendPlottable::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    foundRange = false;
+    if (mPyramid.isEmpty())
+        return QCPRange();
+    QCPRange range(mPyramid.firstKey(), mPyramid.lastKey());
+    if ((inSignDomain == QCP::sdPositive && range.lower <= 0) || (inSignDomain == QCP::sdNegative && range.upper >= 0))
+        return QCPRange();
+    foundRange = true;
+    return range;
+}
+
+QCPRange TrendPlottable::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    foundRange = false;
+    int begin = 0, end = mPyramid.size();
+    if (inKeyRange != QCPRange())
+    {
+        begin = mPyramid.lowerBound(inKeyRange.lower);
+        end = mPyramid.lowerBound(inKeyRange.upper + 1e-9*qAbs(inKeyRange.upper), begin);
+    }
+
+    float min, max;
+    if (inSignDomain == QCP::sdBoth)
+    {
+        if (!mPyramid.envelope(begin, end, &min, &max))
+            return QCPRange();
+        foundRange = true;
+        return QCPRange(min, max);
+    }
+
+    // only logarithmic axes ask for one sign; the pyramid can't answer that, scan the samples
+    QCPRange range;
+    for (int i = begin; i < end; i++)
+    {
+        double value = mPyramid.value(i);
+        if ((inSignDomain == QCP::sdPositive && value <= 0) || (inSignDomain == QCP::sdNegative && value >= 0))
+            continue;
+        if (!foundRange)
+            range = QCPRange(value, value);
+        else
+            range.expand(value);
+        foundRange = true;
+    }
+    return range;
+}
+
+void TrendPlottable::draw(QCPPainter *painter)
+{
+    if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+    const QCPRange keyRange = mKeyAxis.data()->range();
+    if (keyRange.size() <= 0 || mPyramid.isEmpty())
+        return;
+
+    const int columns = qAbs(qRound(mKeyAxis.data()->coordToPixel(keyRange.upper) - mKeyAxis.data()->coordToPixel(keyRange.lower)));
+    if (columns <= 0)
+        return;
+
+    // one sample past each edge so the line runs out of the axis rect
+    int begin = qMax(mPyramid.lowerBound(keyRange.lower) - 1, 0);
+    int end = qMin(mPyramid.lowerBound(keyRange.upper, begin) + 1, mPyramid.size());
+
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->setBrush(Qt::NoBrush);
+    if (end - begin <= 2*columns)
+        drawSamples(painter, begin, end);
+    else
+        drawEnvelopes(painter, keyRange, columns);
+}
+
+void TrendPlottable::drawSamples(QCPPainter *painter, int begin, int end)
+{
+    mLines.resize(0);
+    for (int i = begin; i < end; i++)
+        mLines.append(coordsToPixels(mPyramid.key(i), mPyramid.value(i)));
+    if (mLines.size() > 1)
+        painter->drawPolyline(mLines.constData(), mLines.size());
+}
+
+void TrendPlottable::drawEnvelopes(QCPPainter *painter, const QCPRange &keyRange, int columns)
+{
+    mColumnMins.resize(columns);
+    mColumnMaxs.resize(columns);
+    mPyramid.columnEnvelopes(keyRange.lower, keyRange.upper, columns, mColumnMins.data(), mColumnMaxs.data());
+
+    // a vertical stroke per column, joined to the next; a column without samples is a gap
+    const double width = keyRange.size()/columns;
+    mLines.resize(0);
+    for (int column = 0; column <= columns; column++)
+    {
+        if (column == columns || mColumnMins.at(column) > mColumnMaxs.at(column))
+        {
+            if (mLines.size() > 1)
+                painter->drawPolyline(mLines.constData(), mLines.size());
+            mLines.resize(0);
+            continue;
+        }
+        double key = keyRange.lower + (column + 0.5)*width;
+        mLines.append(coordsToPixels(key, mColumnMins.at(column)));
+        mLines.append(coordsToPixels(key, mColumnMaxs.at(column)));
+    }
+}
+
+void TrendPlottable::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.left(), rect.top()+rect.height()/2.0, rect.right()+5, rect.top()+rect.height()/2.0));
+}
@@ -0,0 +1,42 @@
+#ifndef TRENDPLOTTABLE_H
+#define TRENDPLOTTABLE_H
+
+#include "qcustomplot.h"
+#include "minmaxpyramid.h"
+
+// Plottable for session-long trends (a whole night at the frame rate is over half a million
+// samples per series).
+//
+// Samples go into a MinMaxPyramid instead of a QCPDataContainer. When the visible key range holds
+// more samples than twice the pixel columns it spans, each column is drawn as the vertical
+// min..max envelope of its samples, so a redraw costs O(columns*log n) whatever the session
+// length; zoomed in further, the samples themselves are drawn as a line.
+
+class TrendPlottable : public QCPAbstractPlottable
+{
+public:
+    TrendPlottable(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    const MinMaxPyramid &pyramid() const { return mPyramid; }
+    void addData(double key, double value);
+    void clearData();
+
+    virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = 0) const Q_DECL_OVERRIDE;
+    virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const Q_DECL_OVERRIDE;
+    virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth,
+                                   const QCPRange &inKeyRange = QCPRange()) const Q_DECL_OVERRIDE;
+
+protected:
+    virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
+    virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
+
+private:
+    void drawSamples(QCPPainter *painter, int begin, int end);
+    void drawEnvelopes(QCPPainter *painter, const QCPRange &keyRange, int columns);
+
+    MinMaxPyramid mPyramid;
+    QVector<float> mColumnMins, mColumnMaxs;
+    QVector<QPointF> mLines;
+};
+
+#endif // TRENDPLOTTABLE_H
@@ -0,0 +1,227 @@
+#include "vitalstracker.h"
+#include <algorithm>
+// MSVC never defines __SSE2__; SSE2 is implied on x64 and selected by /arch:SSE2 on x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRACKER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define TRACKER_CM_EPSILON       (1e-4f)
+#define TRACKER_INITIAL_RATE_VAR (1e4f)   // large enough for the first update to take the measurement
+#define TRACKER_INITIAL_SLOPE_VAR (1e2f)
+
+namespace {
+
+// One constant-velocity predict/correct step. The SSE path in VitalsTrackerBank::update performs
+// the same operations in the same order; where the compiler contracts the scalar code into fused
+// multiply-adds the two may differ in the last bits.
+inline void stepConstantVelocity(float &rate, float &slope, float &noise, float &p00, float &p01, float &p11,
+                                 float z, float info, float dt, float rateNoise, float slopeNoise)
+{
+    rate = rate + dt*slope;
+    p00 = p00 + dt*(p01 + p01 + dt*p11) + rateNoise;
+    p01 = p01 + dt*p11;
+    p11 = p11 + slopeNoise;
+
+    noise = 1.0f/info;
+    float s = p00 + noise;
+    float k0 = p00/s;
+    float k1 = p01/s;
+    float innovation = z - rate;
+    rate = rate + k0*innovation;
+    slope = slope + k1*innovation;
+    p11 = p11 - k1*p01;
+    p01 = (1.0f - k0)*p01;
+    p00 = (1.0f - k0)*p00;
+}
+
+} // namespace
+
+VitalsTracker::VitalsTracker() :
+    mMode(tmOff),
+    mFrameInterval(0.05f),
+    mRateNoise(1e-3f),
+    mSlopeNoise(1e-2f)
+{
+    reset();
+}
+
+void VitalsTracker::setMode(Mode mode)
+{
+    if (mode != mMode)
+    {
+        mMode = mode;
+        reset();
+    }
+}
+
+void VitalsTracker::setProcessNoise(float rateNoise, float slopeNoise)
+{
+    mRateNoise = rateNoise;
+    mSlopeNoise = slopeNoise;
+}
+
+void VitalsTracker::reset()
+{
+    mRate = 0;
+    mSlope = 0;
+    mNoise = 0;
+    if (mMode == tmScalar)
+    {
+        // matches the former process-wide filter in processData
+        mP00 = 1;
+    }
+    else
+    {
+        mP00 = TRACKER_INITIAL_RATE_VAR;
+    }
+    mP01 = 0;
+    mP11 = TRACKER_INITIAL_SLOPE_VAR;
+}
+
+float VitalsTracker::update(const float *rates, const float *confidences, int count)
+{
+    if (count <= 0)
+        return mRate;
+
+    if (mMode == tmOff)
+    {
+        mRate = rates[0];
+        return mRate;
+    }
+
+    float info = 0, weighted = 0;
+    for (int i = 0; i < count; i++)
+    {
+        float w = std::max(confidences[i], 0.0f) + TRACKER_CM_EPSILON;
+        info += w;
+        weighted += w*rates[i];
+    }
+    float z = weighted/info;
+
+    if (mMode == tmScalar)
+    {
+        mNoise = 1.0f/info;
+        float gain = mP00/(mP00 + mNoise);
+        mRate = mRate + gain*(z - mRate);
+        mP00 = (1 - gain)*mP00 + mRateNoise;
+    }
+    else
+    {
+        stepConstantVelocity(mRate, mSlope, mNoise, mP00, mP01, mP11, z, info,
+                             mFrameInterval, mRateNoise, mSlopeNoise);
+    }
+    return mRate;
+}
+
+VitalsTrackerBank::VitalsTrackerBank(int size) :
+    mFrameInterval(0.05f),
+    mRateNoise(1e-3f),
+    mSlopeNoise(1e-2f)
+{
+    resize(size);
+}
+
+void VitalsTrackerBank::resize(int size)
+{
+    mRate.resize(size);
+    mSlope.resize(size);
+    mNoise.resize(size);
+    mP00.resize(size);
+    mP01.resize(size);
+    mP11.resize(size);
+    reset();
+}
+
+void VitalsTrackerBank::setProcessNoise(float rateNoise, float slopeNoise)
+{
+    mRateNoise = rateNoise;
+    mSlopeNoise = slopeNoise;
+}
+
+void VitalsTrackerBank::reset()
+{
+    mRate.fill(0);
+    mSlope.fill(0);
+    mNoise.fill(0);
+    mP00.fill(TRACKER_INITIAL_RATE_VAR);
+    mP01.fill(0);
+    mP11.fill(TRACKER_INITIAL_SLOPE_VAR);
+}
+
+void VitalsTrackerBank::update(const float *rates, const float *confidences, int measurementCount)
+{
+    const int n = size();
+    if (measurementCount <= 0 || n == 0)
+        return;
+
+    float *rate = mRate.data();
+    float *slope = mSlope.data();
+    float *noise = mNoise.data();
+    float *p00 = mP00.data();
+    float *p01 = mP01.data();
+    float *p11 = mP11.data();
+    int i = 0;
+
+#ifdef TRACKER_USE_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 eps = _mm_set1_ps(TRACKER_CM_EPSILON);
+    const __m128 dt = _mm_set1_ps(mFrameInterval);
+    const __m128 qRate = _mm_set1_ps(mRateNoise);
+    const __m128 qSlope = _mm_set1_ps(mSlopeNoise);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 info = zero, weighted = zero;
+        for (int m = 0; m < measurementCount; m++)
+        {
+            __m128 w = _mm_add_ps(_mm_max_ps(_mm_loadu_ps(confidences + m*n + i), zero), eps);
+            info = _mm_add_ps(info, w);
+            weighted = _mm_add_ps(weighted, _mm_mul_ps(w, _mm_loadu_ps(rates + m*n + i)));
+        }
+        __m128 z = _mm_div_ps(weighted, info);
+
+        __m128 x0 = _mm_loadu_ps(rate + i);
+        __m128 x1 = _mm_loadu_ps(slope + i);
+        __m128 c00 = _mm_loadu_ps(p00 + i);
+        __m128 c01 = _mm_loadu_ps(p01 + i);
+        __m128 c11 = _mm_loadu_ps(p11 + i);
+
+        x0 = _mm_add_ps(x0, _mm_mul_ps(dt, x1));
+        c00 = _mm_add_ps(_mm_add_ps(c00, _mm_mul_ps(dt, _mm_add_ps(_mm_add_ps(c01, c01), _mm_mul_ps(dt, c11)))), qRate);
+        c01 = _mm_add_ps(c01, _mm_mul_ps(dt, c11));
+        c11 = _mm_add_ps(c11, qSlope);
+
+        __m128 r = _mm_div_ps(one, info);
+        __m128 s = _mm_add_ps(c00, r);
+        __m128 k0 = _mm_div_ps(c00, s);
+        __m128 k1 = _mm_div_ps(c01, s);
+        __m128 innovation = _mm_sub_ps(z, x0);
+        x0 = _mm_add_ps(x0, _mm_mul_ps(k0, innovation));
+        x1 = _mm_add_ps(x1, _mm_mul_ps(k1, innovation));
+        c11 = _mm_sub_ps(c11, _mm_mul_ps(k1, c01));
+        c01 = _mm_mul_ps(_mm_sub_ps(one, k0), c01);
+        c00 = _mm_mul_ps(_mm_sub_ps(one, k0), c00);
+
+        _mm_storeu_ps(rate + i, x0);
+        _mm_storeu_ps(slope + i, x1);
+        _mm_storeu_ps(noise + i, r);
+        _mm_storeu_ps(p00 + i, c00);
+        _mm_storeu_ps(p01 + i, c01);
+        _mm_storeu_ps(p11 + i, c11);
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        float info = 0, weighted = 0;
+        for (int m = 0; m < measurementCount; m++)
+        {
+            float w = std::max(confidences[m*n + i], 0.0f) + TRACKER_CM_EPSILON;
+            info += w;
+            weighted += w*rates[m*n + i];
+        }
+        stepConstantVelocity(rate[i], slope[i], noise[i], p00[i], p01[i], p11[i], weighted/info, info,
+                             mFrameInterval, mRateNoise, mSlopeNoise);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef VITALSTRACKER_H
+#define VITALSTRACKER_H
+
+#include <QVector>
+
+// Kalman tracker for a vital-sign rate (breaths or beats per minute).
+//
+// The state holds the rate, its rate of change and the measurement noise of the last update.
+// Each update fuses any number of estimator outputs: estimator i with confidence metric c_i gets
+// a measurement noise R_i = 1/(c_i + 1e-4), and the estimates are combined by inverse-variance
+// weighting before the correction step.
+//
+//   tmOff              the first measurement is passed through unchanged
+//   tmScalar           random-walk filter on the rate only (process noise = rate noise)
+//   tmConstantVelocity rate + rate-of-change model stepped by the frame interval
+
+class VitalsTracker
+{
+public:
+    enum Mode { tmOff, tmScalar, tmConstantVelocity };
+
+    VitalsTracker();
+
+    void setMode(Mode mode);
+    Mode mode() const { return mMode; }
+    void setFrameInterval(float seconds) { mFrameInterval = seconds; }
+    void setProcessNoise(float rateNoise, float slopeNoise);
+    void reset();
+
+    float update(const float *rates, const float *confidences, int count);
+
+    float rate() const { return mRate; }
+    float rateOfChange() const { return mSlope; }
+    float measurementNoise() const { return mNoise; }
+
+private:
+    Mode mMode;
+    float mFrameInterval;
+    float mRateNoise, mSlopeNoise;
+    float mRate, mSlope, mNoise;
+    float mP00, mP01, mP11;
+};
+
+// Structure-of-arrays set of constant-velocity trackers sharing one configuration, stepped
+// together (four at a time with SSE) when replaying recordings of many sensors.
+class VitalsTrackerBank
+{
+public:
+    explicit VitalsTrackerBank(int size = 0);
+
+    void resize(int size);
+    int size() const { return mRate.size(); }
+    void setFrameInterval(float seconds) { mFrameInterval = seconds; }
+    void setProcessNoise(float rateNoise, float slopeNoise);
+    void reset();
+
+    // rates and confidences are laid out measurement-major: value m of tracker i is at [m*size() + i]
+    void update(const float *rates, const float *confidences, int measurementCount);
+
+    const float *rates() const { return mRate.constData(); }
+    const float *ratesOfChange() const { return mSlope.constData(); }
+    const float *measurementNoise() const { return mNoise.constData(); }
+
+private:
+    float mFrameInterval;
+    float mRateNoise, mSlopeNoise;
+    QVector<float> mRate, mSlope, mNoise;
+    QVector<float> mP00, mP01, mP11;
+};
+
+#endif // VITALSTRACKER_H
@@ -0,0 +1,63 @@
+#include "windowextrema.h"
+#include <qmath.h>
+
+WindowExtrema::WindowExtrema(double windowSeconds) :
+    mWindow(qMax(windowSeconds, 0.0)),
+    mLastKey(0)
+{
+}
+
+void WindowExtrema::setWindow(double seconds)
+{
+    mWindow = qMax(seconds, 0.0);   // a negative window would evict the newest sample too
+    if (!isEmpty())
+        evictBefore(mLastKey - mWindow);
+}
+
+void WindowExtrema::append(double key, double value)
+{
+    if (!isEmpty() && key < mLastKey)
+        clear();
+
+    Sample sample = { key, value };
+    while (!mMins.empty() && mMins.back().value >= value)
+        mMins.pop_back();
+    mMins.push_back(sample);
+    while (!mMaxs.empty() && mMaxs.back().value <= value)
+        mMaxs.pop_back();
+    mMaxs.push_back(sample);
+
+    mLastKey = key;
+    evictBefore(key - mWindow);
+}
+
+void WindowExtrema::evictBefore(double key)
+{
+    // with a window >= 0 the newest sample is never evicted, so both deques stay non-empty
+    while (!mMins.empty() && mMins.front().key < key)
+        mMins.pop_front();
+    while (!mMaxs.empty() && mMaxs.front().key < key)
+        mMaxs.pop_front();
+}
+
+void WindowExtrema::clear()
+{
+    mMins.clear();
+    mMaxs.clear();
+    mLastKey = 0;
+}
+
+bool WindowExtrema::fitRange(double *lower, double *upper) const
+{
+    if (isEmpty())
+        return false;
+    double lo = min(), hi = max();
+    double span = qMax(hi - lo, 1e-6*qMax(1.0, qAbs(hi)));
+    bool outside = lo < *lower || hi > *upper;
+    bool shrunk = span < WINDOW_EXTREMA_SHRINK*(*upper - *lower);
+    if (!outside && !shrunk)
+        return false;
+    *lower = lo - WINDOW_EXTREMA_MARGIN*span;
+    *upper = hi + WINDOW_EXTREMA_MARGIN*span;
+    return true;
+}
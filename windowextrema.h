@@ -0,0 +1,48 @@
+#ifndef WINDOWEXTREMA_H
+#define WINDOWEXTREMA_H
+
+#include <deque>
+
+// Sliding-window minimum and maximum of a keyed series, for autoscaling the waveform plots.
+//
+// Two monotonic deques hold the samples that can still become the window minimum (increasing
+// values) and maximum (decreasing values); appending drops the samples a new one dominates and
+// the ones that left the window, so each sample is pushed and popped at most once (amortized O(1)).
+//
+// fitRange() applies hysteresis to an axis range: it only moves the range when the data leaves
+// it, or when the data has shrunk to a small part of it, so a steady signal keeps a steady axis.
+
+#define WINDOW_EXTREMA_MARGIN   (0.1)   // of the data span, added on both sides when refitting
+#define WINDOW_EXTREMA_SHRINK   (0.4)   // refit when the data spans less than this part of the range
+
+class WindowExtrema
+{
+public:
+    explicit WindowExtrema(double windowSeconds = 10.0);
+
+    void setWindow(double seconds);         // clamped to >= 0
+    double window() const { return mWindow; }
+
+    void append(double key, double value);
+    void clear();
+
+    bool isEmpty() const { return mMins.empty(); }
+    double min() const { return mMins.front().value; }
+    double max() const { return mMaxs.front().value; }
+
+    bool fitRange(double *lower, double *upper) const;
+
+private:
+    struct Sample {
+        double key;
+        double value;
+    };
+
+    void evictBefore(double key);
+
+    std::deque<Sample> mMins, mMaxs;
+    double mWindow;
+    double mLastKey;
+};
+
+#endif // WINDOWEXTREMA_H